@@ -32,9 +32,23 @@ static const char* LOGGER_NAME = "DBus.GLib.GLibDispatcher";
 
 using DBus::GLib::GLibDispatcher;
 
+/* What a timeout or idle source needs to know about the connection that it is for */
+struct ChannelSourceData {
+    GLibDispatcher* dispatcher;
+    GIOChannel* channel;
+};
+
+static void free_channel_source_data( gpointer data ){
+    delete static_cast<ChannelSourceData*>( data );
+}
+
 class GLibDispatcher::priv_data {
 public:
     std::map<GIOChannel*, std::shared_ptr<Connection>> m_channelToConnection;
+    /* The timeout source for the connection on each channel, if it has one */
+    std::map<GIOChannel*, guint> m_channelToTimeout;
+    /* Our slots on the connections' signal_needs_dispatch() */
+    std::vector<sigc::connection> m_needsDispatchSlots;
 };
 
 GLibDispatcher::GLibDispatcher() :
@@ -43,6 +57,16 @@ GLibDispatcher::GLibDispatcher() :
 }
 
 GLibDispatcher::~GLibDispatcher(){
+    for( sigc::connection& slot : m_priv->m_needsDispatchSlots ){
+        slot.disconnect();
+    }
+
+    for( auto const& [key,val] : m_priv->m_channelToTimeout ){
+        if( val != 0 ){
+            g_source_remove( val );
+        }
+    }
+
     for( auto const& [key,val] : m_priv->m_channelToConnection ){
         g_io_channel_unref( key );
     }
@@ -77,13 +101,23 @@ bool GLibDispatcher::add_connection( std::shared_ptr<Connection> connection ){
     m_priv->m_channelToConnection[ newChannel ] = connection;
     guint sourceId = g_io_add_watch( newChannel, G_IO_IN, &GLibDispatcher::channel_data_cb, this );
 
+    /*
+     * The connection asks for this from other threads, and whenever it has
+     * a new timer.  Either way, dispatch it from the main context.
+     */
+    m_priv->m_needsDispatchSlots.push_back( connection->signal_needs_dispatch().connect( [this, newChannel](){
+        ChannelSourceData* data = new ChannelSourceData{ this, newChannel };
+        g_idle_add_full( G_PRIORITY_DEFAULT, &GLibDispatcher::needs_dispatch_cb, data, free_channel_source_data );
+    } ) );
+
+    update_timeout( newChannel );
+
     SIMPLELOGGER_TRACE( LOGGER_NAME, "Adding connection" );
     return true;
 }
 
 gboolean GLibDispatcher::channel_has_data(GIOChannel* channel, GIOCondition condition ){
     std::shared_ptr<Connection> conn = m_priv->m_channelToConnection[ channel ];
-    DBus::DispatchStatus status;
 
     SIMPLELOGGER_TRACE( LOGGER_NAME, "channel has data" );
 
@@ -91,11 +125,67 @@ gboolean GLibDispatcher::channel_has_data(GIOChannel* channel, GIOCondition cond
         return FALSE;
     }
 
+    dispatch_channel( channel );
+
+    return TRUE;
+}
+
+void GLibDispatcher::dispatch_channel( GIOChannel* channel ){
+    std::shared_ptr<Connection> conn = m_priv->m_channelToConnection[ channel ];
+    DBus::DispatchStatus status;
+
+    if( !conn ){
+        return;
+    }
+
     do{
         status = conn->dispatch();
     }while( status != DBus::DispatchStatus::COMPLETE );
 
-    return TRUE;
+    update_timeout( channel );
+}
+
+void GLibDispatcher::update_timeout( GIOChannel* channel ){
+    std::shared_ptr<Connection> conn = m_priv->m_channelToConnection[ channel ];
+    guint& sourceId = m_priv->m_channelToTimeout[ channel ];
+    int timeout;
+
+    if( sourceId != 0 ){
+        g_source_remove( sourceId );
+        sourceId = 0;
+    }
+
+    if( !conn ){
+        return;
+    }
+
+    // Nothing else may happen on the channel, so wake up on our own for the next timeout
+    timeout = conn->next_timeout_milliseconds();
+
+    if( timeout < 0 ){
+        return;
+    }
+
+    ChannelSourceData* data = new ChannelSourceData{ this, channel };
+    sourceId = g_timeout_add_full( G_PRIORITY_DEFAULT, timeout, &GLibDispatcher::timeout_cb, data, free_channel_source_data );
+}
+
+gboolean GLibDispatcher::timeout_cb( gpointer data ){
+    ChannelSourceData* sourceData = static_cast<ChannelSourceData*>( data );
+
+    // This source is done once we return, so don't let update_timeout() remove it
+    sourceData->dispatcher->m_priv->m_channelToTimeout[ sourceData->channel ] = 0;
+    sourceData->dispatcher->dispatch_channel( sourceData->channel );
+
+    return FALSE;
+}
+
+gboolean GLibDispatcher::needs_dispatch_cb( gpointer data ){
+    ChannelSourceData* sourceData = static_cast<ChannelSourceData*>( data );
+
+    sourceData->dispatcher->dispatch_channel( sourceData->channel );
+
+    return FALSE;
 }
 
 gboolean GLibDispatcher::channel_data_cb(GIOChannel* channel, GIOCondition condition, gpointer data ){
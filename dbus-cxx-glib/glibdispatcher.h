@@ -40,6 +40,21 @@ private:
     gboolean channel_has_data(GIOChannel* channel, GIOCondition condition );
     static gboolean channel_data_cb(GIOChannel* channel, GIOCondition condition, gpointer data );
 
+    /**
+     * Dispatch the connection on the given channel until it is done, then
+     * set up a timeout for when it next needs to be dispatched.
+     */
+    void dispatch_channel( GIOChannel* channel );
+
+    /**
+     * Replace the timeout for the connection on the given channel with one
+     * for the connection's next_timeout_milliseconds(), if it has one.
+     */
+    void update_timeout( GIOChannel* channel );
+
+    static gboolean timeout_cb( gpointer data );
+    static gboolean needs_dispatch_cb( gpointer data );
+
 private:
     class priv_data;
 
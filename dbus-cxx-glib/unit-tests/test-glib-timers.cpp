@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+#include <dbus-cxx-glib.h>
+
+static GMainLoop* mainLoop;
+static bool got_last = false;
+
+static int doexit( gpointer user_data ){
+    GMainLoop* loop = static_cast<GMainLoop*>( user_data );
+    g_main_loop_quit( loop );
+    return 0;
+}
+
+static void signal_handler( std::string value ){
+    if( value == "last" ){
+        got_last = true;
+        g_main_loop_quit( mainLoop );
+    }
+}
+
+// A held back emission must go out on time even if nothing else comes in
+int main(int argc, char** argv){
+    std::shared_ptr<DBus::Dispatcher> disp;
+
+    mainLoop = g_main_loop_new( nullptr, false );
+
+    disp = DBus::GLib::GLibDispatcher::create();
+
+    std::shared_ptr<DBus::Connection> conn = disp->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Signal<void(std::string)>> signal =
+        conn->create_free_signal<void(std::string)>( "/test/signal", "test.signal.type", "Path" );
+    std::shared_ptr<DBus::SignalProxy<void(std::string)>> proxy =
+        conn->create_free_signal_proxy<void(std::string)>(
+            DBus::MatchRuleBuilder::create()
+            .set_path( "/test/signal" )
+            .set_interface( "test.signal.type" )
+            .set_member( "Path" )
+            .as_signal_match(),
+            DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( sigc::ptr_fun( signal_handler ) );
+
+    // Only the last of these goes out, once the window is up
+    signal->set_emission_policy( DBus::EmissionMode::Coalesce, std::chrono::milliseconds( 100 ) );
+    signal->emit( "first" );
+    signal->emit( "last" );
+
+    g_timeout_add( 5000, doexit, mainLoop );
+
+    g_main_loop_run( mainLoop );
+
+    g_main_loop_unref( mainLoop );
+
+    return got_last ? 0 : 1;
+}
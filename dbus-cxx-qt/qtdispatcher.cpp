@@ -21,6 +21,7 @@
 #include <QMap>
 #include <QVector>
 #include <QSocketNotifier>
+#include <QTimer>
 #include <dbus-cxx/connection.h>
 
 #include "qtdispatcher.h"
@@ -31,6 +32,10 @@ class QtDispatcher::priv_data {
 public:
     QMap<int,std::shared_ptr<DBus::Connection>> m_fdToConnection;
     QVector<std::shared_ptr<QSocketNotifier>> m_socketNotifiers;
+    /* Fires when each connection's next timeout comes, even if nothing else happens on it */
+    QMap<int,std::shared_ptr<QTimer>> m_fdToTimer;
+    /* Our slots on the connections' signal_needs_dispatch() */
+    QVector<sigc::connection> m_needsDispatchSlots;
 };
 
 QtDispatcher::QtDispatcher() :
@@ -41,7 +46,9 @@ QtDispatcher::QtDispatcher() :
 }
 
 QtDispatcher::~QtDispatcher(){
-
+    for( sigc::connection& slot : m_priv->m_needsDispatchSlots ){
+        slot.disconnect();
+    }
 }
 
 std::shared_ptr<QtDispatcher> QtDispatcher::create(){
@@ -79,10 +86,31 @@ bool QtDispatcher::add_connection( std::shared_ptr<DBus::Connection> connection
     connect( socketNotify.get(), &QSocketNotifier::activated,
              this, &QtDispatcher::activated );
 
+    std::shared_ptr<QTimer> timer = std::make_shared<QTimer>();
+    timer->setSingleShot( true );
+    m_priv->m_fdToTimer[ fd ] = timer;
+
+    connect( timer.get(), &QTimer::timeout,
+             this, [this, fd](){ dispatch_connection( fd ); } );
+
+    /*
+     * The connection asks for this from other threads, and whenever it has
+     * a new timer.  Either way, dispatch it from our thread.
+     */
+    m_priv->m_needsDispatchSlots.push_back( connection->signal_needs_dispatch().connect( [this, fd](){
+        QMetaObject::invokeMethod( this, [this, fd](){ dispatch_connection( fd ); }, ::Qt::QueuedConnection );
+    } ) );
+
+    update_timer( fd );
+
     return true;
 }
 
 void QtDispatcher::activated( int fd ){
+    dispatch_connection( fd );
+}
+
+void QtDispatcher::dispatch_connection( int fd ){
     std::shared_ptr<DBus::Connection> conn = m_priv->m_fdToConnection[ fd ];
     DBus::DispatchStatus status;
 
@@ -93,4 +121,25 @@ void QtDispatcher::activated( int fd ){
     do{
         status = conn->dispatch();
     }while( status != DBus::DispatchStatus::COMPLETE );
+
+    update_timer( fd );
+}
+
+void QtDispatcher::update_timer( int fd ){
+    std::shared_ptr<DBus::Connection> conn = m_priv->m_fdToConnection[ fd ];
+    std::shared_ptr<QTimer> timer = m_priv->m_fdToTimer[ fd ];
+    int timeout;
+
+    if( !conn || !timer ){
+        return;
+    }
+
+    // Nothing else may happen on the socket, so wake up on our own for the next timeout
+    timeout = conn->next_timeout_milliseconds();
+
+    if( timeout < 0 ){
+        timer->stop();
+    }else{
+        timer->start( timeout );
+    }
 }
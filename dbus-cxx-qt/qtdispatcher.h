@@ -48,6 +48,19 @@ public:
 private Q_SLOTS:
     void activated( int socket );
 
+private:
+    /**
+     * Dispatch the connection on the given socket until it is done, then
+     * start its timer for when it next needs to be dispatched.
+     */
+    void dispatch_connection( int fd );
+
+    /**
+     * Restart the timer for the connection on the given socket from the
+     * connection's next_timeout_milliseconds(), or stop it if there is none.
+     */
+    void update_timer( int fd );
+
 private:
     class priv_data;
 
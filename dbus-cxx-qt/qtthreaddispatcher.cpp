@@ -22,6 +22,7 @@
 #include <QMutex>
 #include <QQueue>
 #include <QMutexLocker>
+#include <atomic>
 #include <dbus-cxx/signalproxy.h>
 #include <dbus-cxx/object.h>
 
@@ -40,8 +41,10 @@ public:
     QQueue<ObjectAndMessage> m_objMessageQueue;
     QMutex m_signalHandlerMutex;
     QVector<std::shared_ptr<DBus::SignalProxyBase>> m_signalHandlers;
-    QMutex m_signalsMutex;
-    QQueue<std::shared_ptr<const SignalMessage>> m_signalsQueue;
+    std::shared_ptr<SignalQueue> m_signalsQueue = SignalQueue::create();
+    /* Set while a wakeup for the signals is pending, so a busy main loop
+     * doesn't collect one queued event per signal */
+    std::atomic<bool> m_signalsNotified{ false };
 };
 
 QtThreadDispatcher::QtThreadDispatcher() :
@@ -90,12 +93,15 @@ bool QtThreadDispatcher::remove_signal_proxy( std::shared_ptr<SignalProxyBase> h
     return false;
 }
 
-void QtThreadDispatcher::add_signal( std::shared_ptr<const SignalMessage> message ){
-    QMutexLocker lock( &m_priv->m_signalsMutex );
-
-    m_priv->m_signalsQueue.push_back( message );
+std::shared_ptr<DBus::SignalQueue> QtThreadDispatcher::signal_queue() const {
+    return m_priv->m_signalsQueue;
+}
 
-    Q_EMIT notifyMainThread();
+void QtThreadDispatcher::add_signal( std::shared_ptr<const SignalMessage> message ){
+    if( m_priv->m_signalsQueue->push( message ) &&
+        !m_priv->m_signalsNotified.exchange( true ) ){
+        Q_EMIT notifyMainThread();
+    }
 }
 
 void QtThreadDispatcher::sendMessages(){
@@ -111,12 +117,11 @@ void QtThreadDispatcher::sendMessages(){
     }
 
     {
-        QMutexLocker lock( &m_priv->m_signalsMutex );
+        std::shared_ptr<const SignalMessage> signal;
 
-        while( m_priv->m_signalsQueue.size() ){
-            std::shared_ptr<const SignalMessage> signal = m_priv->m_signalsQueue.front();
-            m_priv->m_signalsQueue.pop_front();
+        m_priv->m_signalsNotified = false;
 
+        while( ( signal = m_priv->m_signalsQueue->pop() ) ){
             for( std::shared_ptr<DBus::SignalProxyBase> proxy : m_priv->m_signalHandlers ){
                 proxy->handle_signal( signal );
             }
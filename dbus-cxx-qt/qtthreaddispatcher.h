@@ -23,6 +23,7 @@
 
 #include <dbus-cxx/threaddispatcher.h>
 #include <dbus-cxx/connection.h>
+#include <dbus-cxx/signalqueue.h>
 #include <dbus-cxx/dbus-cxx-config.h>
 #include <memory>
 #include <QObject>
@@ -47,6 +48,13 @@ public:
 
     static std::shared_ptr<QtThreadDispatcher> create();
 
+    /**
+     * The queue that signals wait in until the Qt main loop emits them.
+     * It has no limit by default; use SignalQueue::set_limit() to bound
+     * it, and SignalQueue::dropped() to see how many signals were lost.
+     */
+    std::shared_ptr<SignalQueue> signal_queue() const;
+
 Q_SIGNALS:
     void notifyMainThread();
 
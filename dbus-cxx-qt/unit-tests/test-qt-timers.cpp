@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+#include <dbus-cxx-qt.h>
+
+#include <QCoreApplication>
+#include <QTimer>
+
+static bool got_last = false;
+
+// A held back emission must go out on time even if nothing else comes in
+int main( int argc, char** argv ) {
+    QCoreApplication a(argc, argv);
+
+    std::shared_ptr<DBus::Dispatcher> dispatch = DBus::Qt::QtDispatcher::create();
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Signal<void(std::string)>> signal =
+        conn->create_free_signal<void(std::string)>( "/test/signal", "test.signal.type", "Path" );
+    std::shared_ptr<DBus::SignalProxy<void(std::string)>> proxy =
+        conn->create_free_signal_proxy<void(std::string)>(
+            DBus::MatchRuleBuilder::create()
+            .set_path( "/test/signal" )
+            .set_interface( "test.signal.type" )
+            .set_member( "Path" )
+            .as_signal_match(),
+            DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( [&a]( std::string value ){
+        if( value == "last" ){
+            got_last = true;
+            a.quit();
+        }
+    } );
+
+    // Only the last of these goes out, once the window is up
+    signal->set_emission_policy( DBus::EmissionMode::Coalesce, std::chrono::milliseconds( 100 ) );
+    signal->emit( "first" );
+    signal->emit( "last" );
+
+    QTimer::singleShot( 5000, &a, &QCoreApplication::quit );
+    a.exec();
+
+    return got_last ? 0 : 1;
+}
@@ -13,6 +13,7 @@
 #endif
 
 #include <dbus-cxx/dbus-cxx-config.h>
+#include <dbus-cxx/awaitable.h>
 #include <dbus-cxx/callmessage.h>
 #include <dbus-cxx/connection.h>
 #include <dbus-cxx/signal.h>
@@ -39,8 +40,13 @@
 #include <dbus-cxx/utility.h>
 #include <dbus-cxx/variant.h>
 #include <dbus-cxx/filedescriptor.h>
+#include <dbus-cxx/memfdbuffer.h>
 #include <dbus-cxx/simplelogger_defs.h>
 #include <dbus-cxx/standalonedispatcher.h>
+#include <dbus-cxx/pooleddispatcher.h>
+#include <dbus-cxx/callpool.h>
+#include <dbus-cxx/signalqueue.h>
+#include <dbus-cxx/server.h>
 #include <dbus-cxx/propertyproxy.h>
 #include <dbus-cxx/property.h>
 #include <dbus-cxx/multiplereturn.h>
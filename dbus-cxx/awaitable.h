@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_AWAITABLE_H
+#define DBUSCXX_AWAITABLE_H
+
+/*
+ * The library itself is built as C++17, but applications that are built
+ * with coroutine support can co_await remote calls.
+ */
+#if defined( __cpp_impl_coroutine ) && defined( __has_include )
+#if __has_include( <coroutine> )
+#define DBUS_CXX_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifdef DBUS_CXX_HAS_COROUTINES
+
+#include <dbus-cxx/callpool.h>
+#include <dbus-cxx/pendingcall.h>
+#include <coroutine>
+#include <functional>
+#include <memory>
+
+namespace DBus {
+
+/**
+ * The result of a remote call that a coroutine can co_await.
+ *
+ * The call is sent when the awaitable is co_awaited, and the coroutine is
+ * suspended until the reply comes in.  By default the coroutine is resumed
+ * on the dispatching thread of the connection, like the callback of
+ * Connection::send_with_reply_async(); use resume_on() to have it resumed
+ * on a CallPool instead.
+ *
+ * If the call fails or times out, co_await throws the error.
+ */
+template <typename T_return>
+class CallAwaitable {
+public:
+    /**
+     * Sends the call, arranging for the given callback to be called once
+     * the reply is in.  If this returns null, the callback is never called,
+     * and the result is decoded from a null PendingCall right away.
+     */
+    typedef std::function<std::shared_ptr<PendingCall>( std::function<void( std::shared_ptr<PendingCall> )> )> Starter;
+
+    /** Turns the completed call into the result of co_await */
+    typedef std::function<T_return( std::shared_ptr<PendingCall> )> Decoder;
+
+    CallAwaitable( Starter start, Decoder decode ) :
+        m_start( start ),
+        m_decode( decode ) {}
+
+    /**
+     * Resume the coroutine on the given pool instead of on the
+     * dispatching thread.
+     */
+    CallAwaitable& resume_on( std::shared_ptr<CallPool> pool ) {
+        m_pool = pool;
+        return *this;
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend( std::coroutine_handle<> handle ) {
+        std::shared_ptr<CallPool> pool = m_pool;
+        std::shared_ptr<PendingCall> pending = m_start( [this, handle, pool]( std::shared_ptr<PendingCall> call ) {
+            m_pending = call;
+
+            if( pool ) {
+                pool->submit( [handle]() {
+                    handle.resume();
+                } );
+            } else {
+                handle.resume();
+            }
+        } );
+
+        // Once the call is out, the coroutine(and we) may already be gone
+        return pending != nullptr;
+    }
+
+    T_return await_resume() {
+        return m_decode( m_pending );
+    }
+
+private:
+    Starter m_start;
+    Decoder m_decode;
+    std::shared_ptr<CallPool> m_pool;
+    std::shared_ptr<PendingCall> m_pending;
+};
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_HAS_COROUTINES */
+
+#endif /* DBUSCXX_AWAITABLE_H */
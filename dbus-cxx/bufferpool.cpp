@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "bufferpool.h"
+
+#include "dbus-cxx-private.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using DBus::priv::BufferPool;
+
+static const char* LOGGER_NAME = "DBus.priv.BufferPool";
+
+/* The smallest buffer that we will hand out */
+#define MINIMUM_SIZE_CLASS      512
+/* Default maximum number of bytes held in free buffers */
+#define DEFAULT_HIGH_WATER_MARK ( 4 * 1024 * 1024 )
+/* Default time that a free buffer may sit in the pool */
+#define DEFAULT_IDLE_TIMEOUT_MS 10000
+/* Don't look for idle buffers more often than this */
+#define TRIM_INTERVAL_MS        1000
+
+struct PooledBuffer {
+    std::vector<uint8_t> buffer;
+    std::chrono::steady_clock::time_point released;
+};
+
+class BufferPool::priv_data {
+public:
+    priv_data() :
+        m_pooledBytes( 0 ),
+        m_highWaterMark( DEFAULT_HIGH_WATER_MARK ),
+        m_idleTimeout( DEFAULT_IDLE_TIMEOUT_MS ),
+        m_lastTrim( std::chrono::steady_clock::now() )
+    {}
+
+    mutable std::mutex m_lock;
+    /* Free buffers, keyed by size class.  Most recently released buffers are at the back. */
+    std::map<size_t, std::vector<PooledBuffer>> m_freeBuffers;
+    size_t m_pooledBytes;
+    size_t m_highWaterMark;
+    std::chrono::milliseconds m_idleTimeout;
+    std::chrono::steady_clock::time_point m_lastTrim;
+};
+
+BufferPool::BufferPool() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+BufferPool::~BufferPool() {}
+
+BufferPool& BufferPool::instance() {
+    // Never destroyed, since transports may be destroyed during static destruction
+    static BufferPool* pool = new BufferPool();
+
+    return *pool;
+}
+
+size_t BufferPool::size_class( size_t size ) {
+    size_t cls = MINIMUM_SIZE_CLASS;
+
+    while( cls < size ) {
+        cls <<= 1;
+    }
+
+    return cls;
+}
+
+std::vector<uint8_t> BufferPool::acquire( size_t minimum_size ) {
+    size_t cls = size_class( minimum_size );
+    std::vector<uint8_t> retval;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+        maybe_trim_idle_buffers();
+
+        std::map<size_t, std::vector<PooledBuffer>>::iterator it =
+            m_priv->m_freeBuffers.find( cls );
+
+        if( it != m_priv->m_freeBuffers.end() && !it->second.empty() ) {
+            retval = std::move( it->second.back().buffer );
+            it->second.pop_back();
+            m_priv->m_pooledBytes -= cls;
+        }
+    }
+
+    // Don't fill in a new buffer here; the caller only pays for the bytes that it uses
+    retval.reserve( cls );
+
+    return retval;
+}
+
+void BufferPool::release( std::vector<uint8_t>&& buffer ) {
+    // A buffer is filed under the largest size class that fits within its capacity
+    size_t cls = size_class( buffer.capacity() );
+
+    if( cls > buffer.capacity() ) {
+        cls >>= 1;
+    }
+
+    if( cls < MINIMUM_SIZE_CLASS ) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    maybe_trim_idle_buffers();
+
+    if( m_priv->m_pooledBytes + cls > m_priv->m_highWaterMark ) {
+        // Let the buffer be freed when we return
+        SIMPLELOGGER_TRACE( LOGGER_NAME, "Pool is full, freeing buffer of " << cls << " bytes" );
+        return;
+    }
+
+    PooledBuffer pooled;
+    pooled.buffer = std::move( buffer );
+    pooled.released = std::chrono::steady_clock::now();
+
+    m_priv->m_freeBuffers[ cls ].push_back( std::move( pooled ) );
+    m_priv->m_pooledBytes += cls;
+}
+
+void BufferPool::set_high_water_mark( size_t bytes ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    m_priv->m_highWaterMark = bytes;
+
+    // Free the biggest buffers first until we are under the new limit
+    while( m_priv->m_pooledBytes > m_priv->m_highWaterMark ) {
+        std::map<size_t, std::vector<PooledBuffer>>::reverse_iterator it =
+            m_priv->m_freeBuffers.rbegin();
+
+        if( it->second.empty() ) {
+            m_priv->m_freeBuffers.erase( std::next( it ).base() );
+            continue;
+        }
+
+        it->second.erase( it->second.begin() );
+        m_priv->m_pooledBytes -= it->first;
+    }
+}
+
+size_t BufferPool::high_water_mark() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_highWaterMark;
+}
+
+void BufferPool::set_idle_timeout( std::chrono::milliseconds timeout ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    m_priv->m_idleTimeout = timeout;
+}
+
+std::chrono::milliseconds BufferPool::idle_timeout() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_idleTimeout;
+}
+
+size_t BufferPool::pooled_bytes() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_pooledBytes;
+}
+
+void BufferPool::clear() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    m_priv->m_freeBuffers.clear();
+    m_priv->m_pooledBytes = 0;
+}
+
+std::chrono::steady_clock::time_point BufferPool::trim() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return trim_idle_buffers();
+}
+
+void BufferPool::maybe_trim_idle_buffers() {
+    if( std::chrono::steady_clock::now() - m_priv->m_lastTrim < std::chrono::milliseconds( TRIM_INTERVAL_MS ) ) {
+        return;
+    }
+
+    trim_idle_buffers();
+}
+
+std::chrono::steady_clock::time_point BufferPool::trim_idle_buffers() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+
+    m_priv->m_lastTrim = now;
+
+    for( std::pair<const size_t, std::vector<PooledBuffer>>& sizeClass : m_priv->m_freeBuffers ) {
+        std::vector<PooledBuffer>& buffers = sizeClass.second;
+        size_t numIdle = 0;
+
+        // Buffers are in the order that they were released, so the idle ones are at the front
+        while( numIdle < buffers.size() &&
+            now - buffers[ numIdle ].released >= m_priv->m_idleTimeout ) {
+            numIdle++;
+        }
+
+        if( numIdle < buffers.size() ) {
+            next = std::min( next, buffers[ numIdle ].released + m_priv->m_idleTimeout );
+        }
+
+        if( numIdle == 0 ) {
+            continue;
+        }
+
+        SIMPLELOGGER_TRACE( LOGGER_NAME, "Freeing " << numIdle << " idle buffers of " << sizeClass.first << " bytes" );
+        buffers.erase( buffers.begin(), buffers.begin() + numIdle );
+        m_priv->m_pooledBytes -= numIdle * sizeClass.first;
+    }
+
+    return next;
+}
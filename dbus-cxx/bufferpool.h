@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_BUFFERPOOL_H
+#define DBUSCXX_BUFFERPOOL_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * A process-wide pool of byte buffers that the transports use for reading
+ * and writing messages.
+ *
+ * Buffers are handed out in power-of-two size classes.  A transport only
+ * keeps a small buffer for itself; when a large message comes in it borrows
+ * a larger buffer from the pool and gives it back once it has not been
+ * needed for idle_timeout(), so a single large message does not pin that
+ * memory for the lifetime of the connection.
+ *
+ * The pool holds on to at most high_water_mark() bytes of free buffers.
+ * Buffers that have not been used for idle_timeout() are freed by trim(),
+ * which the connections call from a timer.
+ */
+class BufferPool {
+private:
+    BufferPool();
+
+public:
+    ~BufferPool();
+
+    /**
+     * Get the pool that is shared by all of the transports.
+     */
+    static BufferPool& instance();
+
+    /**
+     * Get a buffer that can hold at least minimum_size bytes.
+     *
+     * Nothing is filled in: a new buffer is empty, and a recycled buffer
+     * still has the size and contents that it was released with.  Use
+     * resize() to get the bytes that are needed, which only fills in the
+     * bytes past the current size.
+     *
+     * @param minimum_size The number of bytes that are needed
+     * @return A buffer whose capacity() is at least minimum_size
+     */
+    std::vector<uint8_t> acquire( size_t minimum_size );
+
+    /**
+     * Give a buffer back to the pool.  If the pool is already holding
+     * high_water_mark() bytes, the buffer is freed instead.
+     *
+     * @param buffer The buffer to give back
+     */
+    void release( std::vector<uint8_t>&& buffer );
+
+    /**
+     * Set the maximum number of bytes that are kept around in free buffers.
+     * Setting this to 0 disables pooling entirely.
+     */
+    void set_high_water_mark( size_t bytes );
+
+    size_t high_water_mark() const;
+
+    /**
+     * Set how long a free buffer may go unused before it is freed.
+     */
+    void set_idle_timeout( std::chrono::milliseconds timeout );
+
+    std::chrono::milliseconds idle_timeout() const;
+
+    /** The number of bytes currently held in free buffers */
+    size_t pooled_bytes() const;
+
+    /**
+     * Free the buffers that have not been used for idle_timeout().
+     *
+     * @return When the next of the remaining buffers becomes idle, or
+     * time_point::max() if the pool is empty
+     */
+    std::chrono::steady_clock::time_point trim();
+
+    /** Free all of the buffers that the pool is holding */
+    void clear();
+
+    /**
+     * The size class that a buffer of the given size belongs in.
+     */
+    static size_t size_class( size_t size );
+
+private:
+    void maybe_trim_idle_buffers();
+    std::chrono::steady_clock::time_point trim_idle_buffers();
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_BUFFERPOOL_H */
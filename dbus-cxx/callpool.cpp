@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "callpool.h"
+
+#include "dbus-cxx-private.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using DBus::CallPool;
+
+static const char* LOGGER_NAME = "DBus.CallPool";
+
+class CallPool::Strand {
+public:
+    Strand() :
+        m_running( false )
+    {}
+
+    std::mutex m_lock;
+    std::deque<std::function<void()>> m_tasks;
+    /* True if a task from this strand is queued in the pool or running */
+    bool m_running;
+};
+
+struct PoolWorker {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+    std::thread thread;
+};
+
+class CallPool::priv_data : public std::enable_shared_from_this<CallPool::priv_data> {
+public:
+    priv_data() :
+        m_pending( 0 ),
+        m_nextWorker( 0 ),
+        m_stopping( false )
+    {}
+
+    void submit( std::function<void()> task );
+
+    void submit( std::shared_ptr<Strand> strand, std::function<void()> task );
+
+    void run_strand( std::shared_ptr<Strand> strand );
+
+    /**
+     * Take a task from the given worker's queue, or from one of the other
+     * queues if that one is empty.
+     */
+    std::function<void()> take_task( unsigned int index );
+
+    static void worker_main( std::shared_ptr<priv_data> priv, unsigned int index );
+
+    std::vector<std::unique_ptr<PoolWorker>> m_workers;
+    std::mutex m_sleepLock;
+    std::condition_variable m_sleepCv;
+    /* The number of tasks that have been submitted but not taken yet */
+    std::atomic<size_t> m_pending;
+    std::atomic<unsigned int> m_nextWorker;
+    /* Guarded by m_sleepLock */
+    bool m_stopping;
+};
+
+/* The pool that the current thread belongs to, if any, and its place in that pool */
+static thread_local const void* t_currentPool = nullptr;
+static thread_local unsigned int t_workerIndex = 0;
+
+CallPool::CallPool( unsigned int num_threads ) :
+    m_priv( std::make_shared<priv_data>() ) {
+    if( num_threads == 0 ) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+
+    if( num_threads == 0 ) {
+        num_threads = 1;
+    }
+
+    for( unsigned int x = 0; x < num_threads; x++ ) {
+        m_priv->m_workers.push_back( std::make_unique<PoolWorker>() );
+    }
+
+    // Only start once every queue exists, since the threads look at all of them
+    for( unsigned int x = 0; x < num_threads; x++ ) {
+        m_priv->m_workers[ x ]->thread = std::thread( &priv_data::worker_main, m_priv->shared_from_this(), x );
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Created call pool with " << num_threads << " threads" );
+}
+
+CallPool::~CallPool() {
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_sleepLock );
+        m_priv->m_stopping = true;
+    }
+
+    m_priv->m_sleepCv.notify_all();
+
+    for( std::unique_ptr<PoolWorker>& worker : m_priv->m_workers ) {
+        if( worker->thread.get_id() == std::this_thread::get_id() ) {
+            // The last reference to us went away in one of our own tasks.
+            // The thread keeps the queues alive until it is done with them.
+            worker->thread.detach();
+        } else if( worker->thread.joinable() ) {
+            worker->thread.join();
+        }
+    }
+}
+
+std::shared_ptr<CallPool> CallPool::create( unsigned int num_threads ) {
+    return std::shared_ptr<CallPool>( new CallPool( num_threads ) );
+}
+
+std::shared_ptr<CallPool> CallPool::default_pool() {
+    // Never destroyed, since calls may still be running during static destruction
+    static std::shared_ptr<CallPool>* pool = new std::shared_ptr<CallPool>( CallPool::create() );
+
+    return *pool;
+}
+
+unsigned int CallPool::num_threads() const {
+    return m_priv->m_workers.size();
+}
+
+void CallPool::submit( std::function<void()> task ) {
+    m_priv->submit( std::move( task ) );
+}
+
+void CallPool::submit( std::shared_ptr<Strand> strand, std::function<void()> task ) {
+    m_priv->submit( strand, std::move( task ) );
+}
+
+std::shared_ptr<CallPool::Strand> CallPool::create_strand() {
+    return std::make_shared<Strand>();
+}
+
+void CallPool::priv_data::submit( std::function<void()> task ) {
+    unsigned int index;
+
+    if( t_currentPool == this ) {
+        // Keep it close; if we are busy, somebody else will take it
+        index = t_workerIndex;
+    } else {
+        index = m_nextWorker++ % m_workers.size();
+    }
+
+    {
+        // Counted first, so that a sleeping thread can't miss it
+        std::unique_lock<std::mutex> lock( m_sleepLock );
+        m_pending++;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( m_workers[ index ]->lock );
+        m_workers[ index ]->tasks.push_back( std::move( task ) );
+    }
+
+    m_sleepCv.notify_one();
+}
+
+void CallPool::priv_data::submit( std::shared_ptr<Strand> strand, std::function<void()> task ) {
+    {
+        std::unique_lock<std::mutex> lock( strand->m_lock );
+        strand->m_tasks.push_back( std::move( task ) );
+
+        if( strand->m_running ) {
+            // It will be picked up once the tasks ahead of it are done
+            return;
+        }
+
+        strand->m_running = true;
+    }
+
+    submit( [this, strand]() {
+        run_strand( strand );
+    } );
+}
+
+void CallPool::priv_data::run_strand( std::shared_ptr<Strand> strand ) {
+    std::function<void()> task;
+
+    {
+        std::unique_lock<std::mutex> lock( strand->m_lock );
+        task = std::move( strand->m_tasks.front() );
+        strand->m_tasks.pop_front();
+    }
+
+    try {
+        task();
+    } catch( const std::exception& ex ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Uncaught exception in call pool: " << ex.what() );
+    } catch( ... ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Uncaught exception in call pool" );
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( strand->m_lock );
+
+        if( strand->m_tasks.empty() ) {
+            strand->m_running = false;
+            return;
+        }
+    }
+
+    // Go to the back of the line, so one busy strand can't keep a thread to itself
+    submit( [this, strand]() {
+        run_strand( strand );
+    } );
+}
+
+std::function<void()> CallPool::priv_data::take_task( unsigned int index ) {
+    std::function<void()> task;
+    size_t num_workers = m_workers.size();
+
+    // Our own work first, newest first since it is most likely to be in the cache
+    {
+        PoolWorker* worker = m_workers[ index ].get();
+        std::unique_lock<std::mutex> lock( worker->lock );
+
+        if( !worker->tasks.empty() ) {
+            task = std::move( worker->tasks.back() );
+            worker->tasks.pop_back();
+            m_pending--;
+            return task;
+        }
+    }
+
+    // Then steal the oldest work from somebody else
+    for( size_t x = 1; x < num_workers; x++ ) {
+        PoolWorker* worker = m_workers[ ( index + x ) % num_workers ].get();
+        std::unique_lock<std::mutex> lock( worker->lock );
+
+        if( !worker->tasks.empty() ) {
+            task = std::move( worker->tasks.front() );
+            worker->tasks.pop_front();
+            m_pending--;
+            return task;
+        }
+    }
+
+    return task;
+}
+
+void CallPool::priv_data::worker_main( std::shared_ptr<priv_data> priv, unsigned int index ) {
+    t_currentPool = priv.get();
+    t_workerIndex = index;
+
+    while( true ) {
+        std::function<void()> task = priv->take_task( index );
+
+        if( task ) {
+            try {
+                task();
+            } catch( const std::exception& ex ) {
+                SIMPLELOGGER_ERROR( LOGGER_NAME, "Uncaught exception in call pool: " << ex.what() );
+            } catch( ... ) {
+                SIMPLELOGGER_ERROR( LOGGER_NAME, "Uncaught exception in call pool" );
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( priv->m_sleepLock );
+
+        if( priv->m_stopping && priv->m_pending == 0 ) {
+            break;
+        }
+
+        priv->m_sleepCv.wait( lock, [&priv]() {
+            return priv->m_stopping || priv->m_pending > 0;
+        } );
+
+        if( priv->m_stopping && priv->m_pending == 0 ) {
+            break;
+        }
+    }
+
+    t_currentPool = nullptr;
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_CALLPOOL_H
+#define DBUSCXX_CALLPOOL_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <functional>
+#include <memory>
+
+namespace DBus {
+
+/**
+ * A pool of threads that method calls are handled on, for objects that are
+ * registered with ThreadForCalling::Pool or ThreadForCalling::PoolSerialized.
+ *
+ * Each thread has its own queue of work.  Work that is submitted from one of
+ * the pool's threads goes on that thread's queue; work from any other thread
+ * is spread over all of the queues.  A thread that runs out of work takes
+ * work from the other threads' queues, so one slow call does not hold up the
+ * calls queued behind it.
+ *
+ * Work may also be submitted to a Strand, in which case it runs one at a
+ * time in the order that it was submitted, but still on the pool's threads.
+ */
+class CallPool {
+private:
+    CallPool( unsigned int num_threads );
+
+public:
+    /**
+     * Tasks that are submitted to the same Strand run one at a time, in order.
+     */
+    class Strand;
+
+    /**
+     * Create a new pool.
+     *
+     * @param num_threads The number of threads in the pool.  If 0, one
+     * thread per CPU is used.
+     */
+    static std::shared_ptr<CallPool> create( unsigned int num_threads = 0 );
+
+    /**
+     * The pool that connections use unless they are given a different one
+     * with Connection::set_call_pool().  It is created the first time that
+     * it is needed.
+     */
+    static std::shared_ptr<CallPool> default_pool();
+
+    /**
+     * Waits for all submitted work to finish, then stops the threads.
+     */
+    ~CallPool();
+
+    unsigned int num_threads() const;
+
+    /**
+     * Run the given task on one of the pool's threads.
+     */
+    void submit( std::function<void()> task );
+
+    /**
+     * Run the given task on one of the pool's threads, after every task that
+     * was submitted to the strand before it has finished.
+     */
+    void submit( std::shared_ptr<Strand> strand, std::function<void()> task );
+
+    /**
+     * Create a new strand for use with this pool.
+     */
+    static std::shared_ptr<Strand> create_strand();
+
+private:
+    class priv_data;
+
+    /* Shared with the threads, so that they can outlive us if they must */
+    DBUS_CXX_PROPAGATE_CONST( std::shared_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_CALLPOOL_H */
@@ -10,9 +10,13 @@
 #include <dbus-cxx/signalmessage.h>
 #include <dbus-cxx/errormessage.h>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <limits>
 #include <memory>
+#include <unordered_map>
 #include <utility>
+#include "bufferpool.h"
 #include "callmessage.h"
 #include "dbus-cxx-private.h"
 #include "error.h"
@@ -20,8 +24,11 @@
 #include "object.h"
 #include "objectproxy.h"
 #include "path.h"
+#include "mpscqueue.h"
 #include "pendingcall.h"
 #include "returnmessage.h"
+#include "signalroutingtable.h"
+#include "timerwheel.h"
 #include <sigc++/sigc++.h>
 #include "signalproxy.h"
 #include "transport.h"
@@ -66,7 +73,12 @@ namespace DBus {
 struct ExpectingResponse {
     std::mutex cv_lock;
     std::condition_variable cv;
+    /* Guarded by cv_lock */
     std::shared_ptr<Message> reply;
+    /* When we give up waiting and reply with ErrorNoReply */
+    std::chrono::steady_clock::time_point deadline;
+    /* Set if nobody is blocking on cv, since the caller didn't want to wait */
+    std::shared_ptr<PendingCall> pending;
 };
 
 struct OutgoingMessage {
@@ -74,9 +86,19 @@ struct OutgoingMessage {
     uint32_t serial;
 };
 
+struct MatchRuleEntry {
+    /* How many times the rule has been added */
+    int count;
+    /* The AddMatch call for the rule; everybody adding it waits on this */
+    std::shared_ptr<PendingCall> addCall;
+};
+
 struct PathHandlingEntry {
     std::shared_ptr<Object> handler;
     std::thread::id handlingThread;
+    ThreadForCalling calling;
+    /* Only set if calling is ThreadForCalling::PoolSerialized */
+    std::shared_ptr<CallPool::Strand> strand;
 };
 
 struct ObjectProxyThreadInfo {
@@ -94,19 +116,146 @@ public:
     priv_data() :
         m_currentSerial( 1 ),
         m_dispatchingThread( std::this_thread::get_id() ),
-        m_dispatchStatus( DispatchStatus::COMPLETE )
-    {}
+        m_nextReplyTimeout( NO_REPLY_TIMEOUT ),
+        m_nextTimer( NO_REPLY_TIMEOUT ),
+        m_dispatchStatus( DispatchStatus::COMPLETE ),
+        m_isPeer( false ),
+        m_helloSerial( 0 ),
+        m_bufferTrimScheduled( false )
+    {
+        m_expectingResponses.reserve( 64 );
+    }
+
+    /**
+     * Start waiting for the reply to the given serial.  Must be called
+     * before the call goes out.
+     */
+    void add_expecting_response( uint32_t serial, std::shared_ptr<ExpectingResponse> ex ) {
+        std::unique_lock<std::mutex> lock( m_expectingResponsesLock );
+        m_expectingResponses[ serial ] = ex;
+        m_replyTimeouts.add( serial, ex->deadline );
+        m_nextReplyTimeout = m_replyTimeouts.next_expiry().time_since_epoch().count();
+    }
+
+    /**
+     * Stop waiting for the reply to the given serial.
+     *
+     * @return Whatever was waiting for the reply, or null if nothing was
+     */
+    std::shared_ptr<ExpectingResponse> take_expecting_response( uint32_t serial ) {
+        std::unique_lock<std::mutex> lock( m_expectingResponsesLock );
+        std::unordered_map<uint32_t, std::shared_ptr<ExpectingResponse>>::iterator it =
+            m_expectingResponses.find( serial );
+        std::shared_ptr<ExpectingResponse> ex;
+
+        if( it == m_expectingResponses.end() ) {
+            return ex;
+        }
+
+        ex = std::move( it->second );
+        m_expectingResponses.erase( it );
+        m_replyTimeouts.remove( serial, ex->deadline );
+        m_nextReplyTimeout = m_replyTimeouts.next_expiry().time_since_epoch().count();
+
+        return ex;
+    }
+
+    /**
+     * Hand the reply to whoever is waiting for it.
+     */
+    static void complete_expecting_response( std::shared_ptr<ExpectingResponse> ex, std::shared_ptr<Message> reply ) {
+        if( ex->pending ) {
+            ex->pending->complete( reply );
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock( ex->cv_lock );
+            ex->reply = reply;
+        }
+
+        ex->cv.notify_one();
+    }
+
+    /**
+     * The bus refused the rule, so forget about it; the next time that it
+     * is added, the bus is asked again.  Nothing is done if the rule has
+     * since been removed and added again with a new call.
+     */
+    void forget_match_rule( const std::string& rule, std::shared_ptr<PendingCall> addCall ) {
+        std::unique_lock<std::mutex> lock( m_listeningSignalsLock );
+        std::map<std::string,MatchRuleEntry>::iterator it = m_listeningSignals.find( rule );
+
+        if( it != m_listeningSignals.end() && it->second.addCall == addCall ) {
+            m_listeningSignals.erase( it );
+        }
+    }
+
+    /**
+     * If the message is the reply to a call that we are expecting a response
+     * to, hand it over and return true.
+     */
+    bool complete_reply( std::shared_ptr<Message> msg ) {
+        uint32_t reply_serial;
+
+        if( msg->type() == MessageType::RETURN ) {
+            reply_serial = std::static_pointer_cast<ReturnMessage>( msg )->reply_serial();
+        } else if( msg->type() == MessageType::ERROR ) {
+            reply_serial = std::static_pointer_cast<ErrorMessage>( msg )->reply_serial();
+        } else {
+            return false;
+        }
+
+        std::shared_ptr<ExpectingResponse> ex = take_expecting_response( reply_serial );
+
+        if( !ex ) { return false; }
+
+        complete_expecting_response( ex, msg );
+        return true;
+    }
+
+    static const std::chrono::steady_clock::rep NO_REPLY_TIMEOUT =
+        std::numeric_limits<std::chrono::steady_clock::rep>::max();
+
+    /**
+     * Get the serial to use for the next message that we send.  Safe to
+     * call from any thread.
+     */
+    uint32_t next_serial() {
+        uint32_t serial = m_currentSerial++;
+
+        // Serials may not be 0; skip over it when we wrap around
+        if( serial == 0 ) {
+            serial = m_currentSerial++;
+        }
+
+        return serial;
+    }
 
     std::vector<uint8_t> m_sendBuffer;
-    uint32_t m_currentSerial;
+    std::atomic<uint32_t> m_currentSerial;
     std::shared_ptr<priv::Transport> m_transport;
     std::string m_uniqueName;
     std::thread::id m_dispatchingThread;
     std::queue<std::shared_ptr<Message>> m_incomingMessages;
-    std::mutex m_outgoingLock;
-    std::queue<OutgoingMessage> m_outgoingMessages;
+    /*
+     * Held by whichever thread is writing to the transport, so that messages
+     * go out whole and in order.  Threads that only queue messages never
+     * take this.
+     */
+    std::mutex m_writeLock;
+    priv::MPSCQueue<OutgoingMessage> m_outgoingMessages;
+    /* Guards m_expectingResponses and m_replyTimeouts */
     std::mutex m_expectingResponsesLock;
-    std::map<uint32_t, std::shared_ptr<ExpectingResponse>> m_expectingResponses;
+    std::unordered_map<uint32_t, std::shared_ptr<ExpectingResponse>> m_expectingResponses;
+    priv::TimerWheel m_replyTimeouts;
+    /* When m_replyTimeouts next needs to be checked, so we can skip the lock until then */
+    std::atomic<std::chrono::steady_clock::rep> m_nextReplyTimeout;
+    /* Guards m_timers */
+    std::mutex m_timersLock;
+    std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> m_timers;
+    /* When the first of m_timers is due, so we can skip the lock until then */
+    std::atomic<std::chrono::steady_clock::rep> m_nextTimer;
     DispatchStatus m_dispatchStatus;
     std::mutex m_pathHandlerLock;
     std::map<std::string, PathHandlingEntry> m_path_handler;
@@ -118,22 +267,60 @@ public:
     std::vector<FreeSignalThreadInfo> m_freeProxySignals;
     std::mutex m_objectProxiesLock;
     std::vector<ObjectProxyThreadInfo> m_objectProxies;
-    std::map<std::string,int> m_listeningSignals;
+    /*
+     * Which of the signal proxies above get which signals.  Proxies are put in
+     * and taken out one at a time as they come and go.  This lock is taken
+     * last, after m_freeProxySignalsLock and m_objectProxiesLock.
+     */
+    std::mutex m_signalRoutesLock;
+    priv::SignalRoutingTable m_signalRoutes;
+    /* Guards m_listeningSignals, so that calls for a rule go out in order */
+    std::mutex m_listeningSignalsLock;
+    /* Every match rule that has been added, and the call that added it */
+    std::map<std::string,MatchRuleEntry> m_listeningSignals;
+    sigc::signal<void(std::string, std::string)> m_matchRuleError;
+    bool m_isPeer;
+    /* Only set while we are connecting asynchronously */
+    std::shared_ptr<priv::TransportConnector> m_connector;
+    /* When we give up on connecting asynchronously, Hello included */
+    std::chrono::steady_clock::time_point m_connectDeadline;
+    /* The serial of our Hello call, if we are waiting for the reply to it */
+    uint32_t m_helloSerial;
+    sigc::signal<void(bool)> m_connected;
+    /* Accessed atomically; null until first needed */
+    std::shared_ptr<CallPool> m_callPool;
+    /* True if trim_buffers() is going to run; only used on the dispatching thread */
+    bool m_bufferTrimScheduled;
 };
 
-Connection::Connection( BusType type ) {
-    m_priv = std::make_unique<priv_data>();
+static void set_path_handling_calling( PathHandlingEntry& entry,
+                                       ThreadForCalling calling,
+                                       std::thread::id dispatchingThread ) {
+    entry.calling = calling;
+    entry.strand.reset();
+
+    if( calling == ThreadForCalling::CurrentThread ) {
+        entry.handlingThread = std::this_thread::get_id();
+    } else {
+        entry.handlingThread = dispatchingThread;
+    }
+
+    if( calling == ThreadForCalling::PoolSerialized ) {
+        entry.strand = CallPool::create_strand();
+    }
+}
 
+static std::string bus_address( BusType type ) {
     if( type == BusType::SESSION ) {
         char* env_address = getenv( "DBUS_SESSION_BUS_ADDRESS" );
 
         if( env_address == nullptr ) {
-            return;
+            return std::string();
         }
 
         std::string sessionBusAddr = std::string( env_address );
         SIMPLELOGGER_DEBUG( LOGGER_NAME, "Going to open session bus: " + sessionBusAddr );
-        m_priv->m_transport = priv::Transport::open_transport( sessionBusAddr );
+        return sessionBusAddr;
     } else if( type == BusType::SYSTEM ) {
         char* env_address = getenv( "DBUS_SYSTEM_BUS_ADDRESS" );
         std::string systemBusAddr;
@@ -146,7 +333,7 @@ Connection::Connection( BusType type ) {
             systemBusAddr = "unix:path=/var/run/dbus/system_bus_socket";
         }
 
-        m_priv->m_transport = priv::Transport::open_transport( systemBusAddr );
+        return systemBusAddr;
     } else if( type == BusType::STARTER ) {
         char* env_address = getenv( "DBUS_STARTER_ADDRESS" );
         std::string starterBusAddr;
@@ -160,9 +347,23 @@ Connection::Connection( BusType type ) {
                 "to DBUS_STARTER_ADDRESS, but environment variable not defined or empty" );
         }
 
-        m_priv->m_transport = priv::Transport::open_transport( starterBusAddr );
+        return starterBusAddr;
+    }
+
+    return std::string();
+}
+
+Connection::Connection( BusType type ) {
+    m_priv = std::make_unique<priv_data>();
+
+    std::string address = bus_address( type );
+
+    if( address.empty() ) {
+        return;
     }
 
+    m_priv->m_transport = priv::Transport::open_transport( address );
+
     if( !m_priv->m_transport || !m_priv->m_transport->is_valid() ) {
         SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to open transport" );
         return;
@@ -179,6 +380,23 @@ Connection::Connection( std::string address ) {
     }
 }
 
+Connection::Connection( std::shared_ptr<priv::Transport> transport ) {
+    m_priv = std::make_unique<priv_data>();
+    m_priv->m_transport = transport;
+    m_priv->m_isPeer = true;
+}
+
+Connection::Connection( std::shared_ptr<priv::TransportConnector> connector ) {
+    m_priv = std::make_unique<priv_data>();
+
+    if( connector->status() == priv::TransportConnector::Status::Failed ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to open transport" );
+        return;
+    }
+
+    m_priv->m_connector = connector;
+}
+
 std::shared_ptr<Connection> Connection::create( BusType type ) {
     std::shared_ptr<Connection> p( new Connection( type ) );
 
@@ -192,6 +410,31 @@ std::shared_ptr<Connection> Connection::create( std::string address ) {
 
 }
 
+std::shared_ptr<Connection> Connection::create_peer( std::string address ) {
+    std::shared_ptr<Connection> p( new Connection( address ) );
+
+    p->m_priv->m_isPeer = true;
+
+    return p;
+}
+
+std::shared_ptr<Connection> Connection::create_async( BusType type, int timeout_milliseconds ) {
+    return create_async( bus_address( type ), timeout_milliseconds );
+}
+
+std::shared_ptr<Connection> Connection::create_async( std::string address, int timeout_milliseconds ) {
+    std::shared_ptr<Connection> p( new Connection( priv::TransportConnector::create( address ) ) );
+
+    if( timeout_milliseconds == -1 ) {
+        // Use the same default as send_with_reply_blocking
+        timeout_milliseconds = 20000;
+    }
+
+    p->m_priv->m_connectDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( timeout_milliseconds );
+
+    return p;
+}
+
 Connection::~Connection() {
 }
 
@@ -204,6 +447,11 @@ bool Connection::is_valid() const {
 }
 
 bool Connection::bus_register() {
+    if( is_connecting() ) {
+        // We will register on our own once we are connected
+        return false;
+    }
+
     if( !m_priv->m_transport || !m_priv->m_transport->is_valid() ) {
         return false;
     }
@@ -220,7 +468,96 @@ bool Connection::bus_register() {
 }
 
 bool Connection::is_registered() const {
-    return !m_priv->m_uniqueName.empty();
+    // There is nobody to register with on a peer-to-peer connection
+    return m_priv->m_isPeer || !m_priv->m_uniqueName.empty();
+}
+
+bool Connection::is_peer() const {
+    return m_priv->m_isPeer;
+}
+
+bool Connection::is_connecting() const {
+    return m_priv->m_connector || m_priv->m_helloSerial != 0;
+}
+
+bool Connection::connect_wants_write() const {
+    return m_priv->m_connector && m_priv->m_connector->wants_write();
+}
+
+sigc::signal<void(bool)>& Connection::signal_connected() {
+    return m_priv->m_connected;
+}
+
+void Connection::continue_connecting() {
+    priv::TransportConnector::Status status = m_priv->m_connector->step();
+
+    if( status == priv::TransportConnector::Status::InProgress ) {
+        return;
+    }
+
+    if( status == priv::TransportConnector::Status::Failed ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to open transport" );
+        fail_connecting();
+        return;
+    }
+
+    m_priv->m_transport = m_priv->m_connector->transport();
+    m_priv->m_connector.reset();
+
+    if( m_priv->m_isPeer ) {
+        m_priv->m_connected.emit( true );
+        return;
+    }
+
+    /*
+     * Say Hello to the bus, but don't wait for the reply here: we get our
+     * unique name once the reply comes in through the normal dispatching.
+     */
+    m_priv->m_daemonProxy = DBus::DBusDaemonProxy::create( shared_from_this() );
+
+    std::shared_ptr<CallMessage> hello =
+        CallMessage::create( "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "Hello" );
+
+    // The serial must be known before the reply can possibly come in
+    OutgoingMessage outgoing;
+    outgoing.msg = hello;
+    outgoing.serial = m_priv->next_serial();
+    m_priv->m_helloSerial = outgoing.serial;
+    m_priv->m_outgoingMessages.push( outgoing );
+
+    notify_dispatcher_or_dispatch();
+}
+
+void Connection::fail_connecting() {
+    m_priv->m_connector.reset();
+    m_priv->m_helloSerial = 0;
+
+    /*
+     * Don't leave an unregistered connection behind, or the dispatcher
+     * would try to register it again with a blocking call.
+     */
+    m_priv->m_transport.reset();
+    fail_pending_replies();
+
+    m_priv->m_connected.emit( false );
+}
+
+void Connection::process_hello_reply( std::shared_ptr<Message> reply ) {
+    m_priv->m_helloSerial = 0;
+
+    if( reply->type() == MessageType::ERROR ) {
+        std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( reply );
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to register with the bus: " << errmsg->message() );
+        fail_connecting();
+        return;
+    }
+
+    std::string uniqueName;
+    reply >> uniqueName;
+    m_priv->m_uniqueName = uniqueName;
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Registered with the bus as " + uniqueName );
+    m_priv->m_connected.emit( true );
 }
 
 std::string Connection::unique_name() const {
@@ -234,6 +571,10 @@ RequestNameResponse Connection::request_name( const std::string& name, unsigned
         throw ErrorDisconnected();
     }
 
+    if( m_priv->m_isPeer ) {
+        throw ErrorNotSupported( "Can't request a name on a peer-to-peer connection" );
+    }
+
     uint32_t retval = m_priv->m_daemonProxy->RequestName( name, flags );
 
     switch( retval ) {
@@ -258,6 +599,10 @@ RequestNameResponse Connection::request_name( const std::string& name, unsigned
 }
 
 ReleaseNameResponse Connection::release_name( const std::string& name ) {
+    if( m_priv->m_isPeer ) {
+        throw ErrorNotSupported( "Can't release a name on a peer-to-peer connection" );
+    }
+
     uint32_t retval = m_priv->m_daemonProxy->ReleaseName( name );
 
     switch( retval ) {
@@ -278,10 +623,18 @@ ReleaseNameResponse Connection::release_name( const std::string& name ) {
 }
 
 bool Connection::name_has_owner( const std::string& name ) const {
+    if( m_priv->m_isPeer ) {
+        throw ErrorNotSupported( "No bus to query on a peer-to-peer connection" );
+    }
+
     return m_priv->m_daemonProxy->NameHasOwner( name );
 }
 
 StartReply Connection::start_service( const std::string& name, uint32_t flags ) const {
+    if( m_priv->m_isPeer ) {
+        throw ErrorNotSupported( "Can't start a service on a peer-to-peer connection" );
+    }
+
     uint32_t retval = m_priv->m_daemonProxy->StartServiceByName( name, flags );
 
     switch( retval ) {
@@ -299,50 +652,121 @@ StartReply Connection::start_service( const std::string& name, uint32_t flags )
 }
 
 bool Connection::add_match( const std::string& rule ) {
-    if( !is_valid() ) {
-        throw ErrorDisconnected();
-    }
+    std::shared_ptr<PendingCall> call = update_match( rule, true );
 
-    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Adding the following match: " << rule );
+    // A peer sends us everything already, so there is nothing to ask for
+    if( !call ) { return m_priv->m_isPeer; }
 
-    if( m_priv->m_daemonProxy ) {
-        std::map<std::string,int>::iterator it =
-                m_priv->m_listeningSignals.find( rule );
-        if( it == m_priv->m_listeningSignals.end() ){
-            m_priv->m_listeningSignals[ rule ] = 1;
-        }else{
-            int count = m_priv->m_listeningSignals[ rule ];
-            m_priv->m_listeningSignals[ rule ] = count + 1;
-        }
-        m_priv->m_daemonProxy->AddMatch( rule );
+    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
+        wait_for_replies_on_dispatching_thread( [call]() {
+            return call->completed();
+        } );
+    } else {
+        notify_dispatcher_or_dispatch();
+        call->block();
+    }
+
+    if( call->reply()->type() != MessageType::RETURN ) {
+        // The reply callback may still be running, so don't leave it up to that
+        m_priv->forget_match_rule( rule, call );
+        return false;
     }
 
     return true;
 }
 
 void Connection::add_match_nonblocking( const std::string& rule ) {
-    //    if ( not this->is_valid() ) return;
-    //    dbus_bus_add_match( m_cobj, rule.c_str(), nullptr );
+    std::shared_ptr<PendingCall> call = update_match( rule, true );
+
+    if( call && !call->completed() ) {
+        notify_dispatcher_or_dispatch();
+    }
 }
 
 bool Connection::remove_match( const std::string& rule ) {
-    if( m_priv->m_daemonProxy ){
-        std::map<std::string,int>::iterator it =
-                m_priv->m_listeningSignals.find( rule );
-        if( it != m_priv->m_listeningSignals.end() ){
-            int count = m_priv->m_listeningSignals[ rule ];
-            count--;
-            m_priv->m_listeningSignals[ rule ] = count;
-
-            if( count == 0 ){
-                m_priv->m_daemonProxy->RemoveMatch( rule );
-            }
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_listeningSignalsLock );
+
+        if( m_priv->m_listeningSignals.find( rule ) == m_priv->m_listeningSignals.end() ) {
+            return false;
         }
     }
 
+    if( update_match( rule, false ) ) {
+        notify_dispatcher_or_dispatch();
+    }
+
     return true;
 }
 
+sigc::signal<void(std::string, std::string)>& Connection::signal_match_rule_error() {
+    return m_priv->m_matchRuleError;
+}
+
+std::shared_ptr<PendingCall> Connection::update_match( const std::string& rule, bool add ) {
+    if( !is_valid() ) {
+        // There is nothing left to remove the rule from
+        if( !add ) { return std::shared_ptr<PendingCall>(); }
+
+        throw ErrorDisconnected();
+    }
+
+    // Peer to peer connections have nobody to ask
+    if( !m_priv->m_daemonProxy ) { return std::shared_ptr<PendingCall>(); }
+
+    std::weak_ptr<Connection> weak_this = shared_from_this();
+    std::unique_lock<std::mutex> lock( m_priv->m_listeningSignalsLock );
+    std::map<std::string,MatchRuleEntry>::iterator it = m_priv->m_listeningSignals.find( rule );
+
+    if( add ) {
+        if( it != m_priv->m_listeningSignals.end() ) {
+            // Somebody else already asked for the rule; wait on their answer
+            it->second.count++;
+            return it->second.addCall;
+        }
+    } else {
+        if( it == m_priv->m_listeningSignals.end() ) { return std::shared_ptr<PendingCall>(); }
+
+        if( --it->second.count > 0 ) { return std::shared_ptr<PendingCall>(); }
+
+        m_priv->m_listeningSignals.erase( it );
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, ( add ? "Adding" : "Removing" ) << " the following match: " << rule );
+
+    std::shared_ptr<CallMessage> msg =
+        m_priv->m_daemonProxy->create_call_message( "org.freedesktop.DBus", add ? "AddMatch" : "RemoveMatch" );
+    msg << rule;
+
+    /*
+     * Queue the call while we still hold the lock, so that if the rule is
+     * removed and added again, the bus sees the calls in that order too.
+     */
+    std::vector<std::shared_ptr<PendingCall>> calls = queue_calls( { msg }, -1,
+        [weak_this, rule, add]( std::shared_ptr<PendingCall> call ) {
+            std::shared_ptr<Connection> conn = weak_this.lock();
+            std::shared_ptr<Message> reply = call->reply();
+
+            if( !conn || reply->type() != MessageType::ERROR ) { return; }
+
+            std::shared_ptr<ErrorMessage> error = std::static_pointer_cast<ErrorMessage>( reply );
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to " << ( add ? "add" : "remove" ) << " match rule "
+                << rule << ": " << error->name() << ": " << error->message() );
+
+            if( add ) {
+                conn->m_priv->forget_match_rule( rule, call );
+            }
+
+            conn->m_priv->m_matchRuleError.emit( rule, error->name() + ": " + error->message() );
+        } );
+
+    if( add ) {
+        m_priv->m_listeningSignals[ rule ] = MatchRuleEntry{ 1, calls.front() };
+    }
+
+    return calls.front();
+}
+
 bool Connection::is_connected() const {
     //    if ( not this->is_valid() ) return false;
     //    return dbus_connection_get_is_connected( m_cobj );
@@ -372,19 +796,38 @@ uint32_t Connection::send( std::shared_ptr<const Message> msg ) {
 
     if( !msg ) { return 0; }
 
-    if( m_priv->m_currentSerial == 0 ) { m_priv->m_currentSerial = 1; }
-
     OutgoingMessage outgoing;
-    {
-        std::unique_lock<std::mutex> lock( m_priv->m_outgoingLock );
+    outgoing.msg = msg;
+    outgoing.serial = m_priv->next_serial();
+    m_priv->m_outgoingMessages.push( outgoing );
+
+    notify_dispatcher_or_dispatch();
+
+    return outgoing.serial;
+}
+
+std::vector<uint32_t> Connection::send_batch( const std::vector<std::shared_ptr<const Message>>& messages ) {
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
+
+    std::vector<uint32_t> serials;
+    serials.reserve( messages.size() );
+
+    for( const std::shared_ptr<const Message>& msg : messages ) {
+        if( !msg ) {
+            serials.push_back( 0 );
+            continue;
+        }
+
+        OutgoingMessage outgoing;
         outgoing.msg = msg;
-        outgoing.serial = m_priv->m_currentSerial++;
+        outgoing.serial = m_priv->next_serial();
         m_priv->m_outgoingMessages.push( outgoing );
+        serials.push_back( outgoing.serial );
     }
 
     notify_dispatcher_or_dispatch();
 
-    return outgoing.serial;
+    return serials;
 }
 
 Connection& Connection::operator <<( std::shared_ptr<const Message> msg ) {
@@ -407,168 +850,243 @@ std::shared_ptr<ReturnMessage> Connection::send_with_reply_blocking( std::shared
         msToWait = 20000;
     }
 
-    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
-        uint32_t replySerialExpceted;
-        bool gotReply = false;
+    uint32_t serial;
+    std::shared_ptr<ExpectingResponse> ex;
+    std::shared_ptr<Message> gotMessage;
 
+    OutgoingMessage outgoing;
+    outgoing.msg = message;
+    outgoing.serial = m_priv->next_serial();
+    serial = outgoing.serial;
+    ex = std::make_shared<ExpectingResponse>();
+    ex->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait );
+
+    // We must be expecting the response before the call can go out
+    m_priv->add_expecting_response( serial, ex );
+    m_priv->m_outgoingMessages.push( outgoing );
+
+    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
         /*
          * We are trying to do a blocking method call in the dispatching thread.
-         * Don't queue up this message, just send it.
+         * Write and read right here until the reply lands in its slot; if it
+         * doesn't come in time, the slot gets ErrorNoReply.
          */
-        {
-            std::unique_lock<std::mutex> lock( m_priv->m_outgoingLock );
-            replySerialExpceted = write_single_message( message );
-        }
+        wait_for_replies_on_dispatching_thread( [&ex]() {
+            std::unique_lock<std::mutex> lock( ex->cv_lock );
+            return ex->reply.get() != nullptr;
+        } );
 
+        gotMessage = ex->reply;
+    } else {
         /*
-         * Read messages until we find the one with the serial that we are expecting
+         * We are trying to do a blocking method call in a thread that is not the dispatcher thread.
+         * Notify the dispatcher thread, and wait for it to give us the reply.
          */
-        std::vector<int> fds;
-        fds.push_back( m_priv->m_transport->fd() );
+        notify_dispatcher_or_dispatch();
 
-        do {
-            std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> fdResponse =
-                DBus::priv::wait_for_fd_activity( fds, msToWait );
+        /*
+         * Lock on the expecting response; when the response comes in(or we time out),
+         * we will be notified from the dispatching thread
+         */
+        std::unique_lock<std::mutex> lock( ex->cv_lock );
+        bool status = ex->cv.wait_until( lock, ex->deadline, [&ex] {
+            // return false if the waiting should be continued
+            return ex->reply.get() != nullptr;
+        } );
+        gotMessage = ex->reply;
+
+        lock.unlock();
+
+        if( !status ) {
+            // The dispatcher never got to us; make sure it doesn't try to later
+            m_priv->take_expecting_response( serial );
+            throw ErrorNoReply( "Did not receive a response in the alotted time" );
+        }
+    }
 
-            msToWait -= std::get<3>( fdResponse ).count();
+    if( gotMessage->type() == MessageType::RETURN ) {
+        retmsg = std::static_pointer_cast<ReturnMessage>( gotMessage );
+    } else if( gotMessage->type() == MessageType::ERROR ) {
+        std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( gotMessage );
+        errmsg->throw_error();
+    } else if( gotMessage->type() == MessageType::SIGNAL ) {
+    } else {
+        throw ErrorUnknown( "Why are we here" );
+    }
 
-            if( msToWait <= 0 ) {
-                throw ErrorNoReply( "Did not receive a response in the alotted time" );
-            }
+    return retmsg;
+}
 
-            if( !m_priv->m_transport->is_valid() ) {
-                throw ErrorDisconnected();
-            }
+std::shared_ptr<PendingCall> Connection::send_with_reply_async( std::shared_ptr<const CallMessage> message,
+    int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
 
-            std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
-            {
-                std::ostringstream str;
-                str << incoming.get();
-                SIMPLELOGGER_DEBUG( LOGGER_NAME, "Got incoming " << str.str() );
-            }
+    if( !message ) { return std::shared_ptr<PendingCall>(); }
 
-            if( incoming ) {
-                // Check to see what type of message we have, and if it might be a reply to our
-                // method call.
-                if( incoming->type() == MessageType::ERROR ) {
-                    std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( incoming );
+    int msToWait = timeout_milliseconds;
 
-                    if( errmsg->reply_serial() == replySerialExpceted ) {
-                        errmsg->throw_error();
-                    }
-                } else if( incoming->type() == MessageType::RETURN ) {
-                    retmsg = std::static_pointer_cast<ReturnMessage>( incoming );
+    if( msToWait == -1 ) {
+        // Use the same default as send_with_reply_blocking
+        msToWait = 20000;
+    }
 
-                    if( retmsg->reply_serial() == replySerialExpceted ) {
-                        gotReply = true;
-                    }
-                }
+    OutgoingMessage outgoing;
+    outgoing.msg = message;
+    outgoing.serial = m_priv->next_serial();
 
-                if( !gotReply ) {
-                    m_priv->m_incomingMessages.push( incoming );
-                }
+    std::shared_ptr<PendingCall> pending = PendingCall::create( outgoing.serial, callback );
+    std::shared_ptr<ExpectingResponse> ex = std::make_shared<ExpectingResponse>();
+    ex->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait );
+    ex->pending = pending;
 
-            }
-        } while( !gotReply );
+    // We must be expecting the response before the call can go out
+    m_priv->add_expecting_response( outgoing.serial, ex );
+    m_priv->m_outgoingMessages.push( outgoing );
+
+    notify_dispatcher_or_dispatch();
+
+    return pending;
+}
+
+std::vector<std::shared_ptr<PendingCall>> Connection::send_with_reply_batch_async(
+    const std::vector<std::shared_ptr<const CallMessage>>& messages,
+    int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+    std::vector<std::shared_ptr<PendingCall>> pending = queue_calls( messages, timeout_milliseconds, callback );
+
+    notify_dispatcher_or_dispatch();
+
+    return pending;
+}
+
+std::vector<std::shared_ptr<Message>> Connection::send_with_reply_batch(
+    const std::vector<std::shared_ptr<const CallMessage>>& messages,
+    int timeout_milliseconds ) {
+    std::shared_ptr<std::atomic<size_t>> remaining = std::make_shared<std::atomic<size_t>>( 0 );
+    std::vector<std::shared_ptr<Message>> replies( messages.size() );
+
+    for( const std::shared_ptr<const CallMessage>& msg : messages ) {
+        if( msg ) { ( *remaining )++; }
+    }
 
+    std::vector<std::shared_ptr<PendingCall>> pending = queue_calls( messages, timeout_milliseconds,
+        [remaining]( std::shared_ptr<PendingCall> ) {
+            ( *remaining )--;
+        } );
+
+    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
+        wait_for_replies_on_dispatching_thread( [remaining]() {
+            return *remaining == 0;
+        } );
     } else {
-        /*
-         * We are trying to do a blocking method call in a thread that is not the dispatcher thread.
-         * Queue up the message and notify the dispatcher thread.
-         */
-        uint32_t serial;
-        std::shared_ptr<ExpectingResponse> ex;
+        notify_dispatcher_or_dispatch();
 
-        {
-            OutgoingMessage outgoing;
-            std::scoped_lock<std::mutex, std::mutex> lock( m_priv->m_outgoingLock, m_priv->m_expectingResponsesLock );
-            outgoing.msg = message;
-            outgoing.serial = m_priv->m_currentSerial++;
-            m_priv->m_outgoingMessages.push( outgoing );
-            serial = outgoing.serial;
-
-            // Add this to our expecting responses
-            ex = std::make_shared<ExpectingResponse>();
-            m_priv->m_expectingResponses[ serial ] = ex;
+        for( const std::shared_ptr<PendingCall>& call : pending ) {
+            if( call ) { call->block(); }
         }
+    }
 
-        notify_dispatcher_or_dispatch();
+    for( size_t x = 0; x < pending.size(); x++ ) {
+        if( pending[ x ] ) {
+            replies[ x ] = pending[ x ]->reply();
+        }
+    }
 
-        {
-            /*
-             * Lock on the expecting response; when the response comes in, we will notify from
-             * the dispatching thread
-             */
-            std::chrono::time_point now = std::chrono::steady_clock::now();
-            std::unique_lock<std::mutex> lock( ex->cv_lock );
-            bool status = ex->cv.wait_until( lock, now + std::chrono::milliseconds( msToWait ), [this, serial] {
-                std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
-                std::map<uint32_t, std::shared_ptr<ExpectingResponse>>::iterator it =
-                    m_priv->m_expectingResponses.find( serial );
-
-                // return false if the waiting should be continued
-                return ( *it ).second->reply.get() != nullptr;
-            } );
-            std::shared_ptr<ExpectingResponse> resp;
-
-            {
-                /*
-                 * Now remove our expecting response to free up memory
-                 */
-                std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
-                std::map<uint32_t, std::shared_ptr<ExpectingResponse>>::iterator it =
-                        m_priv->m_expectingResponses.find( serial );
-                resp = ( *it ).second;
-
-                m_priv->m_expectingResponses.erase( it );
-            }
+    return replies;
+}
 
-            if( !resp ) {
-                throw ErrorUnexpectedResponse();
-            }
+std::vector<std::shared_ptr<PendingCall>> Connection::queue_calls(
+    const std::vector<std::shared_ptr<const CallMessage>>& messages,
+    int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
 
-            if( status ) {
-                std::shared_ptr<Message> gotMessage = resp->reply;
-
-                if( gotMessage->type() == MessageType::RETURN ) {
-                    retmsg = std::static_pointer_cast<ReturnMessage>( gotMessage );
-                } else if( gotMessage->type() == MessageType::ERROR ) {
-                    std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( gotMessage );
-                    errmsg->throw_error();
-                } else if( gotMessage->type() == MessageType::SIGNAL ) {
-                } else {
-                    throw ErrorUnknown( "Why are we here" );
-                }
-            } else {
-                throw ErrorNoReply( "Did not receive a response in the alotted time" );
-            }
+    std::vector<std::shared_ptr<PendingCall>> pending( messages.size() );
+    int msToWait = timeout_milliseconds;
+
+    if( msToWait == -1 ) {
+        // Use the same default as send_with_reply_blocking
+        msToWait = 20000;
+    }
+
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait );
+
+    for( size_t x = 0; x < messages.size(); x++ ) {
+        if( !messages[ x ] ) { continue; }
+
+        OutgoingMessage outgoing;
+        outgoing.msg = messages[ x ];
+        outgoing.serial = m_priv->next_serial();
+
+        std::shared_ptr<ExpectingResponse> ex = std::make_shared<ExpectingResponse>();
+        ex->deadline = deadline;
+        ex->pending = PendingCall::create( outgoing.serial, callback );
+        pending[ x ] = ex->pending;
+
+        // We must be expecting the response before the call can go out
+        m_priv->add_expecting_response( outgoing.serial, ex );
+        m_priv->m_outgoingMessages.push( outgoing );
+    }
+
+    return pending;
+}
+
+void Connection::wait_for_replies_on_dispatching_thread( std::function<bool()> done ) {
+    struct pollfd toListen;
+    toListen.fd = socket();
+    toListen.events = POLLIN;
+
+    /*
+     * We can't go back to the dispatcher until the replies are in, so do
+     * its job here: write out the calls, and read until the replies come in.
+     * Everything that is read is handled as it comes in: replies go to
+     * whoever is waiting for them, anything else gets processed later.
+     * Timeouts are checked every time around, so that a flood of other
+     * messages can't keep us here past the deadline.
+     */
+    while( true ) {
+        if( !this->is_valid() ) {
+            fail_pending_replies();
+            throw ErrorDisconnected();
+        }
+
+        expire_pending_replies();
+        run_timers();
+        flush();
+
+        if( done() ) { break; }
+
+        std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
+
+        if( !incoming ) {
+            toListen.revents = 0;
+            ::poll( &toListen, 1, next_timeout_milliseconds() );
+            continue;
+        }
+
+        if( !m_priv->complete_reply( incoming ) ) {
+            m_priv->m_incomingMessages.push( incoming );
         }
     }
 
-    return retmsg;
+    schedule_buffer_trim();
 }
 
 void Connection::flush() {
     if( !this->is_valid() ) { return; }
 
     {
-        std::unique_lock lock( m_priv->m_outgoingLock );
-
-        while( !m_priv->m_outgoingMessages.empty() ) {
-            OutgoingMessage outgoing = m_priv->m_outgoingMessages.front();
-            m_priv->m_outgoingMessages.pop();
+        std::unique_lock lock( m_priv->m_writeLock );
+        OutgoingMessage outgoing;
 
+        while( m_priv->m_outgoingMessages.pop( outgoing ) ) {
             m_priv->m_transport->writeMessage( outgoing.msg, outgoing.serial );
         }
     }
 }
 
-uint32_t Connection::write_single_message( std::shared_ptr<const Message> msg ) {
-    uint32_t retval = m_priv->m_currentSerial;
-    m_priv->m_transport->writeMessage( msg, m_priv->m_currentSerial++ );
-    return retval;
-}
-
 DispatchStatus Connection::dispatch_status( ) const {
     if( !this->is_valid() ) { return DispatchStatus::COMPLETE; }
 
@@ -580,11 +1098,29 @@ DispatchStatus Connection::dispatch( ) {
         throw ErrorIncorrectDispatchThread( "Calling Connection::dispatch from non-dispatching thread" );
     }
 
+    if( is_connecting() && std::chrono::steady_clock::now() >= m_priv->m_connectDeadline ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Timed out connecting" );
+        fail_connecting();
+    }
+
+    if( m_priv->m_connector ) {
+        continue_connecting();
+
+        if( !this->is_valid() ) {
+            m_priv->m_dispatchStatus = DispatchStatus::COMPLETE;
+            return DispatchStatus::COMPLETE;
+        }
+    }
+
     if( !this->is_valid() ) {
+        fail_pending_replies();
         m_priv->m_dispatchStatus = DispatchStatus::COMPLETE;
         return DispatchStatus::COMPLETE;
     }
 
+    expire_pending_replies();
+    run_timers();
+
     // Write out any messages we have waiting to be written
     flush();
 
@@ -600,6 +1136,7 @@ DispatchStatus Connection::dispatch( ) {
 
     // Process any messages that we need to
     process_single_message();
+    schedule_buffer_trim();
 
     if( m_priv->m_outgoingMessages.empty() &&
         m_priv->m_incomingMessages.empty() ) {
@@ -611,6 +1148,252 @@ DispatchStatus Connection::dispatch( ) {
     return m_priv->m_dispatchStatus;
 }
 
+DispatchStatus Connection::dispatch_all( uint32_t max_messages, std::chrono::microseconds max_time ) {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + max_time;
+    uint32_t processed = 0;
+    bool budgetUsed = false;
+
+    if( std::this_thread::get_id() != m_priv->m_dispatchingThread ) {
+        throw ErrorIncorrectDispatchThread( "Calling Connection::dispatch_all from non-dispatching thread" );
+    }
+
+    // Connecting is done one step at a time, and dispatch() gives up on it
+    if( is_connecting() || !this->is_valid() ) {
+        return dispatch();
+    }
+
+    expire_pending_replies();
+    run_timers();
+
+    while( this->is_valid() ) {
+        flush();
+
+        std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
+
+        if( incoming ) {
+            m_priv->m_incomingMessages.push( incoming );
+        }
+
+        // Nothing more to read right now, and nothing left over from before
+        if( m_priv->m_incomingMessages.empty() ) {
+            break;
+        }
+
+        process_single_message();
+        processed++;
+
+        if( max_messages != 0 && processed >= max_messages ) {
+            budgetUsed = true;
+            break;
+        }
+
+        if( max_time != std::chrono::microseconds::zero() &&
+            std::chrono::steady_clock::now() >= deadline ) {
+            budgetUsed = true;
+            break;
+        }
+    }
+
+    flush();
+    schedule_buffer_trim();
+
+    SIMPLELOGGER_TRACE( LOGGER_NAME, "Dispatched " << processed << " messages" );
+
+    if( !this->is_valid() ) {
+        fail_pending_replies();
+        m_priv->m_dispatchStatus = DispatchStatus::COMPLETE;
+    } else if( budgetUsed ||
+        !m_priv->m_outgoingMessages.empty() ||
+        !m_priv->m_incomingMessages.empty() ) {
+        m_priv->m_dispatchStatus = DispatchStatus::DATA_REMAINS;
+    } else {
+        m_priv->m_dispatchStatus = DispatchStatus::COMPLETE;
+    }
+
+    return m_priv->m_dispatchStatus;
+}
+
+int Connection::next_timeout_milliseconds() const {
+    // Nothing is going to happen on a connection that is gone
+    if( !m_priv->m_connector && !this->is_valid() ) {
+        return -1;
+    }
+
+    std::chrono::steady_clock::rep next = std::min<std::chrono::steady_clock::rep>(
+        m_priv->m_nextReplyTimeout, m_priv->m_nextTimer );
+
+    if( is_connecting() ) {
+        next = std::min( next, m_priv->m_connectDeadline.time_since_epoch().count() );
+    }
+
+    if( next == priv_data::NO_REPLY_TIMEOUT ) {
+        return -1;
+    }
+
+    std::chrono::steady_clock::time_point when{ std::chrono::steady_clock::duration( next ) };
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if( when <= now ) {
+        return 0;
+    }
+
+    // Round up, so that we don't wake up just before it is time
+    std::chrono::milliseconds::rep ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>( when - now + std::chrono::milliseconds( 1 ) ).count();
+
+    return ms > std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : static_cast<int>( ms );
+}
+
+void Connection::call_at( std::chrono::steady_clock::time_point when, std::function<void()> func ) {
+    bool earliest;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_timersLock );
+        m_priv->m_timers.insert( std::make_pair( when, func ) );
+        earliest = when.time_since_epoch().count() < m_priv->m_nextTimer;
+        m_priv->m_nextTimer = m_priv->m_timers.begin()->first.time_since_epoch().count();
+    }
+
+    /*
+     * The dispatcher needs to wake up sooner than it was going to.  Tell it
+     * even on the dispatching thread: a dispatcher that is driven by another
+     * event loop only looks at next_timeout_milliseconds() when it is told to.
+     */
+    if( earliest ) {
+        m_priv->m_needsDispatching();
+    }
+}
+
+void Connection::run_timers() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::vector<std::function<void()>> due;
+
+    if( now.time_since_epoch().count() < m_priv->m_nextTimer ) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_timersLock );
+        std::multimap<std::chrono::steady_clock::time_point, std::function<void()>>::iterator it =
+            m_priv->m_timers.begin();
+
+        while( it != m_priv->m_timers.end() && it->first <= now ) {
+            due.push_back( std::move( it->second ) );
+            it = m_priv->m_timers.erase( it );
+        }
+
+        if( m_priv->m_timers.empty() ) {
+            m_priv->m_nextTimer = priv_data::NO_REPLY_TIMEOUT;
+        } else {
+            m_priv->m_nextTimer = m_priv->m_timers.begin()->first.time_since_epoch().count();
+        }
+    }
+
+    for( std::function<void()>& func : due ) {
+        func();
+    }
+}
+
+void Connection::schedule_buffer_trim() {
+    if( m_priv->m_bufferTrimScheduled ||
+        !this->is_valid() ||
+        !m_priv->m_transport->has_borrowed_buffers() ) {
+        return;
+    }
+
+    m_priv->m_bufferTrimScheduled = true;
+    call_at( std::chrono::steady_clock::now() + priv::BufferPool::instance().idle_timeout(),
+        [this]() { trim_buffers(); } );
+}
+
+void Connection::trim_buffers() {
+    std::chrono::steady_clock::time_point next;
+
+    m_priv->m_bufferTrimScheduled = false;
+
+    if( !this->is_valid() ) { return; }
+
+    {
+        std::unique_lock lock( m_priv->m_writeLock );
+        next = m_priv->m_transport->release_idle_buffers();
+    }
+
+    // Whatever we just gave back gets freed once it has sat in the pool for long enough
+    next = std::min( next, priv::BufferPool::instance().trim() );
+
+    if( next == std::chrono::steady_clock::time_point::max() ) { return; }
+
+    m_priv->m_bufferTrimScheduled = true;
+    call_at( next, [this]() { trim_buffers(); } );
+}
+
+void Connection::expire_pending_replies() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::vector<std::pair<uint32_t, std::shared_ptr<ExpectingResponse>>> expired;
+
+    if( now.time_since_epoch().count() < m_priv->m_nextReplyTimeout ) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
+
+        for( uint32_t serial : m_priv->m_replyTimeouts.expire( now ) ) {
+            std::unordered_map<uint32_t, std::shared_ptr<ExpectingResponse>>::iterator it =
+                m_priv->m_expectingResponses.find( serial );
+
+            if( it == m_priv->m_expectingResponses.end() ) { continue; }
+
+            expired.push_back( std::make_pair( serial, std::move( it->second ) ) );
+            m_priv->m_expectingResponses.erase( it );
+        }
+
+        m_priv->m_nextReplyTimeout = m_priv->m_replyTimeouts.next_expiry().time_since_epoch().count();
+    }
+
+    for( std::pair<uint32_t, std::shared_ptr<ExpectingResponse>>& entry : expired ) {
+        std::shared_ptr<ErrorMessage> error = ErrorMessage::create();
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "No reply received for serial " << entry.first );
+
+        error->set_name( DBUSCXX_ERROR_NO_REPLY );
+        error->set_message( "Did not receive a response in the alotted time" );
+        error->set_reply_serial( entry.first );
+
+        priv_data::complete_expecting_response( entry.second, error );
+    }
+}
+
+void Connection::fail_pending_replies() {
+    std::unordered_map<uint32_t, std::shared_ptr<ExpectingResponse>> waiting;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
+        waiting.swap( m_priv->m_expectingResponses );
+        m_priv->m_replyTimeouts.clear();
+        m_priv->m_nextReplyTimeout = priv_data::NO_REPLY_TIMEOUT;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_timersLock );
+        m_priv->m_timers.clear();
+        m_priv->m_nextTimer = priv_data::NO_REPLY_TIMEOUT;
+        m_priv->m_bufferTrimScheduled = false;
+    }
+
+    for( std::pair<const uint32_t, std::shared_ptr<ExpectingResponse>>& entry : waiting ) {
+        std::shared_ptr<ErrorMessage> error = ErrorMessage::create();
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Disconnected while waiting for reply to serial " << entry.first );
+
+        error->set_name( DBUSCXX_ERROR_DISCONNECTED );
+        error->set_message( "The connection was closed before a reply was received" );
+        error->set_reply_serial( entry.first );
+
+        priv_data::complete_expecting_response( entry.second, error );
+    }
+}
+
 void Connection::process_single_message() {
     std::shared_ptr<Message> msgToProcess;
 
@@ -629,15 +1412,14 @@ void Connection::process_single_message() {
             reply_serial = std::static_pointer_cast<ErrorMessage>( msgToProcess )->reply_serial();
         }
 
-        {
-            std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
-            if( m_priv->m_expectingResponses.find( reply_serial ) != m_priv->m_expectingResponses.end() ) {
-                // This is a response to something that a different thread is waiting for.
-                // Update the data and notify the thread!
-                m_priv->m_expectingResponses[ reply_serial ]->reply = msgToProcess;
-                m_priv->m_expectingResponses[ reply_serial ]->cv.notify_one();
-                return;
-            }
+        if( m_priv->m_helloSerial != 0 && reply_serial == m_priv->m_helloSerial ) {
+            process_hello_reply( msgToProcess );
+            return;
+        }
+
+        // This may be a response to something that a different thread is waiting for.
+        if( m_priv->complete_reply( msgToProcess ) ) {
+            return;
         }
     }
 
@@ -679,7 +1461,10 @@ void Connection::process_call_message( std::shared_ptr<const CallMessage> callms
         return;
     }
 
-    if( entry.handlingThread == m_priv->m_dispatchingThread ) {
+    if( entry.calling == ThreadForCalling::Pool ||
+        entry.calling == ThreadForCalling::PoolSerialized ) {
+        submit_to_call_pool( entry.handler, entry.strand, callmsg );
+    } else if( entry.handlingThread == m_priv->m_dispatchingThread ) {
         // We are in the dispatching thread here, so we can simply call the handle method
         HandlerResult res = entry.handler->handle_message( callmsg );
         send_error_on_handler_result( callmsg, res );
@@ -704,55 +1489,109 @@ void Connection::process_call_message( std::shared_ptr<const CallMessage> callms
 }
 
 void Connection::process_signal_message( std::shared_ptr<const SignalMessage> msg ) {
-    {
-        // See if any of our free handlers can handle this
-        std::unique_lock<std::mutex> lock( m_priv->m_freeProxySignalsLock );
+    // Only the signal proxies that may want this, and their threads, get to look at it
+    std::vector<priv::SignalRoutingTable::Route> routes;
+    std::vector<std::thread::id> otherThreads;
 
-        for( FreeSignalThreadInfo& sigInfo : m_priv->m_freeProxySignals ) {
-            if( sigInfo.handlingThread != m_priv->m_dispatchingThread ){
-                continue;
-            }
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_signalRoutesLock );
+        m_priv->m_signalRoutes.find( msg->interface_name(), msg->member(), msg->path(), routes );
+    }
 
-            sigInfo.handler->handle_signal( msg );
+    for( priv::SignalRoutingTable::Route& route : routes ){
+        if( route.thread == m_priv->m_dispatchingThread ){
+            route.proxy->handle_signal( msg );
+        } else if( std::find( otherThreads.begin(), otherThreads.end(), route.thread ) == otherThreads.end() ) {
+            otherThreads.push_back( route.thread );
         }
     }
 
-    std::vector<std::shared_ptr<SignalProxyBase>> proxies;
+    if( otherThreads.empty() ) { return; }
+
+    // Give this signal to the ThreadDispatchers that have a proxy that may want it
     {
-        // Tell all of our normal ObjectProxy classes to handle it as well
-        std::unique_lock lock( m_priv->m_objectProxiesLock );
+        std::unique_lock<std::mutex> lock( m_priv->m_threadDispatcherLock );
 
-        for( ObjectProxyThreadInfo& thrInfo : m_priv->m_objectProxies ){
-            if( thrInfo.handlingThread != m_priv->m_dispatchingThread ){
-                continue;
-            }
+        for( std::thread::id thread : otherThreads ) {
+            std::map<std::thread::id, std::weak_ptr<ThreadDispatcher>>::iterator it =
+                m_priv->m_threadDispatchers.find( thread );
 
-            for( std::pair<std::string,std::shared_ptr<InterfaceProxy>> iface : thrInfo.handler->interfaces() ){
-                for( std::shared_ptr<SignalProxyBase> signal : iface.second->signals() ){
-                    proxies.push_back( signal );
-                }
+            if( it == m_priv->m_threadDispatchers.end() ) { continue; }
+
+            std::shared_ptr<ThreadDispatcher> disp = it->second.lock();
+
+            if( disp ) {
+                disp->add_signal( msg );
             }
         }
     }
+}
+
+
+void Connection::add_object_signal_routes( const ObjectProxy* object,
+    const std::vector<std::shared_ptr<SignalProxyBase>>& signals ) {
+    std::unique_lock lock( m_priv->m_objectProxiesLock );
 
-    for( std::shared_ptr<SignalProxyBase> proxyBase : proxies ){
-        proxyBase->handle_signal( msg );
+    for( ObjectProxyThreadInfo& thrInfo : m_priv->m_objectProxies ){
+        if( thrInfo.handler.get() != object ){
+            continue;
+        }
+
+        // Signals for an object on another thread are given to it by its ThreadDispatcher
+        if( thrInfo.handlingThread != m_priv->m_dispatchingThread ){
+            return;
+        }
+
+        std::unique_lock<std::mutex> routesLock( m_priv->m_signalRoutesLock );
+
+        for( std::shared_ptr<SignalProxyBase> signal : signals ){
+            m_priv->m_signalRoutes.add( signal, m_priv->m_dispatchingThread );
+        }
+
+        return;
     }
+}
 
-    // Give this signal to all of our ThreadDispatchers as well
-    {
-        std::unique_lock<std::mutex> lock( m_priv->m_threadDispatcherLock );
+void Connection::remove_signal_routes( const std::vector<std::shared_ptr<SignalProxyBase>>& signals ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_signalRoutesLock );
 
-        for( auto const& x : m_priv->m_threadDispatchers ) {
-            std::shared_ptr<ThreadDispatcher> disp = x.second.lock();
+    for( std::shared_ptr<SignalProxyBase> signal : signals ){
+        m_priv->m_signalRoutes.remove( signal );
+    }
+}
 
-            if( disp ) {
-                disp->add_signal( msg );
+void Connection::update_signal_route( const SignalBase* signal ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_signalRoutesLock );
+
+    m_priv->m_signalRoutes.update( signal );
+}
+
+void Connection::rebuild_signal_routes() {
+    // Nothing can be added or removed while we go through everything
+    std::unique_lock<std::mutex> freeLock( m_priv->m_freeProxySignalsLock );
+    std::unique_lock<std::mutex> objectLock( m_priv->m_objectProxiesLock );
+    std::unique_lock<std::mutex> routesLock( m_priv->m_signalRoutesLock );
+
+    m_priv->m_signalRoutes.clear();
+
+    for( FreeSignalThreadInfo& sigInfo : m_priv->m_freeProxySignals ) {
+        m_priv->m_signalRoutes.add( sigInfo.handler, sigInfo.handlingThread );
+    }
+
+    for( ObjectProxyThreadInfo& thrInfo : m_priv->m_objectProxies ){
+        if( thrInfo.handlingThread != m_priv->m_dispatchingThread ){
+            continue;
+        }
+
+        for( const std::pair<const std::string,std::shared_ptr<InterfaceProxy>>& iface : thrInfo.handler->interfaces() ){
+            for( std::shared_ptr<SignalProxyBase> signal : iface.second->signals() ){
+                m_priv->m_signalRoutes.add( signal, m_priv->m_dispatchingThread );
             }
         }
     }
-}
 
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Routing signals to " << m_priv->m_signalRoutes.size() << " signal proxies" );
+}
 
 void Connection::send_error_on_handler_result( std::shared_ptr<const CallMessage> callmsg, HandlerResult result ) {
     if( result == HandlerResult::Handled ) {
@@ -794,6 +1633,8 @@ void Connection::send_error_on_handler_result( std::shared_ptr<const CallMessage
 }
 
 int Connection::unix_fd() const {
+    if( m_priv->m_connector ) { return m_priv->m_connector->fd(); }
+
     if( !this->is_valid() ) { return -1; }
 
     return m_priv->m_transport->fd();
@@ -840,12 +1681,7 @@ RegistrationStatus Connection::register_object( std::shared_ptr<Object> object,
 
     PathHandlingEntry entry;
     entry.handler = object;
-
-    if( calling == ThreadForCalling::DispatcherThread ) {
-        entry.handlingThread = m_priv->m_dispatchingThread;
-    } else {
-        entry.handlingThread = std::this_thread::get_id();
-    }
+    set_path_handling_calling( entry, calling, m_priv->m_dispatchingThread );
 
     m_priv->m_path_handler[ object->path() ] = entry;
 
@@ -864,11 +1700,7 @@ bool Connection::change_object_calling_thread( std::shared_ptr<Object> object,
     }
 
     PathHandlingEntry entry = it->second;
-    if( calling == ThreadForCalling::DispatcherThread ) {
-        entry.handlingThread = m_priv->m_dispatchingThread;
-    } else {
-        entry.handlingThread = std::this_thread::get_id();
-    }
+    set_path_handling_calling( entry, calling, m_priv->m_dispatchingThread );
     m_priv->m_path_handler[ object->path() ] = entry;
 
     return true;
@@ -912,8 +1744,10 @@ std::shared_ptr<SignalProxyBase> Connection::add_free_signal_proxy( std::shared_
 
     {
         std::unique_lock<std::mutex> lock( m_priv->m_freeProxySignalsLock );
+        std::unique_lock<std::mutex> routesLock( m_priv->m_signalRoutesLock );
 
         m_priv->m_freeProxySignals.push_back( signalThreadinfo );
+        m_priv->m_signalRoutes.add( signal, signalThreadinfo.handlingThread );
     }
 
     if( signalThreadinfo.handlingThread != m_priv->m_dispatchingThread ) {
@@ -937,7 +1771,7 @@ std::shared_ptr<SignalProxyBase> Connection::add_free_signal_proxy( std::shared_
         thrDispatch->add_signal_proxy( signal );
     }
 
-    this->add_match( signal->match_rule() );
+    this->add_match_nonblocking( signal->match_rule() );
     signal->set_connection( shared_from_this() );
 
     return signal;
@@ -965,7 +1799,10 @@ bool Connection::remove_free_signal_proxy( std::shared_ptr<SignalProxyBase> sign
         }
 
         if( it != m_priv->m_freeProxySignals.end() ) {
+            std::unique_lock<std::mutex> routesLock( m_priv->m_signalRoutesLock );
+
             m_priv->m_freeProxySignals.erase( it );
+            m_priv->m_signalRoutes.remove( signal );
             removed = true;
         }
     }
@@ -1044,7 +1881,12 @@ std::string Connection::introspect( const std::string& destination, const std::s
 }
 
 void Connection::set_dispatching_thread( std::thread::id tid ) {
+    if( m_priv->m_dispatchingThread == tid ) { return; }
+
     m_priv->m_dispatchingThread = tid;
+
+    // Which object proxies get their signals from us depends on the thread
+    rebuild_signal_routes();
 }
 
 void Connection::notify_dispatcher_or_dispatch() {
@@ -1106,6 +1948,18 @@ bool Connection::change_object_proxy_calling_thread( std::shared_ptr<ObjectProxy
                 thrInfo.handlingThread = m_priv->m_dispatchingThread;
             }
 
+            std::unique_lock<std::mutex> routesLock( m_priv->m_signalRoutesLock );
+
+            for( const std::pair<const std::string,std::shared_ptr<InterfaceProxy>>& iface : object->interfaces() ){
+                for( std::shared_ptr<SignalProxyBase> signal : iface.second->signals() ){
+                    if( thrInfo.handlingThread == m_priv->m_dispatchingThread ){
+                        m_priv->m_signalRoutes.add( signal, m_priv->m_dispatchingThread );
+                    } else {
+                        m_priv->m_signalRoutes.remove( signal );
+                    }
+                }
+            }
+
             return true;
         }
     }
@@ -1122,9 +1976,54 @@ bool Connection::register_object_proxy( std::shared_ptr<ObjectProxy> obj, Thread
 
     m_priv->m_objectProxies.push_back( newInfo );
 
+    if( newInfo.handlingThread != m_priv->m_dispatchingThread ) { return true; }
+
+    std::unique_lock<std::mutex> routesLock( m_priv->m_signalRoutesLock );
+
+    for( const std::pair<const std::string,std::shared_ptr<InterfaceProxy>>& iface : obj->interfaces() ){
+        for( std::shared_ptr<SignalProxyBase> signal : iface.second->signals() ){
+            m_priv->m_signalRoutes.add( signal, m_priv->m_dispatchingThread );
+        }
+    }
+
     return true;
 }
 
+void Connection::set_call_pool( std::shared_ptr<CallPool> pool ) {
+    std::atomic_store( &m_priv->m_callPool, pool );
+}
+
+std::shared_ptr<CallPool> Connection::call_pool() {
+    std::shared_ptr<CallPool> pool = std::atomic_load( &m_priv->m_callPool );
+
+    if( !pool ) {
+        pool = CallPool::default_pool();
+    }
+
+    return pool;
+}
+
+void Connection::submit_to_call_pool( std::shared_ptr<Object> handler,
+                                      std::shared_ptr<CallPool::Strand> strand,
+                                      std::shared_ptr<const CallMessage> msg ) {
+    std::weak_ptr<Connection> weak_conn = shared_from_this();
+    std::function<void()> task = [weak_conn, handler, msg]() {
+        std::shared_ptr<Connection> conn = weak_conn.lock();
+
+        if( !conn ) { return; }
+
+        // The reply is queued by send(), which is safe from any thread
+        HandlerResult res = handler->handle_message( msg );
+        conn->send_error_on_handler_result( msg, res );
+    };
+
+    if( strand ) {
+        call_pool()->submit( strand, std::move( task ) );
+    } else {
+        call_pool()->submit( std::move( task ) );
+    }
+}
+
 std::thread::id Connection::thread_id_from_calling( ThreadForCalling calling ){
     if( calling == ThreadForCalling::CurrentThread ){
         return std::this_thread::get_id();
@@ -13,6 +13,9 @@
 #include <dbus-cxx/threaddispatcher.h>
 #include <dbus-cxx/errormessage.h>
 #include <dbus-cxx/dbus-cxx-config.h>
+#include <dbus-cxx/callpool.h>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <map>
 #include <memory>
@@ -58,9 +61,12 @@ class Watch;
 class ThreadDispatcher;
 class ErrorMessage;
 class DBusDaemonProxy;
+class Server;
+class CallPool;
 
 namespace priv {
 class Transport;
+class TransportConnector;
 }
 
 /**
@@ -77,6 +83,16 @@ private:
 
     Connection( std::string address );
 
+    Connection( std::shared_ptr<priv::Transport> transport );
+
+    Connection( std::shared_ptr<priv::TransportConnector> connector );
+
+    friend class Server;
+    friend class InterfaceProxy;
+    friend class ObjectProxy;
+    friend class SignalBase;
+    friend class Interface;
+
 public:
     /**
      * Connects to a bus daemon.  The returned Connection will have authenticated
@@ -99,6 +115,52 @@ public:
      */
     static std::shared_ptr<Connection> create( std::string address );
 
+    /**
+     * Create a new peer-to-peer connection to the server at the specified address.
+     * The server on the other side must be a Server(or any other DBus peer that
+     * accepts direct connections), not a bus daemon.
+     *
+     * Since there is no bus daemon, the returned connection is considered to be
+     * registered already: Hello is never sent, there is no unique name, and bus
+     * methods such as request_name() will throw ErrorNotSupported.
+     *
+     * @param address The address of the server, e.g. unix:path=/tmp/dbus-test
+     * @return
+     */
+    static std::shared_ptr<Connection> create_peer( std::string address );
+
+    /**
+     * Start connecting to a bus daemon without blocking.
+     *
+     * The returned Connection is not valid yet; is_connecting() will return
+     * true until the connection, authentication and registration with the
+     * bus have all finished.  All of this is driven by dispatch(), so the
+     * Connection must be added to a Dispatcher.  Once it has finished,
+     * signal_connected() is emitted from the dispatching thread.  If it has
+     * not finished in time, the connection is closed and signal_connected()
+     * is emitted with false.
+     *
+     * This allows many connections to be started at once, and a bus daemon
+     * that does not respond will not block the calling thread.
+     *
+     * @param type The bus to connect to
+     * @param timeout_milliseconds How long connecting may take, registering
+     * with the bus included.  If -1, the same default as send_with_reply_blocking()
+     * @return The connection.  If it could not even start connecting, it is
+     * neither valid nor connecting.
+     */
+    static std::shared_ptr<Connection> create_async( BusType type, int timeout_milliseconds = -1 );
+
+    /**
+     * Start connecting to the given address without blocking.
+     *
+     * @see create_async( BusType )
+     *
+     * @param address The address, in DBus transport format
+     * @param timeout_milliseconds How long connecting may take
+     */
+    static std::shared_ptr<Connection> create_async( std::string address, int timeout_milliseconds = -1 );
+
     ~Connection();
 
     /** True if this is a valid connection; false otherwise */
@@ -110,6 +172,30 @@ public:
     /** True if this connection is already registered */
     bool is_registered() const;
 
+    /** True if this is a peer-to-peer connection, not a connection to a bus */
+    bool is_peer() const;
+
+    /**
+     * True if this connection was created with create_async() and has not
+     * finished connecting yet.
+     */
+    bool is_connecting() const;
+
+    /**
+     * True if we are connecting, and are waiting for unix_fd() to become
+     * writable instead of readable.  Used by the Dispatcher.
+     */
+    bool connect_wants_write() const;
+
+    /**
+     * Emitted once a connection created with create_async() has finished
+     * connecting.  The parameter is true if we are connected and registered
+     * with the bus, false if connecting failed.
+     *
+     * This is emitted from the dispatching thread.
+     */
+    sigc::signal<void(bool)>& signal_connected();
+
     /**
      * Registers this connection with the bus.  It is safe to call this
      * method multiple times.
@@ -161,12 +247,44 @@ public:
      */
     StartReply start_service( const std::string& name, uint32_t flags = 0 ) const;
 
+    /**
+     * Ask the bus to send us messages that match the given rule.
+     *
+     * Rules are reference counted: the bus is only asked for a rule the
+     * first time it is added.  Anybody else adding the rule waits for that
+     * first answer.  Each call must be balanced by a call to remove_match().
+     * If the bus refuses the rule, it is forgotten, and the next call asks
+     * the bus again.  On a peer-to-peer connection there is no bus to ask,
+     * so this does nothing and returns true.
+     *
+     * @return True if the bus has the rule, or this is a peer-to-peer connection
+     */
     bool add_match( const std::string& rule );
 
+    /**
+     * Like add_match(), but never waits for the bus to reply.  Any number
+     * of rules may be added this way; the requests go out together the
+     * next time the connection writes.  If the bus rejects a rule,
+     * signal_match_rule_error() is emitted.
+     */
     void add_match_nonblocking( const std::string& rule );
 
+    /**
+     * Drop one reference to the given rule, telling the bus to forget it
+     * once nobody is using it anymore.  This does not wait for the bus.
+     *
+     * @return False if the rule was not added
+     */
     bool remove_match( const std::string& rule );
 
+    /**
+     * Emitted when the bus refuses to add or remove a match rule.  The
+     * parameters are the rule and the error that the bus gave back.
+     *
+     * This is emitted from the dispatching thread.
+     */
+    sigc::signal<void(std::string, std::string)>& signal_match_rule_error();
+
     bool is_connected() const;
 
     bool is_authenticated() const;
@@ -183,6 +301,16 @@ public:
      */
     uint32_t send( const std::shared_ptr<const Message> message );
 
+    /**
+     * Queues up all of the messages to be sent on the bus, in order.  The
+     * dispatcher is only woken up once, so the messages are written out
+     * together.
+     *
+     * @param messages The messages to send
+     * @return The serials of the messages, in the same order as the messages
+     */
+    std::vector<uint32_t> send_batch( const std::vector<std::shared_ptr<const Message>>& messages );
+
     /**
      * Blindly sends the message on the connection.  Since you don't get any kind of handle
      * back from this, you should really only use it for sending method returns and signals.
@@ -200,6 +328,53 @@ public:
      */
     std::shared_ptr<ReturnMessage> send_with_reply_blocking( std::shared_ptr<const CallMessage> msg, int timeout_milliseconds = -1 );
 
+    /**
+     * Send a CallMessage, and return without waiting for the reply.
+     *
+     * The reply is handed to the PendingCall from the dispatching thread
+     * when it comes in.  If it does not come in on time, the PendingCall
+     * gets an ErrorMessage for ErrorNoReply instead.
+     *
+     * @param msg The message to send
+     * @param timeout_milliseconds How long to wait for.  If -1, will wait the maximum time
+     * @param callback Called from the dispatching thread once the reply(or timeout) is in
+     * @return The pending call
+     */
+    std::shared_ptr<PendingCall> send_with_reply_async( std::shared_ptr<const CallMessage> msg,
+        int timeout_milliseconds = -1,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} );
+
+    /**
+     * Send a batch of CallMessages all at once, and return without waiting
+     * for the replies.  The calls are written out together, so this costs
+     * one round trip instead of one per call.
+     *
+     * @param messages The messages to send
+     * @param timeout_milliseconds How long to wait for each reply.  If -1, will wait the maximum time
+     * @param callback Called from the dispatching thread as each reply(or timeout) comes in
+     * @return The pending calls, in the same order as the messages
+     */
+    std::vector<std::shared_ptr<PendingCall>> send_with_reply_batch_async(
+        const std::vector<std::shared_ptr<const CallMessage>>& messages,
+        int timeout_milliseconds = -1,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} );
+
+    /**
+     * Send a batch of CallMessages all at once, and wait for all of the replies.
+     * This may be called from the dispatching thread.
+     *
+     * Unlike send_with_reply_blocking(), this does not throw if a call fails;
+     * each reply is either a ReturnMessage or an ErrorMessage(with the name
+     * DBUSCXX_ERROR_NO_REPLY if the call timed out).
+     *
+     * @param messages The messages to send
+     * @param timeout_milliseconds How long to wait for.  If -1, will wait the maximum time
+     * @return The replies, in the same order as the messages
+     */
+    std::vector<std::shared_ptr<Message>> send_with_reply_batch(
+        const std::vector<std::shared_ptr<const CallMessage>>& messages,
+        int timeout_milliseconds = -1 );
+
     /**
      * Flushes all data out to the bus.  This should generally
      * be called from the dispatching thread, but it should be
@@ -225,6 +400,36 @@ public:
      */
     DispatchStatus dispatch( );
 
+    /**
+     * Dispatch the connection until there is nothing left to do, or until
+     * the given budget runs out.  This writes out all pending messages,
+     * then reads and processes every message that is available without
+     * blocking, instead of stopping after one message like dispatch() does.
+     *
+     * Like dispatch(), this may only be called from the dispatching thread.
+     *
+     * @param max_messages The most messages to process in this call.  If 0,
+     * there is no limit.
+     * @param max_time How long to keep processing messages for.  This is
+     * checked after each message, so one long-running handler may go over.
+     * If 0, there is no limit.
+     * @return DispatchStatus::COMPLETE if everything that could be read has
+     * been processed, or DispatchStatus::DATA_REMAINS if the budget ran out first.
+     */
+    DispatchStatus dispatch_all( uint32_t max_messages = 0,
+                                 std::chrono::microseconds max_time = std::chrono::microseconds::zero() );
+
+    /**
+     * How long until a call that is waiting for a reply times out, or until
+     * a signal that was held back by its EmissionMode must go out.  When that
+     * time comes, dispatch() or dispatch_all() must be called.  Dispatchers
+     * should wake up after this long even if there is nothing to read.
+     *
+     * @return The number of milliseconds until the next timeout, 0 if one is
+     * already due, or -1 if nothing is waiting or the connection is closed
+     */
+    int next_timeout_milliseconds() const;
+
     int unix_fd() const;
 
     int socket() const;
@@ -388,6 +593,20 @@ public:
      */
     void add_thread_dispatcher( std::weak_ptr<ThreadDispatcher> disp );
 
+    /**
+     * Set the pool that methods on objects registered with ThreadForCalling::Pool
+     * or ThreadForCalling::PoolSerialized are called on.  By default, this is
+     * CallPool::default_pool().
+     *
+     * @param pool The pool to use.  If null, the default pool is used.
+     */
+    void set_call_pool( std::shared_ptr<CallPool> pool );
+
+    /**
+     * The pool that methods on pooled objects are called on.
+     */
+    std::shared_ptr<CallPool> call_pool();
+
 private:
     /**
      * Depending on what thread this is called from,
@@ -396,16 +615,102 @@ private:
      */
     void notify_dispatcher_or_dispatch();
 
+    void process_single_message();
+
+    /**
+     * Start routing signals to signal proxies that have been added to an
+     * ObjectProxy, if that ObjectProxy handles signals on the dispatching thread.
+     */
+    void add_object_signal_routes( const ObjectProxy* object,
+                                   const std::vector<std::shared_ptr<SignalProxyBase>>& signals );
+
+    /**
+     * Stop routing signals to these signal proxies.
+     */
+    void remove_signal_routes( const std::vector<std::shared_ptr<SignalProxyBase>>& signals );
+
+    /**
+     * Tell the connection that a signal proxy has changed what it listens
+     * for, so that signals keep getting routed to it.
+     */
+    void update_signal_route( const SignalBase* signal );
+
+    /**
+     * Rebuild the signal routing table from the proxies that we have.  Only
+     * needed when the dispatching thread changes.
+     */
+    void rebuild_signal_routes();
+
+    /**
+     * Get ready to send all of the messages, expecting replies to them.
+     * The dispatcher is not notified.
+     */
+    std::vector<std::shared_ptr<PendingCall>> queue_calls(
+        const std::vector<std::shared_ptr<const CallMessage>>& messages,
+        int timeout_milliseconds,
+        std::function<void( std::shared_ptr<PendingCall> )> callback );
+
     /**
-     * Write a single message, return the serial of this message.
-     * This should me called with a lock on m_outgoingLock
+     * Update the reference count of the rule, and queue up the call to the
+     * bus if this was the first reference added or the last one removed.
      *
-     * @param msg
-     * @return
+     * @return The AddMatch call for the rule when adding, even if it was
+     * made by somebody else; the RemoveMatch call if it was needed; null
+     * otherwise
      */
-    uint32_t write_single_message( std::shared_ptr<const Message> msg );
+    std::shared_ptr<PendingCall> update_match( const std::string& rule, bool add );
 
-    void process_single_message();
+    /**
+     * Write and read on the dispatching thread until done() says that the
+     * replies that we are waiting for are in.
+     */
+    void wait_for_replies_on_dispatching_thread( std::function<bool()> done );
+
+    /**
+     * Give ErrorNoReply to every call whose reply has not come in on time.
+     */
+    void expire_pending_replies();
+
+    /**
+     * Call func from the dispatching thread once the given time has come.
+     * This is used to send out emissions that were held back.
+     */
+    void call_at( std::chrono::steady_clock::time_point when, std::function<void()> func );
+
+    /**
+     * Call everything passed to call_at() whose time has come.
+     */
+    void run_timers();
+
+    /**
+     * If the transport has borrowed a large buffer, make sure that a timer
+     * is going to give it back once it is no longer needed.
+     */
+    void schedule_buffer_trim();
+
+    /**
+     * Give the idle buffers back to the pool, and let the pool free its
+     * own idle buffers.  Runs from a timer for as long as anything is left.
+     */
+    void trim_buffers();
+
+    /**
+     * Once the connection is gone, give ErrorDisconnected to every call that
+     * is still waiting for a reply, and forget about all of the timers.
+     */
+    void fail_pending_replies();
+
+    /**
+     * Drive an asynchronous connection along.  Called from dispatch()
+     */
+    void continue_connecting();
+
+    /**
+     * Give up on an asynchronous connection: close it, and tell everybody.
+     */
+    void fail_connecting();
+
+    void process_hello_reply( std::shared_ptr<Message> reply );
 
     void remove_invalid_threaddispatchers_and_associated_objects();
 
@@ -421,6 +726,14 @@ private:
 
     std::thread::id thread_id_from_calling( ThreadForCalling calling );
 
+    /**
+     * Call the given object on the call pool, and send its reply(or error)
+     * from there.
+     */
+    void submit_to_call_pool( std::shared_ptr<Object> handler,
+                              std::shared_ptr<CallPool::Strand> strand,
+                              std::shared_ptr<const CallMessage> msg );
+
 private:
     class priv_data;
 
@@ -12,29 +12,18 @@
 
 using DBus::Demarshaling;
 
-class Demarshaling::priv_data {
-public:
-    priv_data() :
-        m_data( nullptr ),
-        m_dataLen( 0 ),
-        m_dataPos( 0 ),
-        m_endian( Endianess::Big ) {}
-
-    const uint8_t* m_data;
-    uint32_t m_dataLen;
-    uint32_t m_dataPos;
-    Endianess m_endian;
-};
-
-Demarshaling::Demarshaling() {
-    m_priv = std::make_unique<priv_data>();
+Demarshaling::Demarshaling() :
+    m_data( nullptr ),
+    m_dataLen( 0 ),
+    m_dataPos( 0 ),
+    m_endian( Endianess::Big ) {
 }
 
-Demarshaling::Demarshaling( const uint8_t* data, uint32_t dataLen, Endianess endian ) {
-    m_priv = std::make_unique<priv_data>();
-    m_priv->m_data = data;
-    m_priv->m_dataLen = dataLen;
-    m_priv->m_endian = endian;
+Demarshaling::Demarshaling( const uint8_t* data, uint32_t dataLen, Endianess endian ) :
+    m_data( data ),
+    m_dataLen( dataLen ),
+    m_dataPos( 0 ),
+    m_endian( endian ) {
 }
 
 Demarshaling::~Demarshaling() {
@@ -42,7 +31,7 @@ Demarshaling::~Demarshaling() {
 
 uint8_t Demarshaling::demarshal_uint8_t() {
     is_valid( 1 );
-    return m_priv->m_data[m_priv->m_dataPos++];
+    return m_data[m_dataPos++];
 }
 
 bool Demarshaling::demarshal_boolean() {
@@ -56,7 +45,7 @@ bool Demarshaling::demarshal_boolean() {
 }
 
 int16_t Demarshaling::demarshal_int16_t() {
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         return demarshalShortLittle();
     } else {
         return demarshalShortBig();
@@ -64,7 +53,7 @@ int16_t Demarshaling::demarshal_int16_t() {
 }
 
 uint16_t Demarshaling::demarshal_uint16_t() {
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         return static_cast<uint16_t>( demarshalShortLittle() );
     } else {
         return static_cast<uint16_t>( demarshalShortBig() );
@@ -72,7 +61,7 @@ uint16_t Demarshaling::demarshal_uint16_t() {
 }
 
 int32_t Demarshaling::demarshal_int32_t() {
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         return demarshalIntLittle();
     } else {
         return demarshalIntBig();
@@ -80,7 +69,7 @@ int32_t Demarshaling::demarshal_int32_t() {
 }
 
 uint32_t Demarshaling::demarshal_uint32_t() {
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         return static_cast<uint32_t>( demarshalIntLittle() );
     } else {
         return static_cast<uint32_t>( demarshalIntBig() );
@@ -88,7 +77,7 @@ uint32_t Demarshaling::demarshal_uint32_t() {
 }
 
 int64_t Demarshaling::demarshal_int64_t() {
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         return demarshalLongLittle();
     } else {
         return demarshalLongBig();
@@ -96,7 +85,7 @@ int64_t Demarshaling::demarshal_int64_t() {
 }
 
 uint64_t Demarshaling::demarshal_uint64_t() {
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         return static_cast<uint64_t>( demarshalLongLittle() );
     } else {
         return static_cast<uint64_t>( demarshalLongBig() );
@@ -107,7 +96,7 @@ double Demarshaling::demarshal_double() {
     double ret;
     int64_t val;
 
-    if( m_priv->m_endian == Endianess::Little ) {
+    if( m_endian == Endianess::Little ) {
         val = demarshalLongLittle();
     } else {
         val = demarshalLongBig();
@@ -121,10 +110,10 @@ double Demarshaling::demarshal_double() {
 std::string Demarshaling::demarshal_string() {
     uint32_t len = demarshal_uint32_t();
     is_valid( len + 1 );
-    const char* start = reinterpret_cast<const char*>( m_priv->m_data + m_priv->m_dataPos );
+    const char* start = reinterpret_cast<const char*>( m_data + m_dataPos );
     std::string ret = std::string( start, len );
 
-    m_priv->m_dataPos += len + 1;
+    m_dataPos += len + 1;
 
     return ret;
 }
@@ -138,10 +127,10 @@ DBus::Path Demarshaling::demarshal_path() {
 
 DBus::Signature Demarshaling::demarshal_signature() {
     uint8_t len = demarshal_uint8_t();
-    const char* start = reinterpret_cast<const char*>( m_priv->m_data + m_priv->m_dataPos );
+    const char* start = reinterpret_cast<const char*>( m_data + m_dataPos );
     std::string asStr = std::string( start, len );
 
-    m_priv->m_dataPos += len + 1;
+    m_dataPos += len + 1;
 
     return Signature( asStr );
 }
@@ -214,11 +203,11 @@ int16_t Demarshaling::demarshalShortBig() {
     align( 2 );
     is_valid( 2 );
 
-    ret = ( ( m_priv->m_data[ m_priv->m_dataPos ] & 0xFF ) << 8 ) |
-        ( ( m_priv->m_data[ m_priv->m_dataPos + 1 ] & 0xFF ) << 0 );
+    ret = ( ( m_data[ m_dataPos ] & 0xFF ) << 8 ) |
+        ( ( m_data[ m_dataPos + 1 ] & 0xFF ) << 0 );
 
 
-    m_priv->m_dataPos += 2;
+    m_dataPos += 2;
 
     return ret;
 }
@@ -228,10 +217,10 @@ int16_t Demarshaling::demarshalShortLittle() {
     align( 2 );
     is_valid( 2 );
 
-    ret = ( ( m_priv->m_data[ m_priv->m_dataPos ] & 0xFF ) << 0 ) |
-        ( ( m_priv->m_data[ m_priv->m_dataPos + 1 ] & 0xFF ) << 8 );
+    ret = ( ( m_data[ m_dataPos ] & 0xFF ) << 0 ) |
+        ( ( m_data[ m_dataPos + 1 ] & 0xFF ) << 8 );
 
-    m_priv->m_dataPos += 2;
+    m_dataPos += 2;
 
     return ret;
 }
@@ -241,12 +230,12 @@ int32_t Demarshaling::demarshalIntBig() {
     align( 4 );
     is_valid( 4 );
 
-    ret = static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos ] ) << 24  |
-        static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos + 1 ] ) << 16 |
-        static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos + 2 ] ) << 8 |
-        static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos + 3 ] ) << 0 ;
+    ret = static_cast<int32_t>( m_data[ m_dataPos ] ) << 24  |
+        static_cast<int32_t>( m_data[ m_dataPos + 1 ] ) << 16 |
+        static_cast<int32_t>( m_data[ m_dataPos + 2 ] ) << 8 |
+        static_cast<int32_t>( m_data[ m_dataPos + 3 ] ) << 0 ;
 
-    m_priv->m_dataPos += 4;
+    m_dataPos += 4;
 
     return ret;
 }
@@ -256,12 +245,12 @@ int32_t Demarshaling::demarshalIntLittle() {
     align( 4 );
     is_valid( 4 );
 
-    ret = static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos ] ) << 0  |
-        static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos + 1 ] ) << 8 |
-        static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos + 2 ] ) << 16 |
-        static_cast<int32_t>( m_priv->m_data[ m_priv->m_dataPos + 3 ] ) << 24 ;
+    ret = static_cast<int32_t>( m_data[ m_dataPos ] ) << 0  |
+        static_cast<int32_t>( m_data[ m_dataPos + 1 ] ) << 8 |
+        static_cast<int32_t>( m_data[ m_dataPos + 2 ] ) << 16 |
+        static_cast<int32_t>( m_data[ m_dataPos + 3 ] ) << 24 ;
 
-    m_priv->m_dataPos += 4;
+    m_dataPos += 4;
 
     return ret;
 }
@@ -271,16 +260,16 @@ int64_t Demarshaling::demarshalLongBig() {
     align( 8 );
     is_valid( 8 );
 
-    ret = static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos ] ) << 56 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 1 ] ) << 48 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 2 ] ) << 40 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 3 ] ) << 32 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 4 ] ) << 24 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 5 ] ) << 16 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 6 ] ) << 8 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 7 ] ) << 0 ;
+    ret = static_cast<int64_t>( m_data[ m_dataPos ] ) << 56 |
+        static_cast<int64_t>( m_data[ m_dataPos + 1 ] ) << 48 |
+        static_cast<int64_t>( m_data[ m_dataPos + 2 ] ) << 40 |
+        static_cast<int64_t>( m_data[ m_dataPos + 3 ] ) << 32 |
+        static_cast<int64_t>( m_data[ m_dataPos + 4 ] ) << 24 |
+        static_cast<int64_t>( m_data[ m_dataPos + 5 ] ) << 16 |
+        static_cast<int64_t>( m_data[ m_dataPos + 6 ] ) << 8 |
+        static_cast<int64_t>( m_data[ m_dataPos + 7 ] ) << 0 ;
 
-    m_priv->m_dataPos += 8;
+    m_dataPos += 8;
 
     return ret;
 }
@@ -290,47 +279,47 @@ int64_t Demarshaling::demarshalLongLittle() {
     align( 8 );
     is_valid( 8 );
 
-    ret = static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos ] ) << 0 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 1 ] ) << 8 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 2 ] ) << 16 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 3 ] ) << 24 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 4 ] ) << 32 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 5 ] ) << 40 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 6 ] ) << 48 |
-        static_cast<int64_t>( m_priv->m_data[ m_priv->m_dataPos + 7 ] ) << 56 ;
+    ret = static_cast<int64_t>( m_data[ m_dataPos ] ) << 0 |
+        static_cast<int64_t>( m_data[ m_dataPos + 1 ] ) << 8 |
+        static_cast<int64_t>( m_data[ m_dataPos + 2 ] ) << 16 |
+        static_cast<int64_t>( m_data[ m_dataPos + 3 ] ) << 24 |
+        static_cast<int64_t>( m_data[ m_dataPos + 4 ] ) << 32 |
+        static_cast<int64_t>( m_data[ m_dataPos + 5 ] ) << 40 |
+        static_cast<int64_t>( m_data[ m_dataPos + 6 ] ) << 48 |
+        static_cast<int64_t>( m_data[ m_dataPos + 7 ] ) << 56 ;
 
-    m_priv->m_dataPos += 8;
+    m_dataPos += 8;
 
     return ret;
 }
 
 void Demarshaling::is_valid( uint32_t bytesWanted ) {
-    assert( m_priv->m_data != nullptr );
-    assert( ( m_priv->m_dataPos + bytesWanted ) <= m_priv->m_dataLen );
+    assert( m_data != nullptr );
+    assert( ( m_dataPos + bytesWanted ) <= m_dataLen );
 }
 
 void Demarshaling::align( int alignment ) {
     if( alignment == 0 ){
         return;
     }
-    int bytesToAlign = alignment - ( m_priv->m_dataPos % alignment );
+    int bytesToAlign = alignment - ( m_dataPos % alignment );
 
     if( bytesToAlign == alignment ) {
         // already aligned!
         return;
     }
 
-    m_priv->m_dataPos += bytesToAlign;
+    m_dataPos += bytesToAlign;
 }
 
 uint32_t Demarshaling::current_offset() const {
-    return m_priv->m_dataPos;
+    return m_dataPos;
 }
 
 void Demarshaling::set_endianess( Endianess endian ) {
-    m_priv->m_endian = endian;
+    m_endian = endian;
 }
 
 void Demarshaling::set_data_offset( uint32_t offset ) {
-    m_priv->m_dataPos = offset;
+    m_dataPos = offset;
 }
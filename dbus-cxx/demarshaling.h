@@ -87,9 +87,14 @@ private:
     int64_t demarshalLongLittle();
 
 private:
-    class priv_data;
-
-    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+    /*
+     * No priv_data here: a Demarshaling is made for every message that is
+     * read, so it must be cheap enough to put on the stack.
+     */
+    const uint8_t* m_data;
+    uint32_t m_dataLen;
+    uint32_t m_dataPos;
+    Endianess m_endian;
 };
 
 }
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "emissionthrottle.h"
+
+using DBus::priv::EmissionThrottle;
+
+EmissionThrottle::EmissionThrottle() :
+    m_mode( EmissionMode::Immediate ),
+    m_interval( std::chrono::steady_clock::duration::zero() ),
+    m_holding( false ) {
+}
+
+void EmissionThrottle::set_policy( EmissionMode mode, std::chrono::steady_clock::duration interval ) {
+    m_mode = mode;
+    m_interval = interval;
+}
+
+DBus::EmissionMode EmissionThrottle::mode() const {
+    return m_mode;
+}
+
+std::chrono::steady_clock::duration EmissionThrottle::interval() const {
+    return m_interval;
+}
+
+EmissionThrottle::Action EmissionThrottle::emitted( std::chrono::steady_clock::time_point now,
+    std::chrono::steady_clock::time_point& flush_at ) {
+    // Whatever is held already has its flush coming up; take its place
+    if( m_holding ) { return Action::Hold; }
+
+    switch( m_mode ) {
+    case EmissionMode::Coalesce:
+        m_holding = true;
+        flush_at = now + m_interval;
+        return Action::HoldAndSchedule;
+
+    case EmissionMode::RateLimit:
+        if( m_lastSent == std::chrono::steady_clock::time_point() ||
+            now >= m_lastSent + m_interval ) {
+            m_lastSent = now;
+            return Action::Send;
+        }
+
+        m_holding = true;
+        flush_at = m_lastSent + m_interval;
+        return Action::HoldAndSchedule;
+
+    case EmissionMode::Immediate:
+    default:
+        m_lastSent = now;
+        return Action::Send;
+    }
+}
+
+void EmissionThrottle::flushed( std::chrono::steady_clock::time_point now ) {
+    m_holding = false;
+    m_lastSent = now;
+}
+
+bool EmissionThrottle::is_holding() const {
+    return m_holding;
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_EMISSIONTHROTTLE_H
+#define DBUSCXX_EMISSIONTHROTTLE_H
+
+#include <dbus-cxx/enums.h>
+#include <chrono>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * Decides whether an emission goes out right away, or is held back to be
+ * sent later, according to an EmissionMode.  Whoever uses this keeps the
+ * last emission that was held, and sends it when told to.
+ *
+ * This class is not thread-safe.
+ */
+class EmissionThrottle {
+public:
+    enum class Action {
+        /** Send the emission now */
+        Send,
+        /** Hold the emission; it replaces whatever was held before */
+        Hold,
+        /**
+         * Hold the emission, and arrange for flushed() to be called once
+         * the flush time has come.
+         */
+        HoldAndSchedule,
+    };
+
+    EmissionThrottle();
+
+    void set_policy( EmissionMode mode, std::chrono::steady_clock::duration interval );
+
+    EmissionMode mode() const;
+
+    std::chrono::steady_clock::duration interval() const;
+
+    /**
+     * Something was emitted.
+     *
+     * @param now The current time
+     * @param flush_at Set to when the held emission must be sent, if this returns HoldAndSchedule
+     */
+    Action emitted( std::chrono::steady_clock::time_point now,
+                    std::chrono::steady_clock::time_point& flush_at );
+
+    /**
+     * The held emission was sent.
+     *
+     * @param now The current time
+     */
+    void flushed( std::chrono::steady_clock::time_point now );
+
+    /** True if something is held, waiting for flushed() */
+    bool is_holding() const;
+
+private:
+    EmissionMode m_mode;
+    std::chrono::steady_clock::duration m_interval;
+    std::chrono::steady_clock::time_point m_lastSent;
+    bool m_holding;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_EMISSIONTHROTTLE_H */
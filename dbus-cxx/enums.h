@@ -135,6 +135,56 @@ enum class ThreadForCalling {
     DispatcherThread,
     /** Always call methods for this object from the current thread */
     CurrentThread,
+    /**
+     * Call methods for this object on the connection's CallPool.  Calls
+     * may run at the same time as each other, so the object must be
+     * thread-safe.  Proxies treat this the same as DispatcherThread.
+     */
+    Pool,
+    /**
+     * Call methods for this object on the connection's CallPool, one at a
+     * time and in the order that they were received.  Proxies treat this
+     * the same as DispatcherThread.
+     */
+    PoolSerialized,
+};
+
+/**
+ * How often something that may be emitted very often(a Signal, or the
+ * PropertiesChanged signal of an Interface) actually goes out on the bus.
+ * Emissions that are held back are sent from the dispatching thread.
+ */
+enum class EmissionMode {
+    /** Every emission goes out right away */
+    Immediate,
+    /**
+     * The first emission starts a window of the given interval.  Only the
+     * last emission made in the window goes out, at the end of the window.
+     */
+    Coalesce,
+    /**
+     * Emissions go out right away, but no more than once per interval.
+     * Anything emitted too soon is held, and only the last of those goes
+     * out once the interval is up.
+     */
+    RateLimit,
+};
+
+/**
+ * What a SignalQueue does with a new signal when it already holds as many
+ * signals as it is allowed to.
+ */
+enum class SignalOverflowPolicy {
+    /** Throw away the signal at the front of the queue to make room */
+    DropOldest,
+    /** Throw away the new signal */
+    DropNewest,
+    /**
+     * Replace the most recently queued signal with the same path, interface
+     * and member with the new one.  If there is no such signal, the oldest
+     * signal is thrown away.
+     */
+    Coalesce,
 };
 
 enum class MessageHeaderFields {
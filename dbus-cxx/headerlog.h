@@ -14,9 +14,15 @@
 #include <dbus-cxx/simplelogger_defs.h>
 
 extern simplelogger_log_function dbuscxx_log_function;
+/*
+ * Nothing below this level is logged from the headers.  This is the level set
+ * with DBus::set_log_level() while DBus::log_std_err() is the logging function;
+ * any other logging function gets everything, the same as from the library.
+ */
+extern enum SL_LogLevel dbuscxx_header_log_level;
 
 #define DBUSCXX_LOG_CSTR_HEADER( logger, message, level ) do{\
-        if( !dbuscxx_log_function ) break;\
+        if( !dbuscxx_log_function || level < dbuscxx_header_log_level ) break;\
         struct SL_LogLocation location;\
         location.line_number = __LINE__;\
         location.file = __FILE__;\
@@ -24,7 +30,9 @@ extern simplelogger_log_function dbuscxx_log_function;
         dbuscxx_log_function( logger, &location, level, message );\
     } while(0)
 
+/* Only format the message if somebody is listening for it */
 #define DBUSCXX_DEBUG_STDSTR( logger, message ) do{\
+        if( !dbuscxx_log_function || SL_DEBUG < dbuscxx_header_log_level ) break;\
         std::stringstream stream;\
         stream << message;\
         DBUSCXX_LOG_CSTR_HEADER( logger, stream.str().c_str(), SL_DEBUG);\
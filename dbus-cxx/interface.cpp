@@ -15,16 +15,32 @@
 #include <sigc++/sigc++.h>
 #include "signalbase.h"
 #include "connection.h"
+#include "emissionthrottle.h"
 
 static const char* LOGGER_NAME = "DBus.Interface";
 
 namespace DBus {
 class Connection;
 
+/**
+ * The property changes that have not gone out yet.  This is shared with the
+ * timer that sends them, since the interface may be gone by then.
+ */
+struct HeldPropertyChanges {
+    std::mutex lock;
+    priv::EmissionThrottle throttle;
+    std::string path;
+    std::map<std::string, DBus::Variant> changed;
+    std::set<std::string> invalidated;
+    /* How many PropertyBatches are open */
+    int batches = 0;
+};
+
 class Interface::priv_data {
 public:
     priv_data( std::string name ):
-        m_name( name ) {}
+        m_name( name ),
+        m_heldChanges( std::make_shared<HeldPropertyChanges>() ) {}
 
     const std::string m_name;
     std::string m_path;
@@ -37,8 +53,24 @@ public:
     sigc::signal<void( std::shared_ptr<MethodBase> )> m_signal_method_added;
     sigc::signal<void( std::shared_ptr<MethodBase> )> m_signal_method_removed;
     std::weak_ptr<DBus::Connection> m_connection;
+    std::shared_ptr<HeldPropertyChanges> m_heldChanges;
 };
 
+static void send_properties_changed( std::shared_ptr<Connection> conn,
+                                     const std::string& path,
+                                     const std::string& interface_name,
+                                     const std::map<std::string, DBus::Variant>& changed,
+                                     const std::set<std::string>& invalidated_set ) {
+    std::shared_ptr<SignalMessage> sigChanged = SignalMessage::create( path,
+                                                                       DBUS_CXX_PROPERTIES_INTERFACE,
+                                                                       "PropertiesChanged" );
+    std::vector<std::string> invalidated( invalidated_set.begin(), invalidated_set.end() );
+
+    sigChanged << interface_name << changed << invalidated;
+
+    conn << sigChanged;
+}
+
 Interface::Interface( const std::string& name ) {
     m_priv = std::make_unique<priv_data>( name );
 }
@@ -431,24 +463,122 @@ bool Interface::has_property( const std::string& name ) const {
     return result;
 }
 
+void Interface::set_property_emission_policy( EmissionMode mode, std::chrono::milliseconds interval ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_heldChanges->lock );
+    m_priv->m_heldChanges->throttle.set_policy( mode, interval );
+}
+
+PropertyBatch Interface::begin_property_batch() {
+    std::unique_lock<std::mutex> lock( m_priv->m_heldChanges->lock );
+    m_priv->m_heldChanges->batches++;
+
+    return PropertyBatch( this );
+}
+
+void Interface::end_property_batch() {
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_heldChanges->lock );
+
+        if( --m_priv->m_heldChanges->batches > 0 ) { return; }
+    }
+
+    send_held_property_changes();
+}
+
 void Interface::property_updated( DBus::PropertyBase* prop ){
-    std::shared_ptr<SignalMessage> sigChanged = SignalMessage::create( m_priv->m_path,
-                                                                       DBUS_CXX_PROPERTIES_INTERFACE,
-                                                                       "PropertiesChanged" );
+    // Nobody is told about constant properties changing
+    if( prop->update_type() == PropertyUpdateType::Const ){
+        return;
+    }
 
-    std::map<std::string,DBus::Variant> changed;
-    std::vector<std::string> invalidated;
+    {
+        std::shared_ptr<HeldPropertyChanges> held = m_priv->m_heldChanges;
+        std::unique_lock<std::mutex> lock( held->lock );
+
+        if( prop->update_type() == PropertyUpdateType::Invalidates ){
+            held->changed.erase( prop->name() );
+            held->invalidated.insert( prop->name() );
+        }else{
+            held->invalidated.erase( prop->name() );
+            held->changed[ prop->name() ] = prop->variant_value();
+        }
 
-    changed[ prop->name() ] = prop->variant_value();
+        held->path = m_priv->m_path;
+
+        if( held->batches > 0 ){
+            return;
+        }
+    }
 
-    sigChanged << m_priv->m_name << changed << invalidated;
+    send_held_property_changes();
+}
 
+void Interface::send_held_property_changes(){
+    std::shared_ptr<HeldPropertyChanges> held = m_priv->m_heldChanges;
     std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
-    if( !conn ){
-        return;
+    std::map<std::string,DBus::Variant> changed;
+    std::set<std::string> invalidated;
+    std::string path;
+    std::chrono::steady_clock::time_point flush_at;
+    priv::EmissionThrottle::Action action;
+
+    {
+        std::unique_lock<std::mutex> lock( held->lock );
+
+        if( !conn ){
+            // Nobody to tell
+            held->changed.clear();
+            held->invalidated.clear();
+            return;
+        }
+
+        // Somebody else already sent them
+        if( held->changed.empty() && held->invalidated.empty() ){
+            return;
+        }
+
+        action = held->throttle.emitted( std::chrono::steady_clock::now(), flush_at );
+
+        if( action == priv::EmissionThrottle::Action::Send ) {
+            changed.swap( held->changed );
+            invalidated.swap( held->invalidated );
+            path = held->path;
+        }
     }
 
-    conn << sigChanged;
+    if( action == priv::EmissionThrottle::Action::Send ) {
+        send_properties_changed( conn, path, m_priv->m_name, changed, invalidated );
+    } else if( action == priv::EmissionThrottle::Action::HoldAndSchedule ) {
+        std::weak_ptr<Connection> weak_conn = conn;
+        std::weak_ptr<HeldPropertyChanges> weak_held = held;
+        std::string interface_name = m_priv->m_name;
+
+        conn->call_at( flush_at, [weak_conn, weak_held, interface_name]() {
+            std::shared_ptr<Connection> conn = weak_conn.lock();
+            std::shared_ptr<HeldPropertyChanges> held = weak_held.lock();
+            std::map<std::string,DBus::Variant> changed;
+            std::set<std::string> invalidated;
+            std::string path;
+
+            if( !held ) { return; }
+
+            {
+                std::unique_lock<std::mutex> lock( held->lock );
+                held->throttle.flushed( std::chrono::steady_clock::now() );
+
+                // A batch that is still open sends these when it ends
+                if( held->batches > 0 ) { return; }
+
+                changed.swap( held->changed );
+                invalidated.swap( held->invalidated );
+                path = held->path;
+            }
+
+            if( conn && conn->is_valid() && ( !changed.empty() || !invalidated.empty() ) ) {
+                send_properties_changed( conn, path, interface_name, changed, invalidated );
+            }
+        } );
+    }
 }
 
 void Interface::set_connection( std::weak_ptr<Connection> conn ){
@@ -464,5 +594,25 @@ const std::set<std::shared_ptr<PropertyBase>>& Interface::properties(){
     return m_priv->m_properties;
 }
 
+PropertyBatch::PropertyBatch( Interface* iface ) :
+    m_interface( iface ) {
 }
 
+PropertyBatch::PropertyBatch( PropertyBatch&& other ) :
+    m_interface( other.m_interface ) {
+    other.m_interface = nullptr;
+}
+
+PropertyBatch::~PropertyBatch() {
+    end();
+}
+
+void PropertyBatch::end() {
+    if( !m_interface ) { return; }
+
+    Interface* iface = m_interface;
+    m_interface = nullptr;
+    iface->end_property_batch();
+}
+
+}
@@ -12,6 +12,7 @@
 #include <dbus-cxx/dbus-cxx-config.h>
 #include <dbus-cxx/property.h>
 #include <sigc++/sigc++.h>
+#include <chrono>
 #include <set>
 #include <map>
 #include <mutex>
@@ -23,9 +24,43 @@
 namespace DBus {
 class CallMessage;
 class Connection;
+class Interface;
 class Object;
 class SignalBase;
 
+/**
+ * Collects the property changes of an Interface, so that they all go out
+ * in one PropertiesChanged signal once the batch ends.  Obtain one from
+ * Interface::begin_property_batch().  The batch ends when this is
+ * destroyed, or when end() is called.
+ *
+ * Batches may be nested; the signal goes out when the outermost one ends.
+ * A batch must not outlive its interface.
+ *
+ * @ingroup objects
+ */
+class PropertyBatch {
+private:
+    explicit PropertyBatch( Interface* iface );
+
+public:
+    PropertyBatch( PropertyBatch&& other );
+
+    PropertyBatch( const PropertyBatch& ) = delete;
+
+    PropertyBatch& operator=( const PropertyBatch& ) = delete;
+
+    ~PropertyBatch();
+
+    /** End the batch now, instead of when this is destroyed */
+    void end();
+
+private:
+    Interface* m_interface;
+
+    friend class Interface;
+};
+
 /**
  * An Interface represents a local copy of a DBus interface.  A DBus interface is
  * an entry point that allows for object-orinted manipulation of local objects.
@@ -159,6 +194,32 @@ public:
 
     bool has_property( const std::string& name ) const;
 
+    /**
+     * Set how often the PropertiesChanged signal for this interface goes
+     * out, for properties that change faster than anybody needs to know.
+     * While emissions are held back, the latest value of each property
+     * that changed is kept, and they all go out in one signal.
+     *
+     * @param mode How to hold back emissions
+     * @param interval The window for EmissionMode::Coalesce, or the shortest
+     * time between emissions for EmissionMode::RateLimit
+     */
+    void set_property_emission_policy( EmissionMode mode, std::chrono::milliseconds interval = std::chrono::milliseconds( 0 ) );
+
+    /**
+     * Start collecting property changes, so that everything that changes
+     * until the batch ends goes out in one PropertiesChanged signal.
+     *
+     * Properties that are PropertyUpdateType::Updates are sent with their
+     * latest value, and properties that are PropertyUpdateType::Invalidates
+     * are sent in the list of invalidated properties.
+     *
+     * To batch up changes made from handlers without a scope, use
+     * EmissionMode::Coalesce with an interval of zero instead; everything
+     * that changes before the dispatcher next runs goes out together.
+     */
+    [[nodiscard]] PropertyBatch begin_property_batch();
+
     /** Adds the named method */
     bool add_method( std::shared_ptr<MethodBase> method );
 
@@ -241,6 +302,9 @@ public:
 private:
     void set_path( const std::string& new_path );
     void property_updated( DBus::PropertyBase* prop );
+    /** Send the property changes that have been held, unless something is holding them back */
+    void send_held_property_changes();
+    void end_property_batch();
     void set_connection( std::weak_ptr<Connection> conn );
 
 private:
@@ -250,6 +314,7 @@ private:
 
     friend class Object;
     friend class PropertyBase;
+    friend class PropertyBatch;
 };
 
 } /* namespace DBus */
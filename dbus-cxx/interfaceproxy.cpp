@@ -55,6 +55,12 @@ InterfaceProxy::~ InterfaceProxy( ) {
         }
 
         conn->remove_free_signal_proxy( m_priv->m_updated_proxy );
+
+        for( std::shared_ptr<SignalProxyBase> sig : m_priv->m_signals ){
+            conn->remove_match( sig->match_rule() );
+        }
+
+        conn->remove_signal_routes( std::vector<std::shared_ptr<SignalProxyBase>>( m_priv->m_signals.begin(), m_priv->m_signals.end() ) );
     }
 }
 
@@ -73,6 +79,7 @@ void InterfaceProxy::set_object( ObjectProxy* obj ) {
                 .set_path( path() )
                 .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
                 .set_member( "PropertiesChanged" )
+                .set_arg( 0, m_priv->m_name )
                 .as_signal_match()
                 );
 
@@ -87,7 +94,7 @@ void InterfaceProxy::set_object( ObjectProxy* obj ) {
             conn->remove_match( sig->match_rule() );
             sig->set_path( path() );
             sig->update_match_rule();
-            conn->add_match( sig->match_rule() );
+            conn->add_match_nonblocking( sig->match_rule() );
         }
     }
 }
@@ -224,11 +231,12 @@ std::shared_ptr<const ReturnMessage> InterfaceProxy::call( std::shared_ptr<const
     return m_priv->m_object->call( call_message, timeout_milliseconds );
 }
 
-//  std::shared_ptr<PendingCall> InterfaceProxy::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds ) const
-//  {
-//    if ( not m_priv->m_object ) return std::shared_ptr<PendingCall>();
-//    return m_priv->m_object->call_async( call_message, timeout_milliseconds );
-//  }
+std::shared_ptr<PendingCall> InterfaceProxy::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) const {
+    if( !m_priv->m_object ) { return std::shared_ptr<PendingCall>(); }
+
+    return m_priv->m_object->call_async( call_message, timeout_milliseconds, callback );
+}
 
 const InterfaceProxy::Signals& InterfaceProxy::signals() const {
     return m_priv->m_signals;
@@ -258,7 +266,8 @@ bool InterfaceProxy::add_signal( std::shared_ptr<SignalProxyBase> sig ) {
 
     std::shared_ptr<Connection> conn = connection().lock();
     if( conn ){
-        conn->add_match( sig->match_rule() );
+        conn->add_match_nonblocking( sig->match_rule() );
+        conn->add_object_signal_routes( m_priv->m_object, { sig } );
     }
 
     return true;
@@ -274,6 +283,13 @@ bool InterfaceProxy::remove_signal( std::shared_ptr<SignalProxyBase> sig ) {
     if( !this->has_signal( sig ) ) { return false; }
 
     m_priv->m_signals.erase( sig );
+
+    std::shared_ptr<Connection> conn = connection().lock();
+    if( conn ){
+        conn->remove_match( sig->match_rule() );
+        conn->remove_signal_routes( { sig } );
+    }
+
     return true;
 }
 
@@ -293,6 +309,13 @@ void InterfaceProxy::on_object_set_path( const std::string& path ) {
     for( Signals::iterator i = m_priv->m_signals.begin(); i != m_priv->m_signals.end(); i++ ) {
         ( *i )->set_path( path );
     }
+
+    std::shared_ptr<Connection> conn = connection().lock();
+    if( conn ){
+        for( std::shared_ptr<SignalProxyBase> sig : m_priv->m_signals ) {
+            conn->update_signal_route( sig.get() );
+        }
+    }
 }
 
 const std::map<std::string,std::shared_ptr<PropertyProxyBase>>& InterfaceProxy::properties() const {
@@ -147,7 +147,8 @@ public:
 
     std::shared_ptr<const ReturnMessage> call( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
-    //      std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds=-1 ) const;
+    std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} ) const;
 
     template <class T_arg>
     std::shared_ptr<SignalProxy<T_arg >> create_signal( const std::string& sig_name ) {
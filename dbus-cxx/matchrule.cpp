@@ -6,7 +6,13 @@
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
 #include "matchrule.h"
+#include "enums.h"
+#include "error.h"
+#include "message.h"
+#include "messageiterator.h"
+#include "variant.h"
 
+#include <algorithm>
 #include <string>
 
 using DBus::MatchRuleBuilder;
@@ -19,7 +25,9 @@ using DBus::ErrorMatchRule;
 /***************************************************************************/
 class DBus::MatchRuleData {
 public:
-    MatchRuleData(){}
+    MatchRuleData() :
+        m_eavesdrop( false )
+    {}
 
     std::string m_type;
     std::string m_path;
@@ -27,8 +35,72 @@ public:
     std::string m_member;
     std::string m_sender;
     std::string m_destination;
+    std::string m_pathNamespace;
+    std::string m_arg0Namespace;
+    std::map<unsigned int, std::string> m_args;
+    std::map<unsigned int, std::string> m_argPaths;
+    bool m_eavesdrop;
 };
 
+/* The bus only allows arguments 0 through 63 to be matched on */
+static const unsigned int MAX_MATCH_ARG = 63;
+
+/**
+ * Quote a value for a match rule.  Apostrophes can't be escaped inside of
+ * quotes, so they go between quoted strings as \'
+ */
+static std::string quote( const std::string& value ) {
+    std::string quoted = "'";
+
+    for( char c : value ) {
+        if( c == '\'' ) {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+
+    return quoted + "'";
+}
+
+static bool arg_path_matches( const std::string& rule, const std::string& arg ) {
+    if( rule == arg ) { return true; }
+
+    if( !rule.empty() && rule.back() == '/' && arg.compare( 0, rule.size(), rule ) == 0 ) { return true; }
+
+    if( !arg.empty() && arg.back() == '/' && rule.compare( 0, arg.size(), arg ) == 0 ) { return true; }
+
+    return false;
+}
+
+static bool in_namespace( const std::string& name_namespace, const std::string& value, char separator ) {
+    if( value.compare( 0, name_namespace.size(), name_namespace ) != 0 ) { return false; }
+
+    return value.size() == name_namespace.size() || value[ name_namespace.size() ] == separator;
+}
+
+/**
+ * Read past an argument that we don't need the value of.
+ *
+ * @return False if the argument can't be skipped over without decoding it
+ */
+static bool skip_argument( DBus::MessageIterator& iter ) {
+    switch( iter.arg_type() ) {
+    case DBus::DataType::BYTE: iter.get_uint8(); return true;
+    case DBus::DataType::BOOLEAN: iter.get_bool(); return true;
+    case DBus::DataType::INT16: iter.get_int16(); return true;
+    case DBus::DataType::UINT16: iter.get_uint16(); return true;
+    case DBus::DataType::INT32: iter.get_int32(); return true;
+    case DBus::DataType::UINT32: iter.get_uint32(); return true;
+    case DBus::DataType::INT64: iter.get_int64(); return true;
+    case DBus::DataType::UINT64: iter.get_uint64(); return true;
+    case DBus::DataType::DOUBLE: iter.get_double(); return true;
+    case DBus::DataType::SIGNATURE: iter.get_signature(); return true;
+    case DBus::DataType::VARIANT: iter.get_variant(); return true;
+    default: return false;
+    }
+}
+
 
 /***************************************************************************/
 MatchRuleBuilder::MatchRuleBuilder() :
@@ -60,25 +132,72 @@ MatchRuleBuilder& MatchRuleBuilder::set_destination( const std::string& destinat
     return *this;
 }
 
+MatchRuleBuilder& MatchRuleBuilder::set_path_namespace( const std::string& path_namespace ) {
+    m_priv->m_pathNamespace = path_namespace;
+    return *this;
+}
+
+MatchRuleBuilder& MatchRuleBuilder::set_arg( unsigned int index, const std::string& value ) {
+    if( index > MAX_MATCH_ARG ) {
+        throw ErrorMatchRuleInvalid( "Only arguments 0 through 63 can be matched on" );
+    }
+
+    m_priv->m_args[ index ] = value;
+    return *this;
+}
+
+MatchRuleBuilder& MatchRuleBuilder::set_arg_path( unsigned int index, const std::string& path ) {
+    if( index > MAX_MATCH_ARG ) {
+        throw ErrorMatchRuleInvalid( "Only arguments 0 through 63 can be matched on" );
+    }
+
+    m_priv->m_argPaths[ index ] = path;
+    return *this;
+}
+
+MatchRuleBuilder& MatchRuleBuilder::set_arg0_namespace( const std::string& name_namespace ) {
+    m_priv->m_arg0Namespace = name_namespace;
+    return *this;
+}
+
+MatchRuleBuilder& MatchRuleBuilder::set_eavesdrop( bool eavesdrop ) {
+    m_priv->m_eavesdrop = eavesdrop;
+    return *this;
+}
+
+static void check_rule( const std::shared_ptr<DBus::MatchRuleData>& data ) {
+    if( !data->m_path.empty() && !data->m_pathNamespace.empty() ) {
+        throw DBus::ErrorMatchRuleInvalid( "A match rule can't have both path and path_namespace" );
+    }
+}
+
 SignalMatchRule MatchRuleBuilder::as_signal_match(){
+    check_rule( m_priv );
+
     SignalMatchRule sig( m_priv );
 
     return sig;
 }
 
 MethodCallMatchRule MatchRuleBuilder::as_method_call_match(){
+    check_rule( m_priv );
+
     MethodCallMatchRule meth( m_priv );
 
     return meth;
 }
 
 MethodReturnMatchRule MatchRuleBuilder::as_method_return_match(){
+    check_rule( m_priv );
+
     MethodReturnMatchRule meth( m_priv );
 
     return meth;
 }
 
 ErrorMatchRule MatchRuleBuilder::as_error_match(){
+    check_rule( m_priv );
+
     ErrorMatchRule err( m_priv );
 
     return err;
@@ -89,6 +208,13 @@ MatchRuleBuilder MatchRuleBuilder::create(){
     return build;
 }
 
+MatchRuleBuilder MatchRuleBuilder::create( const MatchRule& rule ){
+    MatchRuleBuilder build;
+    // Copy, since the rule that we build shares its data with us
+    build.m_priv = std::make_shared<MatchRuleData>( *rule.m_priv );
+    return build;
+}
+
 /***************************************************************************/
 MatchRule::MatchRule( std::string type, std::shared_ptr<MatchRuleData> data ) :
     m_priv( data ){
@@ -107,22 +233,143 @@ std::string MatchRule::member() const {
     return m_priv->m_member;
 }
 
+MatchRule::MatchRule( const MatchRule& other ) :
+    m_priv( std::make_shared<MatchRuleData>( *other.m_priv ) )
+{}
+
+MatchRule& MatchRule::operator=( const MatchRule& other ) {
+    if( this != &other ) {
+        m_priv = std::make_shared<MatchRuleData>( *other.m_priv );
+    }
+
+    return *this;
+}
+
+std::string MatchRule::sender() const {
+    return m_priv->m_sender;
+}
+
+std::string MatchRule::destination() const {
+    return m_priv->m_destination;
+}
+
+std::string MatchRule::path_namespace() const {
+    return m_priv->m_pathNamespace;
+}
+
+std::string MatchRule::arg0_namespace() const {
+    return m_priv->m_arg0Namespace;
+}
+
+std::map<unsigned int, std::string> MatchRule::args() const {
+    return m_priv->m_args;
+}
+
+std::map<unsigned int, std::string> MatchRule::arg_paths() const {
+    return m_priv->m_argPaths;
+}
+
+bool MatchRule::eavesdrop() const {
+    return m_priv->m_eavesdrop;
+}
+
 std::string MatchRule::match_rule() const {
-    std::string match_rule = "type='" + m_priv->m_type + "'";
+    std::string match_rule = "type=" + quote( m_priv->m_type );
+
+    if( !m_priv->m_interface.empty() ) { match_rule += ",interface="   + quote( m_priv->m_interface ); }
+
+    if( !m_priv->m_member.empty() ) { match_rule += ",member="      + quote( m_priv->m_member ); }
+
+    if( !m_priv->m_sender.empty() ) { match_rule += ",sender="      + quote( m_priv->m_sender ); }
+
+    if( !m_priv->m_path.empty() ) { match_rule += ",path="        + quote( m_priv->m_path ); }
 
-    if( !m_priv->m_interface.empty() ) { match_rule += ",interface='"   + m_priv->m_interface   + "'"; }
+    if( !m_priv->m_pathNamespace.empty() ) { match_rule += ",path_namespace=" + quote( m_priv->m_pathNamespace ); }
 
-    if( !m_priv->m_member.empty() ) { match_rule += ",member='"      + m_priv->m_member      + "'"; }
+    if( !m_priv->m_destination.empty() ) { match_rule += ",destination=" + quote( m_priv->m_destination ); }
 
-    if( !m_priv->m_sender.empty() ) { match_rule += ",sender='"      + m_priv->m_sender      + "'"; }
+    for( const std::pair<const unsigned int, std::string>& arg : m_priv->m_args ) {
+        match_rule += ",arg" + std::to_string( arg.first ) + "=" + quote( arg.second );
+    }
 
-    if( !m_priv->m_path.empty() ) { match_rule += ",path='"        + m_priv->m_path        + "'"; }
+    for( const std::pair<const unsigned int, std::string>& arg : m_priv->m_argPaths ) {
+        match_rule += ",arg" + std::to_string( arg.first ) + "path=" + quote( arg.second );
+    }
 
-    if( !m_priv->m_destination.empty() ) { match_rule += ",destination='" + m_priv->m_destination + "'"; }
+    if( !m_priv->m_arg0Namespace.empty() ) { match_rule += ",arg0namespace=" + quote( m_priv->m_arg0Namespace ); }
+
+    if( m_priv->m_eavesdrop ) { match_rule += ",eavesdrop='true'"; }
 
     return match_rule;
 }
 
+bool MatchRule::matches_path_namespace( const std::string& path ) const {
+    const std::string& path_namespace = m_priv->m_pathNamespace;
+
+    if( path_namespace.empty() || path_namespace == "/" ) { return true; }
+
+    return in_namespace( path_namespace, path, '/' );
+}
+
+bool MatchRule::matches_arguments( std::shared_ptr<const Message> msg ) const {
+    unsigned int last = 0;
+
+    if( m_priv->m_args.empty() &&
+        m_priv->m_argPaths.empty() &&
+        m_priv->m_arg0Namespace.empty() ) {
+        return true;
+    }
+
+    if( !msg ) { return false; }
+
+    if( !m_priv->m_args.empty() ) { last = std::max( last, m_priv->m_args.rbegin()->first ); }
+
+    if( !m_priv->m_argPaths.empty() ) { last = std::max( last, m_priv->m_argPaths.rbegin()->first ); }
+
+    MessageIterator iter = msg->begin();
+
+    for( unsigned int index = 0; index <= last; index++ ) {
+        std::map<unsigned int, std::string>::const_iterator arg = m_priv->m_args.find( index );
+        std::map<unsigned int, std::string>::const_iterator argPath = m_priv->m_argPaths.find( index );
+        bool checkNamespace = index == 0 && !m_priv->m_arg0Namespace.empty();
+        bool filtered = arg != m_priv->m_args.end() || argPath != m_priv->m_argPaths.end() || checkNamespace;
+
+        // There is a filter on this argument or one after it, and the
+        // message doesn't have that many arguments
+        if( !iter.is_valid() ) { return false; }
+
+        DataType type = iter.arg_type();
+        std::string value;
+
+        if( type == DataType::STRING || type == DataType::OBJECT_PATH ) {
+            value = iter.get_string();
+        } else if( !skip_argument( iter ) ) {
+            // A container can never match a filter, and we can't see past
+            // it to the arguments after it; leave those to the bus
+            return !filtered;
+        }
+
+        if( arg != m_priv->m_args.end() &&
+            ( type != DataType::STRING || value != arg->second ) ) {
+            return false;
+        }
+
+        if( argPath != m_priv->m_argPaths.end() &&
+            ( ( type != DataType::STRING && type != DataType::OBJECT_PATH ) || !arg_path_matches( argPath->second, value ) ) ) {
+            return false;
+        }
+
+        if( checkNamespace &&
+            ( type != DataType::STRING || !in_namespace( m_priv->m_arg0Namespace, value, '.' ) ) ) {
+            return false;
+        }
+
+        iter.next();
+    }
+
+    return true;
+}
+
 /***************************************************************************/
 SignalMatchRule::SignalMatchRule( std::shared_ptr<MatchRuleData> data ) :
     MatchRule( "signal", data ){
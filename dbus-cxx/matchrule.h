@@ -8,13 +8,16 @@
 #ifndef DBUSCXX_MATCH_RULE_H
 #define DBUSCXX_MATCH_RULE_H
 
+#include <map>
 #include <memory>
+#include <string>
 #include <dbus-cxx/dbus-cxx-config.h>
 
 namespace DBus {
 
 class MatchRuleBuilder;
 class MatchRuleData;
+class Message;
 
 /**
  * Immutable class that represents a match rule for DBus.
@@ -24,6 +27,10 @@ protected:
     MatchRule( std::string type, const std::shared_ptr<MatchRuleData> );
 
 public:
+    MatchRule( const MatchRule& other );
+
+    MatchRule& operator=( const MatchRule& other );
+
     std::string match_rule() const;
 
     std::string path() const;
@@ -32,6 +39,42 @@ public:
 
     std::string member() const;
 
+    std::string sender() const;
+
+    std::string destination() const;
+
+    std::string path_namespace() const;
+
+    std::string arg0_namespace() const;
+
+    /** The argN filters, by N */
+    std::map<unsigned int, std::string> args() const;
+
+    /** The argNpath filters, by N */
+    std::map<unsigned int, std::string> arg_paths() const;
+
+    bool eavesdrop() const;
+
+    /**
+     * Check the path of a message against path_namespace.
+     *
+     * @return True if there is no path_namespace, or the path is in it
+     */
+    bool matches_path_namespace( const std::string& path ) const;
+
+    /**
+     * Check the arguments of a message against the argN, argNpath and
+     * arg0namespace filters, the same way that the bus does.  Only the
+     * arguments that are filtered on are read.
+     *
+     * Arguments that come after a container or a file descriptor can't
+     * be looked at without decoding the container, so any filters on
+     * them are left to the bus.
+     *
+     * @return True if the message's arguments match
+     */
+    bool matches_arguments( std::shared_ptr<const Message> msg ) const;
+
 private:
     DBUS_CXX_PROPAGATE_CONST( std::shared_ptr<MatchRuleData> ) m_priv;
 
@@ -88,6 +131,37 @@ public:
 
     MatchRuleBuilder& set_destination( const std::string& destination );
 
+    /**
+     * Only match messages whose path is the given path, or is below it.
+     * This can't be used together with set_path().
+     */
+    MatchRuleBuilder& set_path_namespace( const std::string& path_namespace );
+
+    /**
+     * Only match messages whose argument number index(0-63) is a string
+     * that is equal to value.
+     */
+    MatchRuleBuilder& set_arg( unsigned int index, const std::string& value );
+
+    /**
+     * Only match messages whose argument number index(0-63) is a string or
+     * an object path that is equal to path.  If either one ends with a '/',
+     * it matches anything below it as well.
+     */
+    MatchRuleBuilder& set_arg_path( unsigned int index, const std::string& path );
+
+    /**
+     * Only match messages whose first argument is a string that is a bus
+     * or interface name in the given namespace, e.g. com.example.backend
+     * matches com.example.backend and com.example.backend.foo
+     */
+    MatchRuleBuilder& set_arg0_namespace( const std::string& name_namespace );
+
+    /**
+     * Ask the bus to give us messages that were not meant for us as well.
+     */
+    MatchRuleBuilder& set_eavesdrop( bool eavesdrop );
+
     SignalMatchRule as_signal_match();
 
     MethodCallMatchRule as_method_call_match();
@@ -98,6 +172,11 @@ public:
 
     static MatchRuleBuilder create();
 
+    /**
+     * Create a builder that starts out with everything from the given rule.
+     */
+    static MatchRuleBuilder create( const MatchRule& rule );
+
 private:
     std::shared_ptr<MatchRuleData> m_priv;
 };
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "memfdbuffer.h"
+
+#include "dbus-cxx-private.h"
+#include "filedescriptor.h"
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char* LOGGER_NAME = "DBus.MemfdBuffer";
+
+using DBus::MemfdBuffer;
+
+#ifdef DBUS_CXX_HAS_MEMFD_CREATE
+/* The seals that we require before we will trust the contents of a memfd */
+#define REQUIRED_SEALS ( F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE )
+#endif
+
+class MemfdBuffer::priv_data {
+public:
+    priv_data() :
+        m_fd( -1 ),
+        m_data( nullptr ),
+        m_size( 0 ),
+        m_valid( false )
+    {}
+
+    int m_fd;
+    void* m_data;
+    size_t m_size;
+    bool m_valid;
+};
+
+MemfdBuffer::MemfdBuffer() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+MemfdBuffer::~MemfdBuffer() {
+    if( m_priv->m_data != nullptr ) {
+        munmap( m_priv->m_data, m_priv->m_size );
+    }
+
+    if( m_priv->m_fd >= 0 ) {
+        close( m_priv->m_fd );
+    }
+}
+
+std::shared_ptr<MemfdBuffer> MemfdBuffer::create( const uint8_t* data, size_t size ) {
+    std::shared_ptr<MemfdBuffer> buffer( new MemfdBuffer() );
+
+#ifdef DBUS_CXX_HAS_MEMFD_CREATE
+    int fd = memfd_create( "dbus-cxx", MFD_CLOEXEC | MFD_ALLOW_SEALING );
+    size_t written = 0;
+
+    if( fd < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to create memfd: " + errmsg );
+        return buffer;
+    }
+
+    buffer->m_priv->m_fd = fd;
+
+    while( written < size ) {
+        ssize_t ret = ::write( fd, data + written, size - written );
+
+        if( ret < 0 && errno == EINTR ) {
+            continue;
+        }
+
+        if( ret < 0 ) {
+            std::string errmsg = strerror( errno );
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to write to memfd: " + errmsg );
+            return buffer;
+        }
+
+        written += ret;
+    }
+
+    if( fcntl( fd, F_ADD_SEALS, REQUIRED_SEALS | F_SEAL_SEAL ) < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to seal memfd: " + errmsg );
+        return buffer;
+    }
+
+    buffer->map_fd( fd );
+#else
+    SIMPLELOGGER_ERROR( LOGGER_NAME, "memfd is not supported on this platform" );
+#endif
+
+    return buffer;
+}
+
+std::shared_ptr<MemfdBuffer> MemfdBuffer::create( const std::vector<uint8_t>& data ) {
+    return create( data.data(), data.size() );
+}
+
+std::shared_ptr<MemfdBuffer> MemfdBuffer::create( std::shared_ptr<FileDescriptor> fd ) {
+    std::shared_ptr<MemfdBuffer> buffer( new MemfdBuffer() );
+
+#ifdef DBUS_CXX_HAS_MEMFD_CREATE
+    if( !fd || fd->descriptor() < 0 ) {
+        return buffer;
+    }
+
+    int seals = fcntl( fd->descriptor(), F_GET_SEALS );
+
+    if( seals < 0 || ( seals & REQUIRED_SEALS ) != REQUIRED_SEALS ) {
+        // The other side could change the data out from under us
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Refusing to map a memfd that is not sealed" );
+        return buffer;
+    }
+
+    int new_fd = fcntl( fd->descriptor(), F_DUPFD_CLOEXEC, 3 );
+
+    if( new_fd < 0 ) {
+        return buffer;
+    }
+
+    buffer->m_priv->m_fd = new_fd;
+    buffer->map_fd( new_fd );
+#else
+    SIMPLELOGGER_ERROR( LOGGER_NAME, "memfd is not supported on this platform" );
+#endif
+
+    return buffer;
+}
+
+bool MemfdBuffer::map_fd( int fd ) {
+    struct stat statbuf;
+
+    if( fstat( fd, &statbuf ) < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to stat memfd: " + errmsg );
+        return false;
+    }
+
+    m_priv->m_size = statbuf.st_size;
+
+    if( m_priv->m_size == 0 ) {
+        // mmap() will not map zero bytes, but an empty buffer is still valid
+        m_priv->m_valid = true;
+        return true;
+    }
+
+    void* mapped = mmap( nullptr, m_priv->m_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+    if( mapped == MAP_FAILED ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to map memfd: " + errmsg );
+        m_priv->m_size = 0;
+        return false;
+    }
+
+    m_priv->m_data = mapped;
+    m_priv->m_valid = true;
+
+    return true;
+}
+
+bool MemfdBuffer::is_valid() const {
+    return m_priv->m_valid;
+}
+
+const uint8_t* MemfdBuffer::data() const {
+    return static_cast<const uint8_t*>( m_priv->m_data );
+}
+
+size_t MemfdBuffer::size() const {
+    return m_priv->m_size;
+}
+
+std::shared_ptr<DBus::FileDescriptor> MemfdBuffer::filedescriptor() const {
+    return FileDescriptor::create( m_priv->m_fd );
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_MEMFDBUFFER_H
+#define DBUSCXX_MEMFDBUFFER_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace DBus {
+
+class FileDescriptor;
+
+/**
+ * A read-only block of memory that is backed by a sealed memfd.
+ *
+ * This is useful for sending large payloads(images, firmware, etc) without
+ * copying all of the bytes through the socket: the data is written into
+ * a memfd once, and only the file descriptor is sent as a UNIX_FD('h')
+ * argument.  The receiving side creates a MemfdBuffer from the
+ * FileDescriptor that it got, which maps the memory without copying it.
+ *
+ * The memfd is sealed against writing, growing and shrinking before it
+ * is sent, so the receiver can safely read from it while the sender still
+ * has it open.  When receiving, a memfd that is not sealed is rejected.
+ *
+ * Note that the connection must have negotiated FD passing for this to work.
+ *
+ * @ingroup core
+ */
+class MemfdBuffer {
+private:
+    MemfdBuffer();
+
+public:
+    /**
+     * Create a new sealed memfd containing a copy of the given data.
+     *
+     * @param data The data to put into the memfd
+     * @param size The number of bytes of data
+     * @return The buffer.  Check is_valid() to see if it could be created.
+     */
+    static std::shared_ptr<MemfdBuffer> create( const uint8_t* data, size_t size );
+
+    /**
+     * Create a new sealed memfd containing a copy of the given data.
+     */
+    static std::shared_ptr<MemfdBuffer> create( const std::vector<uint8_t>& data );
+
+    /**
+     * Map the memfd that was received from the other side.  The file descriptor
+     * is duplicated, so the given FileDescriptor may be closed afterwards.
+     *
+     * @param fd The received file descriptor
+     * @return The buffer.  Check is_valid() to see if the memory could be mapped.
+     */
+    static std::shared_ptr<MemfdBuffer> create( std::shared_ptr<FileDescriptor> fd );
+
+    ~MemfdBuffer();
+
+    /** True if the memory has been mapped successfully */
+    bool is_valid() const;
+
+    /** The mapped(read-only) memory */
+    const uint8_t* data() const;
+
+    /** The number of bytes in the buffer */
+    size_t size() const;
+
+    /**
+     * The file descriptor for this buffer, to be appended to a message.
+     * The descriptor remains owned by this MemfdBuffer.
+     */
+    std::shared_ptr<FileDescriptor> filedescriptor() const;
+
+private:
+    bool map_fd( int fd );
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_MEMFDBUFFER_H */
@@ -20,6 +20,8 @@
 #include "validator.h"
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
 
 static const char* LOGGER_NAME = "DBus.Message";
 
@@ -42,6 +44,19 @@ public:
     uint8_t m_flags;
     std::vector<int> m_filedescriptors;
     uint32_t m_serial;
+    /* Parsed copy of the Signature header, so iterating doesn't re-parse it */
+    Signature m_signature;
+
+    void cache_signature() {
+        std::map<MessageHeaderFields, Variant>::const_iterator location =
+            m_headerMap.find( MessageHeaderFields::Signature );
+
+        if( location != m_headerMap.end() && location->second.type() == DataType::SIGNATURE ) {
+            m_signature = location->second.to_signature();
+        } else {
+            m_signature = Signature();
+        }
+    }
 };
 
 Message::Message() {
@@ -159,13 +174,7 @@ MessageAppendIterator Message::append() {
 }
 
 Signature Message::signature() const {
-    Variant v = header_field( MessageHeaderFields::Signature );
-
-    if( v.type() == DataType::SIGNATURE ) {
-        return v.to_signature();
-    }
-
-    return Signature();
+    return m_priv->m_signature;
 }
 
 bool Message::serialize_to_vector( std::vector<uint8_t>* vec, uint32_t serial ) const {
@@ -340,6 +349,7 @@ std::shared_ptr<Message> Message::create_from_data( uint8_t* data, uint32_t data
     retmsg->m_priv->m_flags = flags;
     retmsg->m_priv->m_valid = true;
     retmsg->m_priv->m_headerMap = headerMap;
+    retmsg->m_priv->cache_signature();
     retmsg->m_priv->m_endianess = msgEndian;
     retmsg->m_priv->m_body.reserve( bodyLen );
     retmsg->m_priv->m_filedescriptors = real_fds;
@@ -358,16 +368,10 @@ std::shared_ptr<Message> Message::create_from_data( uint8_t* data, uint32_t data
 }
 
 void Message::append_signature( std::string toappend ) {
-    DBus::Variant val = m_priv->m_headerMap[ MessageHeaderFields::Signature ];
-    std::string newval;
-
-    if( val.type() != DataType::INVALID ) {
-        Signature sig = val.to_signature();
-        newval += sig.str();
-    }
+    Signature sig( m_priv->m_signature.str() + toappend );
 
-    newval += toappend;
-    m_priv->m_headerMap[ MessageHeaderFields::Signature ] = DBus::Variant( Signature( newval ) );
+    m_priv->m_headerMap[ MessageHeaderFields::Signature ] = DBus::Variant( sig );
+    m_priv->m_signature = sig;
 }
 
 Variant Message::header_field( MessageHeaderFields field ) const {
@@ -389,6 +393,7 @@ void Message::clear_sig_and_data() {
         m_priv->m_headerMap.erase( location );
     }
 
+    m_priv->m_signature = Signature();
     m_priv->m_body.clear();
 }
 
@@ -400,11 +405,42 @@ void Message::set_flags( uint8_t flags ) {
     m_priv->m_flags = flags;
 }
 
+void Message::copy_contents_from( const Message& other ) {
+    m_priv->m_valid = other.m_priv->m_valid;
+    m_priv->m_headerMap = other.m_priv->m_headerMap;
+    m_priv->m_body = other.m_priv->m_body;
+    m_priv->m_endianess = other.m_priv->m_endianess;
+    m_priv->m_flags = other.m_priv->m_flags;
+    m_priv->m_signature = other.m_priv->m_signature;
+
+    for( int fd : m_priv->m_filedescriptors ) {
+        close( fd );
+    }
+
+    m_priv->m_filedescriptors.clear();
+
+    for( int fd : other.m_priv->m_filedescriptors ) {
+        // Both messages close their descriptors when they are destroyed
+        int new_fd = fcntl( fd, F_DUPFD_CLOEXEC, 3 );
+
+        if( new_fd < 0 ) {
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to duplicate file descriptor: " << strerror( errno ) );
+            continue;
+        }
+
+        m_priv->m_filedescriptors.push_back( new_fd );
+    }
+}
+
 Variant Message::set_header_field( MessageHeaderFields field, Variant value ) {
     DBus::Variant retval = header_field( field );
 
     m_priv->m_headerMap[ field ] = value;
 
+    if( field == MessageHeaderFields::Signature ) {
+        m_priv->cache_signature();
+    }
+
     return retval;
 }
 
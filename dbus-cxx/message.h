@@ -23,6 +23,7 @@
 
 namespace DBus {
 class ReturnMessage;
+template <typename type> class SignalProxy;
 
 /**
  * @defgroup message DBus Messages
@@ -159,6 +160,12 @@ protected:
 
     void set_flags( uint8_t flags );
 
+    /**
+     * Make this message a copy of the other message: the same flags, header
+     * fields and already marshaled body.  File descriptors are duplicated.
+     */
+    void copy_contents_from( const Message& other );
+
 private:
     std::vector<uint8_t>* body();
     const std::vector<uint8_t>* body() const;
@@ -173,6 +180,7 @@ private:
 
     friend class MessageAppendIterator;
     friend class MessageIterator;
+    template <typename type> friend class SignalProxy;
     friend std::ostream& operator<<( std::ostream& os, const DBus::Message* msg );
 
 };
@@ -78,11 +78,9 @@ MessageIterator::MessageIterator():
 MessageIterator::MessageIterator( const Message& message ):
     m_priv( std::make_shared<priv_data>() ) {
     m_priv->m_message = &message;
-    m_priv->m_demarshal = std::shared_ptr<Demarshaling>(
-            new Demarshaling( m_priv->m_message->body()->data(),
-                m_priv->m_message->body()->size(),
-                m_priv->m_message->endianess() )
-        );
+    m_priv->m_demarshal = std::make_shared<Demarshaling>( m_priv->m_message->body()->data(),
+            m_priv->m_message->body()->size(),
+            m_priv->m_message->endianess() );
     m_priv->m_signatureIterator = m_priv->m_message->signature().begin();
     m_priv->m_subiterInfo.m_subiterDataType = DataType::INVALID;
 }
@@ -90,11 +88,9 @@ MessageIterator::MessageIterator( const Message& message ):
 MessageIterator::MessageIterator( std::shared_ptr<Message> message ):
     m_priv( std::make_shared<priv_data>() ) {
     m_priv->m_message = message.get();
-    m_priv->m_demarshal = std::shared_ptr<Demarshaling>(
-            new Demarshaling( m_priv->m_message->body()->data(),
-                m_priv->m_message->body()->size(),
-                m_priv->m_message->endianess() )
-        );
+    m_priv->m_demarshal = std::make_shared<Demarshaling>( m_priv->m_message->body()->data(),
+            m_priv->m_message->body()->size(),
+            m_priv->m_message->endianess() );
     m_priv->m_signatureIterator = m_priv->m_message->signature().begin();
     m_priv->m_subiterInfo.m_subiterDataType = DataType::INVALID;
 }
@@ -11,7 +11,6 @@
 
 namespace DBus {
 
-class PendingCall;
 class ReturnMessage;
 
 class MethodProxyBase::priv_data {
@@ -63,11 +62,12 @@ std::shared_ptr<const ReturnMessage> DBus::MethodProxyBase::call( std::shared_pt
     return m_priv->m_interface->call( call_message, timeout_milliseconds );
 }
 
-//  std::shared_ptr<PendingCall> DBus::MethodProxyBase::call_async(std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds) const
-//  {
-//    if ( not m_priv->m_interface ) return std::shared_ptr<PendingCall>();
-//    return m_priv->m_interface->call_async(call_message, timeout_milliseconds);
-//  }
+std::shared_ptr<PendingCall> DBus::MethodProxyBase::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) const {
+    if( !m_priv->m_interface ) { return std::shared_ptr<PendingCall>(); }
+
+    return m_priv->m_interface->call_async( call_message, timeout_milliseconds, callback );
+}
 
 void MethodProxyBase::set_interface( InterfaceProxy* proxy ) {
     m_priv->m_interface = proxy;
@@ -7,8 +7,12 @@
  *                                                                         *
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
+#include <dbus-cxx/awaitable.h>
 #include <dbus-cxx/callmessage.h>
 #include <dbus-cxx/headerlog.h>
+#include <dbus-cxx/error.h>
+#include <dbus-cxx/pendingcall.h>
+#include <dbus-cxx/returnmessage.h>
 #include <dbus-cxx/utility.h>
 #include <memory>
 #include <mutex>
@@ -58,7 +62,13 @@ public:
 
     std::shared_ptr<const ReturnMessage> call( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
-    //      std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds=-1 ) const;
+    /**
+     * Send the call without waiting for the reply.
+     *
+     * @see Connection::send_with_reply_async()
+     */
+    std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} ) const;
 
 private:
     void set_interface( InterfaceProxy* proxy );
@@ -110,9 +120,59 @@ public:
         debug_str << name();
         DBUSCXX_DEBUG_STDSTR( "DBus.MethodProxy", debug_str.str() );
 
-        return std::async( std::launch::async, *this, args... );
+        std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+        std::future<void> future = promise->get_future();
+        std::shared_ptr<PendingCall> pending;
+
+        // Errors always go through the future, even if the call never goes out
+        try {
+            std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+            ( *_callmsg << ... << args );
+
+            // The promise is kept when the reply comes in on the dispatching thread
+            pending = MethodProxyBase::call_async( _callmsg, -1,
+                [promise]( std::shared_ptr<PendingCall> call ) {
+                    try {
+                        call->return_message();
+                        promise->set_value();
+                    } catch( ... ) {
+                        promise->set_exception( std::current_exception() );
+                    }
+                } );
+        } catch( ... ) {
+            promise->set_exception( std::current_exception() );
+            return future;
+        }
+
+        if( !pending ) {
+            promise->set_exception( std::make_exception_ptr( ErrorDisconnected() ) );
+        }
+
+        return future;
     }
 
+#ifdef DBUS_CXX_HAS_COROUTINES
+    /**
+     * Call the method from a coroutine: co_await proxy->co_call( args... )
+     *
+     * @see CallAwaitable
+     */
+    CallAwaitable<void> co_call( T_arg... args ) {
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        ( *_callmsg << ... << args );
+
+        return CallAwaitable<void>(
+            [this, _callmsg]( std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+                return MethodProxyBase::call_async( _callmsg, -1, callback );
+            },
+            []( std::shared_ptr<PendingCall> call ) {
+                if( !call ) { throw ErrorDisconnected(); }
+
+                call->return_message();
+            } );
+    }
+#endif
+
     static std::shared_ptr<MethodProxy> create( const std::string& name ) {
         return std::shared_ptr<MethodProxy>( new MethodProxy( name ) );
     }
@@ -160,9 +220,66 @@ public:
         debug_str << name();
         DBUSCXX_DEBUG_STDSTR( "DBus.MethodProxy", debug_str.str() );
 
-        return std::async( std::launch::async, *this, args... );
+        std::shared_ptr<std::promise<T_return>> promise = std::make_shared<std::promise<T_return>>();
+        std::future<T_return> future = promise->get_future();
+        std::shared_ptr<PendingCall> pending;
+
+        // Errors always go through the future, even if the call never goes out
+        try {
+            std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+            MessageAppendIterator iter = _callmsg->append();
+            ( void )( iter << ... << args );
+
+            // The promise is kept when the reply comes in on the dispatching thread
+            pending = MethodProxyBase::call_async( _callmsg, -1,
+                [promise]( std::shared_ptr<PendingCall> call ) {
+                    try {
+                        std::shared_ptr<const ReturnMessage> retmsg = call->return_message();
+                        T_return _retval;
+                        retmsg >> _retval;
+                        promise->set_value( _retval );
+                    } catch( ... ) {
+                        promise->set_exception( std::current_exception() );
+                    }
+                } );
+        } catch( ... ) {
+            promise->set_exception( std::current_exception() );
+            return future;
+        }
+
+        if( !pending ) {
+            promise->set_exception( std::make_exception_ptr( ErrorDisconnected() ) );
+        }
+
+        return future;
     }
 
+#ifdef DBUS_CXX_HAS_COROUTINES
+    /**
+     * Call the method from a coroutine: T_return r = co_await proxy->co_call( args... )
+     *
+     * @see CallAwaitable
+     */
+    CallAwaitable<T_return> co_call( T_arg... args ) {
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        MessageAppendIterator iter = _callmsg->append();
+        ( void )( iter << ... << args );
+
+        return CallAwaitable<T_return>(
+            [this, _callmsg]( std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+                return MethodProxyBase::call_async( _callmsg, -1, callback );
+            },
+            []( std::shared_ptr<PendingCall> call ) {
+                if( !call ) { throw ErrorDisconnected(); }
+
+                std::shared_ptr<const ReturnMessage> retmsg = call->return_message();
+                T_return _retval;
+                retmsg >> _retval;
+                return _retval;
+            } );
+    }
+#endif
+
     static std::shared_ptr<MethodProxy> create( const std::string& name ) {
         return std::shared_ptr<MethodProxy>( new MethodProxy( name ) );
     }
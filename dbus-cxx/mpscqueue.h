@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_MPSCQUEUE_H
+#define DBUSCXX_MPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <utility>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * An unbounded queue that any number of threads may push to without
+ * taking a lock, but that only one thread at a time may pop from.
+ *
+ * Pushing is a single atomic exchange.  An item becomes visible to pop()
+ * once push() has returned; while a push is still in progress, pop() may
+ * report the queue as empty even though size() is not zero.
+ *
+ * T must be default-constructible and movable.
+ */
+template <typename T>
+class MPSCQueue {
+private:
+    struct Node {
+        Node() : next( nullptr ) {}
+        Node( T&& v ) : next( nullptr ), value( std::move( v ) ) {}
+
+        std::atomic<Node*> next;
+        T value;
+    };
+
+public:
+    MPSCQueue() :
+        m_head( new Node() ),
+        m_size( 0 ) {
+        m_tail = m_head.load();
+    }
+
+    ~MPSCQueue() {
+        T discard;
+
+        while( pop( discard ) ) {}
+
+        delete m_tail;
+    }
+
+    MPSCQueue( const MPSCQueue& ) = delete;
+    MPSCQueue& operator=( const MPSCQueue& ) = delete;
+
+    /**
+     * Add an item to the back of the queue.  Safe to call from any thread.
+     */
+    void push( T value ) {
+        Node* node = new Node( std::move( value ) );
+
+        m_size.fetch_add( 1, std::memory_order_relaxed );
+
+        Node* prev = m_head.exchange( node, std::memory_order_acq_rel );
+        prev->next.store( node, std::memory_order_release );
+    }
+
+    /**
+     * Take the item from the front of the queue.  Only one thread may be
+     * popping at a time.
+     *
+     * @param value Set to the item, if there is one
+     * @return False if the queue is empty
+     */
+    bool pop( T& value ) {
+        Node* tail = m_tail;
+        Node* next = tail->next.load( std::memory_order_acquire );
+
+        if( !next ) {
+            return false;
+        }
+
+        // next becomes the new placeholder node, so its value is no longer needed
+        value = std::move( next->value );
+        m_tail = next;
+        delete tail;
+
+        m_size.fetch_sub( 1, std::memory_order_relaxed );
+
+        return true;
+    }
+
+    /** The number of items that have been pushed but not popped yet */
+    size_t size() const {
+        return m_size.load( std::memory_order_relaxed );
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    /* The node that was pushed last; producers swap themselves in here */
+    std::atomic<Node*> m_head;
+    /* A placeholder whose next node is the front of the queue; consumer only */
+    Node* m_tail;
+    std::atomic<size_t> m_size;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_MPSCQUEUE_H */
@@ -131,6 +131,12 @@ bool ObjectProxy::add_interface( std::shared_ptr<InterfaceProxy> interface_ptr )
 
     }
 
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+    if( conn ) {
+        const InterfaceProxy::Signals& signals = interface_ptr->signals();
+        conn->add_object_signal_routes( this, std::vector<std::shared_ptr<SignalProxyBase>>( signals.begin(), signals.end() ) );
+    }
+
     m_priv->m_signal_interface_added.emit( interface_ptr );
 
     return result;
@@ -163,7 +169,15 @@ void ObjectProxy::remove_interface( const std::string& name ) {
 
     }
 
-    if( interface_ptr ) { m_priv->m_signal_interface_removed.emit( interface_ptr ); }
+    if( !interface_ptr ) { return; }
+
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+    if( conn ) {
+        const InterfaceProxy::Signals& signals = interface_ptr->signals();
+        conn->remove_signal_routes( std::vector<std::shared_ptr<SignalProxyBase>>( signals.begin(), signals.end() ) );
+    }
+
+    m_priv->m_signal_interface_removed.emit( interface_ptr );
 }
 
 void ObjectProxy::remove_interface( std::shared_ptr<InterfaceProxy> interface_ptr ) {
@@ -186,7 +200,15 @@ void ObjectProxy::remove_interface( std::shared_ptr<InterfaceProxy> interface_pt
 
     }
 
-    if( interface_removed ) { m_priv->m_signal_interface_removed.emit( interface_ptr ); }
+    if( !interface_removed ) { return; }
+
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+    if( conn ) {
+        const InterfaceProxy::Signals& signals = interface_ptr->signals();
+        conn->remove_signal_routes( std::vector<std::shared_ptr<SignalProxyBase>>( signals.begin(), signals.end() ) );
+    }
+
+    m_priv->m_signal_interface_removed.emit( interface_ptr );
 }
 
 bool ObjectProxy::has_interface( const std::string& name ) const {
@@ -263,6 +285,34 @@ std::shared_ptr<const ReturnMessage> ObjectProxy::call( std::shared_ptr<const Ca
     return conn->send_with_reply_blocking( call_message, timeout_milliseconds );
 }
 
+std::shared_ptr<PendingCall> ObjectProxy::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) const {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( !conn ) { return std::shared_ptr<PendingCall>(); }
+
+    return conn->send_with_reply_async( call_message, timeout_milliseconds, callback );
+}
+
+std::vector<std::shared_ptr<Message>> ObjectProxy::call_batch( const std::vector<std::shared_ptr<const CallMessage>>& messages,
+    int timeout_milliseconds ) const {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( !conn ) { return std::vector<std::shared_ptr<Message>>( messages.size() ); }
+
+    return conn->send_with_reply_batch( messages, timeout_milliseconds );
+}
+
+std::vector<std::shared_ptr<PendingCall>> ObjectProxy::call_batch_async( const std::vector<std::shared_ptr<const CallMessage>>& messages,
+    int timeout_milliseconds,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) const {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( !conn ) { return std::vector<std::shared_ptr<PendingCall>>( messages.size() ); }
+
+    return conn->send_with_reply_batch_async( messages, timeout_milliseconds, callback );
+}
+
 sigc::signal< void( std::shared_ptr<InterfaceProxy> )> ObjectProxy::signal_interface_added() {
     return m_priv->m_signal_interface_added;
 }
@@ -14,6 +14,7 @@
 #include <mutex>
 #include <shared_mutex>
 #include <string>
+#include <vector>
 #include "path.h"
 #include <sigc++/sigc++.h>
 
@@ -25,6 +26,7 @@ namespace DBus {
 class Connection;
 class CallMessage;
 class InterfaceProxy;
+class Message;
 class MethodProxyBase;
 class PendingCall;
 class ReturnMessage;
@@ -125,6 +127,34 @@ public:
      */
     std::shared_ptr<const ReturnMessage> call( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
+    /**
+     * Forwards this CallMessage to the Connection that this ObjectProxy is on, and returns
+     * without waiting for the response.
+     *
+     * @see Connection::send_with_reply_async()
+     */
+    std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} ) const;
+
+    /**
+     * Forwards these CallMessages to the Connection that this ObjectProxy is on all at
+     * once, and waits for all of the responses.
+     *
+     * @see Connection::send_with_reply_batch()
+     */
+    std::vector<std::shared_ptr<Message>> call_batch( const std::vector<std::shared_ptr<const CallMessage>>& messages,
+        int timeout_milliseconds = -1 ) const;
+
+    /**
+     * Forwards these CallMessages to the Connection that this ObjectProxy is on all at
+     * once, and returns without waiting for the responses.
+     *
+     * @see Connection::send_with_reply_batch_async()
+     */
+    std::vector<std::shared_ptr<PendingCall>> call_batch_async( const std::vector<std::shared_ptr<const CallMessage>>& messages,
+        int timeout_milliseconds = -1,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} ) const;
+
     /**
      * Creates a proxy method with a signature based on the template parameters and adds it to the named interface
      * @return A smart pointer to the newly created method proxy
@@ -6,57 +6,124 @@
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
 #include "pendingcall.h"
+#include "dbus-cxx-private.h"
 #include "error.h"
+#include "errormessage.h"
 #include "message.h"
-#include <sigc++/sigc++.h>
+#include "returnmessage.h"
+
+#include <condition_variable>
+#include <mutex>
+
+static const char* LOGGER_NAME = "DBus.PendingCall";
 
 namespace DBus {
 
+class PendingCall::priv_data {
+public:
+    priv_data( uint32_t serial, std::function<void( std::shared_ptr<PendingCall> )> callback ) :
+        m_serial( serial ),
+        m_callback( callback ),
+        m_completed( false ),
+        m_canceled( false )
+    {}
+
+    const uint32_t m_serial;
+    std::function<void( std::shared_ptr<PendingCall> )> m_callback;
+    mutable std::mutex m_lock;
+    mutable std::condition_variable m_cv;
+    std::shared_ptr<Message> m_reply;
+    bool m_completed;
+    bool m_canceled;
+};
+
+PendingCall::PendingCall( uint32_t serial, std::function<void( std::shared_ptr<PendingCall> )> callback ) :
+    m_priv( std::make_unique<priv_data>( serial, callback ) ) {
+}
+
+std::shared_ptr<PendingCall> PendingCall::create( uint32_t serial,
+    std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+    return std::shared_ptr<PendingCall>( new PendingCall( serial, callback ) );
+}
+
+PendingCall::~PendingCall() {
+}
+
+uint32_t PendingCall::serial() const {
+    return m_priv->m_serial;
+}
+
+void PendingCall::cancel() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    m_priv->m_canceled = true;
+}
+
+bool PendingCall::is_canceled() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_canceled;
+}
+
+bool PendingCall::completed() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_completed;
+}
+
+std::shared_ptr<Message> PendingCall::reply() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_reply;
+}
+
+std::shared_ptr<const ReturnMessage> PendingCall::return_message() const {
+    block();
+
+    std::shared_ptr<Message> gotMessage = reply();
+
+    if( gotMessage->type() == MessageType::ERROR ) {
+        std::static_pointer_cast<ErrorMessage>( gotMessage )->throw_error();
+    } else if( gotMessage->type() != MessageType::RETURN ) {
+        throw ErrorUnexpectedResponse();
+    }
+
+    return std::static_pointer_cast<const ReturnMessage>( gotMessage );
+}
+
+void PendingCall::block() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    m_priv->m_cv.wait( lock, [this]() {
+        return m_priv->m_completed;
+    } );
+}
 
-//  PendingCall::PendingCall() :
-//      m_canceled( false )
-//  {
-//  }
-
-//  std::shared_ptr<PendingCall> PendingCall::create()
-//  {
-//    return std::shared_ptr<PendingCall>( new PendingCall() );
-//  }
-
-//  PendingCall::~PendingCall()
-//  {
-//  }
-
-//  void PendingCall::cancel()
-//  {
-//      m_canceled = true;
-//  }
-
-//  bool PendingCall::completed() const
-//  {
-//    return m_reply->is_valid();
-//  }
-
-//  std::shared_ptr<Message> PendingCall::reply() const
-//  {
-//    return m_reply;
-//  }
-
-//  void PendingCall::block() const
-//  {
-//      if( m_canceled ){
-//          return;
-//      }
-//  }
-
-//  sigc::signal<void()> PendingCall::signal_notify() const
-//  {
-//    return m_signal_notify;
-//  }
-
-//  void PendingCall::set_reply( std::shared_ptr<Message> msg ){
-//      m_reply = msg;
-//      m_signal_notify.emit();
-//  }
+void PendingCall::complete( std::shared_ptr<Message> reply ) {
+    std::function<void( std::shared_ptr<PendingCall> )> callback;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+        if( m_priv->m_completed ) { return; }
+
+        m_priv->m_reply = reply;
+        m_priv->m_completed = true;
+
+        if( !m_priv->m_canceled ) {
+            callback = std::move( m_priv->m_callback );
+        }
+
+        m_priv->m_callback = nullptr;
+    }
+
+    m_priv->m_cv.notify_all();
+
+    if( !callback ) { return; }
+
+    try {
+        callback( shared_from_this() );
+    } catch( const std::exception& ex ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Uncaught exception in reply callback: " << ex.what() );
+    } catch( ... ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Uncaught unknown exception in reply callback" );
+    }
+}
 
 }
@@ -5,74 +5,86 @@
  *                                                                         *
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
-#include <sigc++/sigc++.h>
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <functional>
 #include <memory>
+#include <stdint.h>
 
 #ifndef DBUSCXX_PENDING_CALL_H
 #define DBUSCXX_PENDING_CALL_H
 
 namespace DBus {
+class Connection;
 class Message;
+class ReturnMessage;
 
 /**
- * Monitors an asynchronous call, emitting a signal when a response is received
+ * A method call that has been sent, but whose reply may not have come back
+ * yet.  These are returned from Connection::send_with_reply_async().
  *
- * @ingroup message
- *
- * @author Rick L Vinyard Jr <rvinyard@cs.nmsu.edu>
+ * The reply is handed over from the connection's dispatching thread, either
+ * when it comes in or when the call times out.  If the call times out,
+ * the reply is an ErrorMessage with the name DBUSCXX_ERROR_NO_REPLY.
  */
-//  class PendingCall: public sigc::trackable
-//  {
-//    protected:
-
-//      PendingCall( );
-
-//    public:
-//      static std::shared_ptr<PendingCall> create( );
-
-//      virtual ~PendingCall();
-
-//      /**
-//       * Cancel the pending call; that is, signal_notify() will not
-//       * be emitted if and when the reply eventually comes back.
-//       */
-//      void cancel();
-
-//      /**
-//       * Check to see if the reply has actually come back.
-//       */
-//      bool completed() const;
-
-//      /**
-//       * Check to see if the
-//       * @return
-//       */
-////      bool is_timeout() const;
-
-//      /**
-//       * Get the reply that this pending call represents.  If
-//       * completed() is not true, or this call has been canceled,
-//       * returns an invalid pointer.
-//       *
-//       * @return
-//       */
-//      std::shared_ptr<Message> reply() const;
-
-//      void block() const;
-
-//      sigc::signal<void()> signal_notify() const;
-
-//      void set_reply( std::shared_ptr<Message> msg );
-
-//    private:
-
-//      sigc::signal<void()> m_signal_notify;
-
-//      std::shared_ptr<Message> m_reply;
-
-//      bool m_canceled;
-
-//  };
+class PendingCall : public std::enable_shared_from_this<PendingCall> {
+private:
+    PendingCall( uint32_t serial, std::function<void( std::shared_ptr<PendingCall> )> callback );
+
+public:
+    static std::shared_ptr<PendingCall> create( uint32_t serial,
+        std::function<void( std::shared_ptr<PendingCall> )> callback = {} );
+
+    ~PendingCall();
+
+    /** The serial of the call that this is waiting for the reply to */
+    uint32_t serial() const;
+
+    /**
+     * Cancel the pending call; that is, the callback will not be called
+     * if and when the reply eventually comes back.
+     */
+    void cancel();
+
+    bool is_canceled() const;
+
+    /**
+     * Check to see if the reply has actually come back.
+     */
+    bool completed() const;
+
+    /**
+     * Get the reply that this pending call represents.  This is either a
+     * ReturnMessage or an ErrorMessage.  If completed() is not true,
+     * returns an invalid pointer.
+     */
+    std::shared_ptr<Message> reply() const;
+
+    /**
+     * Get the return message, throwing the error if the call failed or
+     * timed out.  Blocks until the reply comes in.
+     */
+    std::shared_ptr<const ReturnMessage> return_message() const;
+
+    /**
+     * Wait until the reply comes back.  This must not be called from the
+     * dispatching thread of the connection, since that is the thread that
+     * the reply comes in on.
+     */
+    void block() const;
+
+private:
+    /**
+     * Called by the Connection when the reply comes in.
+     */
+    void complete( std::shared_ptr<Message> reply );
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+
+    friend class Connection;
+};
 
 }
 
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "pooleddispatcher.h"
+
+#include "connection.h"
+#include "dbus-cxx-private.h"
+#include "standalonedispatcher.h"
+
+#include <mutex>
+#include <thread>
+
+using DBus::PooledDispatcher;
+
+static const char* LOGGER_NAME = "DBus.PooledDispatcher";
+
+class PooledDispatcher::priv_data {
+public:
+    priv_data() :
+        m_running( false )
+    {}
+
+    std::vector<std::shared_ptr<StandaloneDispatcher>> m_workers;
+    /* How many connections each worker has */
+    std::vector<size_t> m_numConnections;
+    std::mutex m_lock;
+    bool m_running;
+};
+
+PooledDispatcher::PooledDispatcher( unsigned int num_threads, bool is_running ) :
+    m_priv( std::make_unique<priv_data>() ) {
+    if( num_threads == 0 ) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+
+    if( num_threads == 0 ) {
+        num_threads = 1;
+    }
+
+    priv_data* priv = m_priv.get();
+
+    for( unsigned int x = 0; x < num_threads; x++ ) {
+        m_priv->m_workers.push_back( StandaloneDispatcher::create( false ) );
+        m_priv->m_numConnections.push_back( 0 );
+
+        // Once a connection goes away, its thread can take on another one
+        m_priv->m_workers.back()->signal_connection_removed().connect( [priv, x]( std::shared_ptr<Connection> ) {
+            std::unique_lock<std::mutex> lock( priv->m_lock );
+            priv->m_numConnections[ x ]--;
+        } );
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Created pool with " << num_threads << " threads" );
+
+    if( is_running ) { this->start(); }
+}
+
+std::shared_ptr<PooledDispatcher> PooledDispatcher::create( unsigned int num_threads, bool is_running ) {
+    return std::shared_ptr<PooledDispatcher>( new PooledDispatcher( num_threads, is_running ) );
+}
+
+PooledDispatcher::~PooledDispatcher() {
+    this->stop();
+}
+
+std::shared_ptr<DBus::Connection> PooledDispatcher::create_connection( BusType type ) {
+    unsigned int worker = next_thread();
+    std::shared_ptr<Connection> conn = m_priv->m_workers[ worker ]->create_connection( type );
+
+    if( !conn ) {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+        m_priv->m_numConnections[ worker ]--;
+    }
+
+    return conn;
+}
+
+std::shared_ptr<DBus::Connection> PooledDispatcher::create_connection( std::string address ) {
+    unsigned int worker = next_thread();
+    std::shared_ptr<Connection> conn = m_priv->m_workers[ worker ]->create_connection( address );
+
+    if( !conn ) {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+        m_priv->m_numConnections[ worker ]--;
+    }
+
+    return conn;
+}
+
+bool PooledDispatcher::add_connection( std::shared_ptr<Connection> connection ) {
+    unsigned int worker = next_thread();
+
+    if( m_priv->m_workers[ worker ]->add_connection( connection ) ) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    m_priv->m_numConnections[ worker ]--;
+
+    return false;
+}
+
+bool PooledDispatcher::start() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    if( m_priv->m_running ) { return false; }
+
+    m_priv->m_running = true;
+
+    for( std::shared_ptr<StandaloneDispatcher> worker : m_priv->m_workers ) {
+        worker->start();
+    }
+
+    return true;
+}
+
+bool PooledDispatcher::stop() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    if( !m_priv->m_running ) { return false; }
+
+    m_priv->m_running = false;
+
+    for( std::shared_ptr<StandaloneDispatcher> worker : m_priv->m_workers ) {
+        worker->stop();
+    }
+
+    return true;
+}
+
+bool PooledDispatcher::is_running() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_running;
+}
+
+unsigned int PooledDispatcher::num_threads() const {
+    return m_priv->m_workers.size();
+}
+
+bool PooledDispatcher::set_cpu_affinity( std::vector<int> cpus ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    bool retval = true;
+
+    for( size_t x = 0; x < m_priv->m_workers.size(); x++ ) {
+        int cpu = cpus.empty() ? -1 : cpus[ x % cpus.size() ];
+
+        if( !m_priv->m_workers[ x ]->set_cpu_affinity( cpu ) ) {
+            retval = false;
+        }
+    }
+
+    return retval;
+}
+
+void PooledDispatcher::set_dispatch_budget( uint32_t max_messages, std::chrono::microseconds max_time ) {
+    for( std::shared_ptr<StandaloneDispatcher> worker : m_priv->m_workers ) {
+        worker->set_dispatch_budget( max_messages, max_time );
+    }
+}
+
+unsigned int PooledDispatcher::next_thread() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    unsigned int least = 0;
+
+    for( unsigned int x = 1; x < m_priv->m_numConnections.size(); x++ ) {
+        if( m_priv->m_numConnections[ x ] < m_priv->m_numConnections[ least ] ) {
+            least = x;
+        }
+    }
+
+    // Count it now, so that connections added at the same time are spread out
+    m_priv->m_numConnections[ least ]++;
+
+    SIMPLELOGGER_TRACE( LOGGER_NAME, "Adding connection to thread " << least );
+
+    return least;
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_POOLED_DISPATCHER
+#define DBUSCXX_POOLED_DISPATCHER
+
+#include "dispatcher.h"
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace DBus {
+
+class Connection;
+
+/**
+ * The PooledDispatcher spreads connections over a number of threads, each
+ * of which runs its own event loop(a StandaloneDispatcher).
+ *
+ * Each connection is given to the thread that has the fewest connections
+ * when it is added, and then stays on that thread for as long as it exists.
+ * That thread is the dispatching thread of the connection, so everything
+ * that is true about the order of messages on a connection with the
+ * StandaloneDispatcher is still true here; only separate connections are
+ * handled in parallel.
+ */
+class PooledDispatcher : public Dispatcher {
+private:
+
+    PooledDispatcher( unsigned int num_threads, bool is_running );
+
+public:
+
+    /**
+     * Create a new PooledDispatcher.
+     *
+     * @param num_threads The number of threads to dispatch on.  If 0, one
+     * thread per CPU is used.
+     * @param is_running True to start dispatching right away
+     */
+    static std::shared_ptr<PooledDispatcher> create( unsigned int num_threads = 0, bool is_running = true );
+
+    ~PooledDispatcher();
+
+    /** @name Managing Connections */
+    //@{
+    std::shared_ptr<Connection> create_connection( BusType type );
+
+    std::shared_ptr<Connection> create_connection( std::string address );
+
+    bool add_connection( std::shared_ptr<Connection> connection );
+
+    //@}
+
+    bool start();
+
+    bool stop();
+
+    bool is_running();
+
+    /** The number of threads that connections are spread over */
+    unsigned int num_threads() const;
+
+    /**
+     * Pin the dispatch threads to CPUs.  Thread N is pinned to
+     * cpus[ N % cpus.size() ].  An empty list lets the threads run on any CPU.
+     *
+     * @param cpus The CPUs to run on
+     * @return True if every thread could be pinned
+     */
+    bool set_cpu_affinity( std::vector<int> cpus );
+
+    /**
+     * Set how much work each thread does on one connection before moving
+     * on to the next one.
+     *
+     * @see StandaloneDispatcher::set_dispatch_budget()
+     */
+    void set_dispatch_budget( uint32_t max_messages,
+                              std::chrono::microseconds max_time = std::chrono::microseconds::zero() );
+
+private:
+    /**
+     * Pick the thread that a new connection should go on.
+     */
+    unsigned int next_thread();
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_POOLED_DISPATCHER */
@@ -9,6 +9,7 @@
 #include <dbus-cxx/variant.h>
 #include <dbus-cxx/interfaceproxy.h>
 #include <dbus-cxx/objectproxy.h>
+#include <dbus-cxx/pendingcall.h>
 #include "property.h"
 
 using DBus::PropertyProxyBase;
@@ -63,6 +64,36 @@ DBus::Variant PropertyProxyBase::variant_value() {
     return m_priv->m_value;
 }
 
+std::shared_ptr<DBus::PendingCall> PropertyProxyBase::variant_value_async( std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+    if( m_priv->m_valueSet || !m_priv->m_interface ){
+        return std::shared_ptr<PendingCall>();
+    }
+
+    std::shared_ptr<CallMessage> msg =
+            CallMessage::create( m_priv->m_interface->object()->destination(),
+                                 m_priv->m_interface->path(),
+                                 DBUS_CXX_PROPERTIES_INTERFACE,
+                                 "Get" );
+    msg << m_priv->m_interface->name() << m_priv->m_name;
+
+    // We may be gone by the time that the reply comes in
+    std::weak_ptr<PropertyProxyBase> weak_this = weak_from_this();
+
+    return m_priv->m_interface->call_async( msg, -1,
+        [weak_this, callback]( std::shared_ptr<PendingCall> call ){
+            std::shared_ptr<PropertyProxyBase> self = weak_this.lock();
+            std::shared_ptr<Message> reply = call->reply();
+
+            if( self && reply->type() == MessageType::RETURN ){
+                self->updated_value( reply_value( call ) );
+            }
+
+            if( callback ){
+                callback( call );
+            }
+        } );
+}
+
 DBus::PropertyUpdateType PropertyProxyBase::update_type() const {
     return m_priv->m_propertyUpdate;
 }
@@ -108,6 +139,15 @@ void PropertyProxyBase::updated_value(Variant value){
     m_priv->m_propertyChangedSignal.emit( m_priv->m_value );
 }
 
+DBus::Variant PropertyProxyBase::reply_value( std::shared_ptr<PendingCall> call ){
+    std::shared_ptr<const ReturnMessage> ret = call->return_message();
+    MessageIterator iter = ret->begin();
+    Variant var;
+    iter >> var;
+
+    return var;
+}
+
 void PropertyProxyBase::invalidate(){
     m_priv->m_valueSet = false;
 }
@@ -5,10 +5,12 @@
  *                                                                         *
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
+#include <dbus-cxx/awaitable.h>
 #include <dbus-cxx/enums.h>
 #include <dbus-cxx/dbus-cxx-config.h>
 #include <dbus-cxx/variant.h>
 #include <sigc++/sigc++.h>
+#include <functional>
 #include <memory>
 
 #ifndef DBUSCXX_PROPERTYPROXY_H
@@ -16,11 +18,12 @@
 namespace DBus {
 
 class InterfaceProxy;
+class PendingCall;
 
 /**
  * Base type of PropertyProxy to allow for storage in e.g. a vector.
  */
-class PropertyProxyBase {
+class PropertyProxyBase : public std::enable_shared_from_this<PropertyProxyBase> {
 protected:
     PropertyProxyBase( std::string name, PropertyUpdateType update );
 
@@ -44,6 +47,39 @@ public:
      */
     Variant variant_value();
 
+    /**
+     * Query the latest value from the remote object without waiting for it.
+     *
+     * If the value is not stale, nothing is sent and this returns an invalid
+     * pointer.  Otherwise, once the reply comes in the value is updated and
+     * the callback is called, both on the dispatching thread.  The callback
+     * is still called if this property has been destroyed in the meantime.
+     */
+    std::shared_ptr<PendingCall> variant_value_async( std::function<void( std::shared_ptr<PendingCall> )> callback = {} );
+
+#ifdef DBUS_CXX_HAS_COROUTINES
+    /**
+     * Get the value of this property from a coroutine:
+     * Variant v = co_await property->co_variant_value()
+     *
+     * @see CallAwaitable
+     */
+    CallAwaitable<Variant> co_variant_value() {
+        // Keep ourselves around until the coroutine has its value
+        std::shared_ptr<PropertyProxyBase> self = shared_from_this();
+
+        return CallAwaitable<Variant>(
+            [self]( std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+                return self->variant_value_async( callback );
+            },
+            [self]( std::shared_ptr<PendingCall> call ) {
+                if( !call ) { return self->variant_value(); }
+
+                return reply_value( call );
+            } );
+    }
+#endif
+
     PropertyUpdateType update_type() const;
 
     /**
@@ -70,6 +106,13 @@ public:
 
     InterfaceProxy* interface_name() const;
 
+protected:
+    /**
+     * Get the value out of the reply to a Properties.Get call, throwing the
+     * error if the call failed.
+     */
+    static Variant reply_value( std::shared_ptr<PendingCall> call );
+
 private:
     void set_interface( InterfaceProxy* proxy );
     void updated_value( Variant value );
@@ -116,6 +159,27 @@ public:
         return t;
     }
 
+#ifdef DBUS_CXX_HAS_COROUTINES
+    /**
+     * Get the value of this property from a coroutine:
+     * T_type t = co_await property->co_value()
+     */
+    CallAwaitable<T_type> co_value() {
+        // Keep ourselves around until the coroutine has its value
+        std::shared_ptr<PropertyProxyBase> self = shared_from_this();
+
+        return CallAwaitable<T_type>(
+            [self]( std::function<void( std::shared_ptr<PendingCall> )> callback ) {
+                return self->variant_value_async( callback );
+            },
+            [self]( std::shared_ptr<PendingCall> call ) {
+                Variant v = call ? reply_value( call ) : self->variant_value();
+                T_type t = v;
+                return t;
+            } );
+    }
+#endif
+
 private:
     void parentUpdated( Variant v ){
         T_type t = v;
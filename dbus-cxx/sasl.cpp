@@ -8,7 +8,9 @@
 #include "sasl.h"
 
 #include "dbus-cxx-private.h"
+#include "utility.h"
 
+#include <cerrno>
 #include <cstring>
 #include <ostream>
 #include <poll.h>
@@ -16,17 +18,37 @@
 #include <sstream>
 #include <unistd.h>
 
+#include <sys/socket.h>
+#include <sys/types.h>
+
 using DBus::priv::SASL;
 
+enum class ClientState {
+    WaitingForOK,
+    WaitingForAgreeUnixFD,
+    Done
+};
+
 class SASL::priv_data {
 public:
     priv_data( int fd, bool negotiateFDPassing ) :
         m_fd( fd ),
-        m_negotiateFDpassing( negotiateFDPassing )
+        m_negotiateFDpassing( negotiateFDPassing ),
+        m_clientState( ClientState::WaitingForOK ),
+        m_negotiatedFD( false ),
+        m_triedAnonymous( false )
     {}
 
     int m_fd;
     bool m_negotiateFDpassing;
+    ClientState m_clientState;
+    bool m_negotiatedFD;
+    bool m_triedAnonymous;
+    std::vector<uint8_t> m_serverGUID;
+    /* Data from the server that does not make up a full line yet */
+    std::string m_lineBuffer;
+    /* When a client authenticating with us runs out of time */
+    std::chrono::steady_clock::time_point m_deadline;
 };
 
 static const std::regex OK_REGEX( "OK ([a-z0-9]*)" );
@@ -34,6 +56,17 @@ static const std::regex DATA_REGEX( "DATA ([a-z0-9]*)" );
 static const std::regex ERROR_REGEX( "ERROR(.*)" );
 static const std::regex AGREE_UNIX_FD_REGEX( "AGREE_UNIX_FD" );
 static const std::regex REJECTED_REGEX( "REJECTED (.*)" );
+static const std::regex AUTH_EXTERNAL_REGEX( "^AUTH EXTERNAL ?([a-fA-F0-9]*)$" );
+static const std::regex AUTH_ANONYMOUS_REGEX( "^AUTH ANONYMOUS ?([a-fA-F0-9]*)$" );
+static const std::regex AUTH_REGEX( "^AUTH.*" );
+static const std::regex ANONYMOUS_REGEX( "\\bANONYMOUS\\b" );
+static const std::regex CLIENT_DATA_REGEX( "^DATA ?([a-fA-F0-9]*)$" );
+static const std::regex NEGOTIATE_UNIX_FD_REGEX( "^NEGOTIATE_UNIX_FD$" );
+static const std::regex BEGIN_REGEX( "^BEGIN$" );
+static const std::regex CANCEL_OR_ERROR_REGEX( "^(CANCEL|ERROR).*" );
+
+/* Maximum length of a single line that we will accept from a client */
+#define SASL_MAX_LINE_LENGTH 16384
 static const char* LOGGER_NAME = "DBus.priv.SASL";
 
 static int hexchar2int( char c ) {
@@ -42,7 +75,11 @@ static int hexchar2int( char c ) {
     }
 
     if( c >= 'a' && c <= 'f' ) {
-        return c - 97;
+        return c - 87;
+    }
+
+    if( c >= 'A' && c <= 'F' ) {
+        return c - 55;
     }
 
     return 0;
@@ -56,96 +93,347 @@ SASL::SASL( int fd, bool negotiateFDPassing ) :
 SASL::~SASL() {}
 
 std::tuple<bool, bool, std::vector<uint8_t>> SASL::authenticate() {
-    bool success = false;
-    bool negotiatedFD = false;
-    std::vector<uint8_t> serverGUID;
+    Status status = Status::Failed;
+
+    if( begin_authenticate() ) {
+        status = Status::InProgress;
+    }
+
+    while( status == Status::InProgress ) {
+        pollfd pollfd;
+        pollfd.fd = m_priv->m_fd;
+        pollfd.events = POLLIN;
+
+        if( poll( &pollfd, 1, -1 ) < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+
+            std::string errmsg = strerror( errno );
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to poll for response from daemon: " + errmsg );
+            status = Status::Failed;
+            break;
+        }
+
+        status = continue_authenticate();
+    }
+
+    return std::make_tuple( status == Status::Success,
+            m_priv->m_negotiatedFD,
+            m_priv->m_serverGUID );
+}
+
+bool SASL::begin_authenticate() {
     uid_t uid = getuid();
-    std::string line;
-    std::smatch regex_match;
 
-    write_data_with_newline( "AUTH EXTERNAL " + encode_as_hex( uid ) );
+    m_priv->m_clientState = ClientState::WaitingForOK;
+    m_priv->m_negotiatedFD = false;
+    m_priv->m_triedAnonymous = false;
+    m_priv->m_lineBuffer.clear();
 
-    line = read_data();
-    if( line.length() == 0 ){
-        goto out;
+    return write_data_with_newline( "AUTH EXTERNAL " + encode_as_hex( uid ) ) > 0;
+}
+
+SASL::Status SASL::continue_authenticate() {
+    char dataBuffer[ 512 ];
+
+    if( m_priv->m_clientState == ClientState::Done ) {
+        return Status::Success;
     }
 
-    if( std::regex_search( line, regex_match, OK_REGEX ) ) {
-        serverGUID = hex_to_vector( regex_match[ 1 ] );
-    } else if( std::regex_search( line, regex_match, ERROR_REGEX ) ) {
-        SIMPLELOGGER_DEBUG( "DBus.priv.SASL", "Unable to authenticate: "
-            + regex_match[ 1 ].str() );
-        goto out;
-    } else if( std::regex_search( line, regex_match, REJECTED_REGEX ) ) {
-        SIMPLELOGGER_DEBUG( "DBus.priv.SASL", "Rejected authentication, available modes: "
-            + regex_match[ 1 ].str() );
-        goto out;
-    } else {
-        // Unknown command, return an error to the server
-        write_data_with_newline( "ERROR Unrecognized response" );
-        goto out;
+    while( true ) {
+        ssize_t bytesRead = ::read( m_priv->m_fd, &dataBuffer, sizeof( dataBuffer ) );
+
+        if( bytesRead < 0 && errno == EINTR ) {
+            continue;
+        }
+
+        if( bytesRead < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+            break;
+        }
+
+        if( bytesRead < 0 ) {
+            std::string errmsg = strerror( errno );
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to read SASL data: " + errmsg );
+            return Status::Failed;
+        }
+
+        if( bytesRead == 0 ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Server closed the connection while authenticating" );
+            return Status::Failed;
+        }
+
+        m_priv->m_lineBuffer.append( dataBuffer, bytesRead );
+
+        /*
+         * The server only ever sends us one line in response to one of our
+         * commands, so once we have a full line there is nothing left to read.
+         */
+        if( m_priv->m_lineBuffer.find( '\n' ) != std::string::npos ) {
+            break;
+        }
+
+        if( m_priv->m_lineBuffer.length() > SASL_MAX_LINE_LENGTH ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Line from server is too long" );
+            return Status::Failed;
+        }
+    }
+
+    std::string::size_type newline;
+
+    while( ( newline = m_priv->m_lineBuffer.find( '\n' ) ) != std::string::npos ) {
+        std::string line = m_priv->m_lineBuffer.substr( 0, newline );
+        m_priv->m_lineBuffer.erase( 0, newline + 1 );
+
+        if( !line.empty() && line.back() == '\r' ) {
+            line.pop_back();
+        }
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Received response: " + line );
+
+        Status status = process_server_line( line );
+
+        if( status != Status::InProgress ) {
+            return status;
+        }
     }
 
-    if( m_priv->m_negotiateFDpassing ) {
-        write_data_with_newline( "NEGOTIATE_UNIX_FD" );
-        line = read_data();
+    return Status::InProgress;
+}
+
+SASL::Status SASL::process_server_line( const std::string& line ) {
+    std::smatch regex_match;
 
-        if( line.length() == 0 ){
-            goto out;
+    if( m_priv->m_clientState == ClientState::WaitingForOK ) {
+        if( std::regex_search( line, regex_match, OK_REGEX ) ) {
+            m_priv->m_serverGUID = hex_to_vector( regex_match[ 1 ] );
+        } else if( std::regex_search( line, regex_match, ERROR_REGEX ) ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to authenticate: "
+                + regex_match[ 1 ].str() );
+            return Status::Failed;
+        } else if( std::regex_search( line, regex_match, REJECTED_REGEX ) ) {
+            std::string modes = regex_match[ 1 ].str();
+
+            if( !m_priv->m_triedAnonymous && std::regex_search( modes, ANONYMOUS_REGEX ) ) {
+                // The server can't check who we are(e.g. over TCP), so don't say
+                m_priv->m_triedAnonymous = true;
+                std::string trace = "dbus-cxx";
+                write_data_with_newline( "AUTH ANONYMOUS " +
+                    vector_to_hex( std::vector<uint8_t>( trace.begin(), trace.end() ) ) );
+                return Status::InProgress;
+            }
+
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Rejected authentication, available modes: "
+                + modes );
+            return Status::Failed;
+        } else {
+            // Unknown command, return an error to the server
+            write_data_with_newline( "ERROR Unrecognized response" );
+            return Status::Failed;
         }
 
+        if( m_priv->m_negotiateFDpassing ) {
+            m_priv->m_clientState = ClientState::WaitingForAgreeUnixFD;
+            write_data_with_newline( "NEGOTIATE_UNIX_FD" );
+            return Status::InProgress;
+        }
+    } else if( m_priv->m_clientState == ClientState::WaitingForAgreeUnixFD ) {
         if( std::regex_search( line, regex_match, AGREE_UNIX_FD_REGEX ) ) {
-            negotiatedFD = true;
+            m_priv->m_negotiatedFD = true;
         }
 
         if( std::regex_search( line, regex_match, ERROR_REGEX ) ) {
-            SIMPLELOGGER_DEBUG( "DBus.priv.SASL", "Unable to negotiate FD passing: "
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to negotiate FD passing: "
                 + regex_match[ 1 ].str() );
         }
     }
 
     write_data_with_newline( "BEGIN" );
+    m_priv->m_clientState = ClientState::Done;
+
+    return Status::Success;
+}
+
+bool SASL::negotiated_fd_passing() const {
+    return m_priv->m_negotiatedFD;
+}
+
+std::vector<uint8_t> SASL::server_guid() const {
+    return m_priv->m_serverGUID;
+}
+
+std::tuple<bool, bool> SASL::authenticate_server( const std::vector<uint8_t>& serverGUID,
+    std::chrono::steady_clock::time_point deadline,
+    bool allowAnonymous ) {
+    std::string rejected = allowAnonymous ? "REJECTED EXTERNAL ANONYMOUS" : "REJECTED EXTERNAL";
+    bool authenticated = false;
+    bool negotiatedFD = false;
+    bool waitingForData = false;
+    std::string line;
+    std::smatch regex_match;
+    uint8_t nulbyte = 0xFF;
+
+    m_priv->m_deadline = deadline;
+
+    /* The client must send a single nul byte before anything else */
+    {
+        pollfd pollfd;
+        pollfd.fd = m_priv->m_fd;
+        pollfd.events = POLLIN;
+
+        if( poll( &pollfd, 1, DBus::priv::milliseconds_until( m_priv->m_deadline ) ) <= 0 ||
+            ::read( m_priv->m_fd, &nulbyte, 1 ) != 1 ||
+            nulbyte != 0 ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Client did not send initial nul byte" );
+            return std::make_tuple( false, false );
+        }
+    }
+
+    while( true ) {
+        line = read_line();
+
+        if( line.length() == 0 ) {
+            return std::make_tuple( false, false );
+        }
+
+        if( waitingForData && std::regex_search( line, regex_match, CLIENT_DATA_REGEX ) ) {
+            waitingForData = false;
+
+            if( client_uid_allowed( regex_match[ 1 ] ) ) {
+                authenticated = true;
+                write_data_with_newline( "OK " + vector_to_hex( serverGUID ) );
+            } else {
+                write_data_with_newline( rejected );
+            }
+        } else if( !authenticated && std::regex_search( line, regex_match, AUTH_EXTERNAL_REGEX ) ) {
+            if( regex_match[ 1 ].length() == 0 ) {
+                // No initial response, ask the client for it
+                waitingForData = true;
+                write_data_with_newline( "DATA" );
+            } else if( client_uid_allowed( regex_match[ 1 ] ) ) {
+                authenticated = true;
+                write_data_with_newline( "OK " + vector_to_hex( serverGUID ) );
+            } else {
+                write_data_with_newline( rejected );
+            }
+        } else if( !authenticated && allowAnonymous &&
+            std::regex_search( line, regex_match, AUTH_ANONYMOUS_REGEX ) ) {
+            authenticated = true;
+            write_data_with_newline( "OK " + vector_to_hex( serverGUID ) );
+        } else if( !authenticated && std::regex_search( line, regex_match, AUTH_REGEX ) ) {
+            write_data_with_newline( rejected );
+        } else if( std::regex_search( line, regex_match, CANCEL_OR_ERROR_REGEX ) ) {
+            authenticated = false;
+            waitingForData = false;
+            write_data_with_newline( rejected );
+        } else if( authenticated && std::regex_search( line, regex_match, NEGOTIATE_UNIX_FD_REGEX ) ) {
+            if( m_priv->m_negotiateFDpassing ) {
+                negotiatedFD = true;
+                write_data_with_newline( "AGREE_UNIX_FD" );
+            } else {
+                write_data_with_newline( "ERROR FD passing not supported on this transport" );
+            }
+        } else if( authenticated && std::regex_search( line, regex_match, BEGIN_REGEX ) ) {
+            return std::make_tuple( true, negotiatedFD );
+        } else {
+            write_data_with_newline( "ERROR Unrecognized command" );
+        }
+    }
+}
+
+bool SASL::client_uid_allowed( const std::string& hexUid ) {
+    std::vector<uint8_t> uidChars = hex_to_vector( hexUid );
+    std::string uidString( uidChars.begin(), uidChars.end() );
+    uid_t ourUid = getuid();
+    uid_t claimedUid;
+    uid_t peerUid = ourUid;
+
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t credLen = sizeof( struct ucred );
+
+    if( getsockopt( m_priv->m_fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen ) < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to get peer credentials: " + errmsg );
+        return false;
+    }
 
-    success = true;
+    peerUid = cred.uid;
+#endif
 
-out:
+    if( uidString.empty() ) {
+        // The client did not tell us who it is, use what the kernel says
+        claimedUid = peerUid;
+    } else {
+        if( uidString.find_first_not_of( "0123456789" ) != std::string::npos ) {
+            return false;
+        }
+
+        claimedUid = std::stoul( uidString );
+    }
 
-    return std::make_tuple( success, negotiatedFD, serverGUID );
+    if( claimedUid != peerUid ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Client claimed UID " << claimedUid
+            << " but is actually UID " << peerUid );
+        return false;
+    }
+
+    if( peerUid != ourUid && peerUid != 0 ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Rejecting client UID " << peerUid );
+        return false;
+    }
+
+    return true;
 }
 
 int SASL::write_data_with_newline( std::string data ) {
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "Sending command: " + data );
     data += "\r\n";
-    return ::write( m_priv->m_fd, data.c_str(), data.length() );
+    return ::send( m_priv->m_fd, data.c_str(), data.length(), MSG_NOSIGNAL );
 }
 
-std::string SASL::read_data() {
+std::string SASL::read_line() {
     std::string line_read;
-    char dataBuffer[ 512 ];
-    ssize_t bytesRead;
+    char c;
+
+    /*
+     * Read one byte at a time, since the client may send us the start of the
+     * first message right after BEGIN and we must not consume any of that.
+     */
+    while( line_read.length() < SASL_MAX_LINE_LENGTH ) {
+        pollfd pollfd;
+        pollfd.fd = m_priv->m_fd;
+        pollfd.events = POLLIN;
+
+        if( poll( &pollfd, 1, DBus::priv::milliseconds_until( m_priv->m_deadline ) ) <= 0 ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Timed out waiting for data from client" );
+            return std::string();
+        }
 
-    pollfd pollfd;
-    pollfd.fd = m_priv->m_fd;
-    pollfd.events = POLLIN;
+        ssize_t bytesRead = ::read( m_priv->m_fd, &c, 1 );
 
-    if( poll( &pollfd, 1, -1 ) < 0 ) {
-        std::string errmsg = strerror( errno );
-        SIMPLELOGGER_ERROR( "DBus.priv.SASL", "Unable to poll for response from daemon: " + errmsg );
-        return line_read;
-    }
+        if( bytesRead < 0 && ( errno == EAGAIN || errno == EINTR ) ) {
+            continue;
+        }
 
-    // TODO Note that we are making an assumption here that we don't
-    // have a short read.  This may need to be fixed in the future.
-    bytesRead = ::read( m_priv->m_fd, &dataBuffer, 512 );
-    if( bytesRead < 0 ){
-        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to read SASL data!" );
-        return std::string();
-    }
-    line_read = std::string( dataBuffer, bytesRead );
+        if( bytesRead <= 0 ) {
+            return std::string();
+        }
 
-    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Received response: " + line_read );
+        if( c == '\n' ) {
+            if( !line_read.empty() && line_read.back() == '\r' ) {
+                line_read.pop_back();
+            }
+
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Received command: " + line_read );
+            return line_read;
+        }
 
-    return line_read;
+        line_read += c;
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Line from client is too long" );
+    return std::string();
 }
 
 std::string SASL::encode_as_hex( int num ) {
@@ -166,6 +454,20 @@ std::string SASL::encode_as_hex( int num ) {
 
 }
 
+std::string SASL::vector_to_hex( const std::vector<uint8_t>& data ) {
+    static const char* hexChars = "0123456789abcdef";
+    std::string retval;
+
+    retval.reserve( data.size() * 2 );
+
+    for( uint8_t byte : data ) {
+        retval += hexChars[ byte >> 4 ];
+        retval += hexChars[ byte & 0x0F ];
+    }
+
+    return retval;
+}
+
 std::vector<uint8_t> SASL::hex_to_vector( std::string hexData ) {
     std::vector<uint8_t> retval;
 
@@ -10,6 +10,7 @@
 
 #include <dbus-cxx/dbus-cxx-config.h>
 
+#include <chrono>
 #include <memory>
 #include <stdint.h>
 #include <string>
@@ -35,8 +36,15 @@ public:
 
     ~SASL();
 
+    enum class Status {
+        InProgress,
+        Success,
+        Failed
+    };
+
     /**
-     * Perform the authentication with the server.
+     * Perform the authentication with the server.  This blocks until the
+     * authentication has finished.
      *
      * @return A tuple containing the following:
      * - bool Success of authentication
@@ -45,11 +53,61 @@ public:
      */
     std::tuple<bool, bool, std::vector<uint8_t>> authenticate();
 
+    /**
+     * Start authenticating with the server without blocking.  After this
+     * has been called, continue_authenticate() must be called whenever
+     * the FD becomes readable, until it returns something other than
+     * Status::InProgress.
+     *
+     * @return False if we could not send our first command
+     */
+    bool begin_authenticate();
+
+    /**
+     * Process whatever data the server has sent us so far.  The data may
+     * arrive in any number of pieces; lines are only acted upon once they
+     * have been fully received.
+     *
+     * @return The current status of the authentication
+     */
+    Status continue_authenticate();
+
+    /** True if the server agreed to FD passing.  Only valid after success. */
+    bool negotiated_fd_passing() const;
+
+    /** The GUID of the server.  Only valid after success. */
+    std::vector<uint8_t> server_guid() const;
+
+    /**
+     * Perform the server side of the authentication with a client.
+     * This is used for peer-to-peer connections, where there is no
+     * bus daemon in between us and the other side.
+     *
+     * The EXTERNAL mechanism is supported, where the client must
+     * be running as the same user that we are running as.  If allowAnonymous
+     * is true, the ANONYMOUS mechanism is supported as well.
+     *
+     * @param serverGUID The GUID of this server
+     * @param deadline The client must be done authenticating by this time,
+     * no matter how slowly it sends us data
+     * @param allowAnonymous True to let clients authenticate without saying
+     * who they are.  Used for TCP, where we can't check who the client is.
+     * @return A tuple containing the following:
+     * - bool Success of authentication
+     * - bool If this supports FD passing
+     */
+    std::tuple<bool, bool> authenticate_server( const std::vector<uint8_t>& serverGUID,
+        std::chrono::steady_clock::time_point deadline,
+        bool allowAnonymous = false );
+
 private:
     int write_data_with_newline( std::string data );
-    std::string read_data();
+    Status process_server_line( const std::string& line );
+    std::string read_line();
     std::string encode_as_hex( int num );
+    std::string vector_to_hex( const std::vector<uint8_t>& data );
     std::vector<uint8_t> hex_to_vector( std::string hexData );
+    bool client_uid_allowed( const std::string& hexUid );
 
 private:
     class priv_data;
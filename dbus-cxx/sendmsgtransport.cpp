@@ -7,11 +7,13 @@
  ***************************************************************************/
 #include "sendmsgtransport.h"
 
+#include "bufferpool.h"
 #include "dbus-cxx-private.h"
 #include "utility.h"
 #include "validator.h"
 #include "message.h"
 
+#include <algorithm>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -38,11 +40,13 @@ public:
         lpWSARecvMsg( NULL ) {
         ::memset( &rx_msg, 0, sizeof( WSAMSG ) );
         ::memset( &tx_msg, 0, sizeof( WSAMSG ) );
-        m_sendBuffer.reserve( SEND_BUFFER_SIZE );
+        m_sendBuffer = BufferPool::instance().acquire( SEND_BUFFER_SIZE );
+        m_sendBuffer.clear();
     }
 
     ~priv_data() {
-        free( rx_msg.lpBuffers[0].buf );
+        BufferPool::instance().release( std::move( m_receiveBuffer ) );
+        BufferPool::instance().release( std::move( m_sendBuffer ) );
         free( rx_msg.Control.buf );
         free( tx_msg.Control.buf );
     }
@@ -50,11 +54,15 @@ public:
     int m_fd;
     bool m_ok;
     std::vector<uint8_t> m_sendBuffer;
+    std::vector<uint8_t> m_receiveBuffer;
 
     WSAMSG rx_msg;
     WSABUF rx_buf;
     int rx_capacity;
     int rx_control_capacity;
+    /* When we last needed the big buffers */
+    std::chrono::steady_clock::time_point m_lastLargeReceive;
+    std::chrono::steady_clock::time_point m_lastLargeSend;
 
     WSAMSG tx_msg;
     WSABUF tx_buf;
@@ -64,7 +72,7 @@ public:
     void init() {
         // Setup the RX data msghdr
         rx_msg.lpBuffers = &rx_buf;
-        rx_msg.lpBuffers[0].buf = ( PCHAR ) ::malloc( rx_capacity );
+        set_rx_capacity( rx_capacity );
         rx_msg.lpBuffers[0].len = rx_capacity;
         rx_msg.dwBufferCount = 1;
         rx_msg.Control.buf = ( PCHAR ) ::malloc( rx_control_capacity );
@@ -96,9 +104,67 @@ public:
     }
 
     void set_rx_capacity( ssize_t capacity ) {
-        free( rx_msg.lpBuffers[0].buf );
-        rx_msg.lpBuffers[0].buf = ( PCHAR ) ::malloc( capacity );
-        rx_capacity = capacity;
+        if( m_receiveBuffer.capacity() < static_cast<size_t>( capacity ) ) {
+            BufferPool::instance().release( std::move( m_receiveBuffer ) );
+            m_receiveBuffer = BufferPool::instance().acquire( capacity );
+        }
+
+        // Only the bytes past what the buffer already held get filled in
+        if( m_receiveBuffer.size() < static_cast<size_t>( capacity ) ) {
+            m_receiveBuffer.resize( capacity );
+        }
+
+        rx_msg.lpBuffers[0].buf = ( PCHAR ) m_receiveBuffer.data();
+        rx_capacity = m_receiveBuffer.size();
+    }
+
+    /**
+     * Note that a message of the given size was read, so that a large
+     * receive buffer is not given back while we still need it.
+     */
+    void note_receive( ssize_t messageSize ) {
+        if( messageSize > RECEIVE_BUFFER_SIZE ) {
+            m_lastLargeReceive = std::chrono::steady_clock::now();
+        }
+    }
+
+    /**
+     * Note that the message in the send buffer went out, so that a large
+     * send buffer is not given back while we still need it.
+     */
+    void note_send() {
+        if( m_sendBuffer.size() > SEND_BUFFER_SIZE ) {
+            m_lastLargeSend = std::chrono::steady_clock::now();
+        }
+
+        m_sendBuffer.clear();
+    }
+
+    std::chrono::steady_clock::time_point release_idle_buffers() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+        std::chrono::milliseconds idleTimeout = BufferPool::instance().idle_timeout();
+
+        if( m_receiveBuffer.capacity() > RECEIVE_BUFFER_SIZE ) {
+            if( now - m_lastLargeReceive < idleTimeout ) {
+                next = m_lastLargeReceive + idleTimeout;
+            } else {
+                BufferPool::instance().release( std::move( m_receiveBuffer ) );
+                m_receiveBuffer = BufferPool::instance().acquire( RECEIVE_BUFFER_SIZE );
+                set_rx_capacity( RECEIVE_BUFFER_SIZE );
+            }
+        }
+
+        if( m_sendBuffer.capacity() > SEND_BUFFER_SIZE ) {
+            if( now - m_lastLargeSend < idleTimeout ) {
+                next = std::min( next, m_lastLargeSend + idleTimeout );
+            } else {
+                BufferPool::instance().release( std::move( m_sendBuffer ) );
+                m_sendBuffer = BufferPool::instance().acquire( SEND_BUFFER_SIZE );
+            }
+        }
+
+        return next;
     }
 
     int peek( ssize_t size ) {
@@ -148,11 +214,13 @@ public:
         {
         ::memset( &rx_msg, 0, sizeof( struct msghdr ) );
         ::memset( &tx_msg, 0, sizeof( struct msghdr ) );
-        m_sendBuffer.reserve( SEND_BUFFER_SIZE );
+        m_sendBuffer = BufferPool::instance().acquire( SEND_BUFFER_SIZE );
+        m_sendBuffer.clear();
     }
 
     ~priv_data() {
-        free( rx_msg.msg_iov[0].iov_base );
+        BufferPool::instance().release( std::move( m_receiveBuffer ) );
+        BufferPool::instance().release( std::move( m_sendBuffer ) );
         free( rx_msg.msg_control );
         free( tx_control_data );
     }
@@ -160,11 +228,15 @@ public:
     int m_fd;
     bool m_ok;
     std::vector<uint8_t> m_sendBuffer;
+    std::vector<uint8_t> m_receiveBuffer;
 
     struct msghdr rx_msg;
     struct iovec rx_buf;
     int rx_capacity;
     int rx_control_capacity;
+    /* When we last needed the big buffers */
+    std::chrono::steady_clock::time_point m_lastLargeReceive;
+    std::chrono::steady_clock::time_point m_lastLargeSend;
 
     struct msghdr tx_msg;
     struct iovec tx_buf;
@@ -174,7 +246,7 @@ public:
     void init() {
         // Setup the RX data msghdr
         rx_msg.msg_iov = &rx_buf;
-        rx_msg.msg_iov[0].iov_base = ::malloc( rx_capacity );
+        set_rx_capacity( rx_capacity );
         rx_msg.msg_iov[0].iov_len = rx_capacity;
         rx_msg.msg_iovlen = 1;
         rx_msg.msg_control = ::malloc( rx_control_capacity );
@@ -198,9 +270,67 @@ public:
     }
 
     void set_rx_capacity( ssize_t capacity ) {
-        free( rx_msg.msg_iov[0].iov_base );
-        rx_msg.msg_iov[0].iov_base = ::malloc( capacity );
-        rx_capacity = capacity;
+        if( m_receiveBuffer.capacity() < static_cast<size_t>( capacity ) ) {
+            BufferPool::instance().release( std::move( m_receiveBuffer ) );
+            m_receiveBuffer = BufferPool::instance().acquire( capacity );
+        }
+
+        // Only the bytes past what the buffer already held get filled in
+        if( m_receiveBuffer.size() < static_cast<size_t>( capacity ) ) {
+            m_receiveBuffer.resize( capacity );
+        }
+
+        rx_msg.msg_iov[0].iov_base = m_receiveBuffer.data();
+        rx_capacity = m_receiveBuffer.size();
+    }
+
+    /**
+     * Note that a message of the given size was read, so that a large
+     * receive buffer is not given back while we still need it.
+     */
+    void note_receive( ssize_t messageSize ) {
+        if( messageSize > RECEIVE_BUFFER_SIZE ) {
+            m_lastLargeReceive = std::chrono::steady_clock::now();
+        }
+    }
+
+    /**
+     * Note that the message in the send buffer went out, so that a large
+     * send buffer is not given back while we still need it.
+     */
+    void note_send() {
+        if( m_sendBuffer.size() > SEND_BUFFER_SIZE ) {
+            m_lastLargeSend = std::chrono::steady_clock::now();
+        }
+
+        m_sendBuffer.clear();
+    }
+
+    std::chrono::steady_clock::time_point release_idle_buffers() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+        std::chrono::milliseconds idleTimeout = BufferPool::instance().idle_timeout();
+
+        if( m_receiveBuffer.capacity() > RECEIVE_BUFFER_SIZE ) {
+            if( now - m_lastLargeReceive < idleTimeout ) {
+                next = m_lastLargeReceive + idleTimeout;
+            } else {
+                BufferPool::instance().release( std::move( m_receiveBuffer ) );
+                m_receiveBuffer = BufferPool::instance().acquire( RECEIVE_BUFFER_SIZE );
+                set_rx_capacity( RECEIVE_BUFFER_SIZE );
+            }
+        }
+
+        if( m_sendBuffer.capacity() > SEND_BUFFER_SIZE ) {
+            if( now - m_lastLargeSend < idleTimeout ) {
+                next = std::min( next, m_lastLargeSend + idleTimeout );
+            } else {
+                BufferPool::instance().release( std::move( m_sendBuffer ) );
+                m_sendBuffer = BufferPool::instance().acquire( SEND_BUFFER_SIZE );
+            }
+        }
+
+        return next;
     }
 
     int peek( ssize_t size ) {
@@ -338,6 +468,8 @@ ssize_t SendmsgTransport::writeMessage( std::shared_ptr<const DBus::Message> mes
         m_priv->m_ok = false;
     }
 
+    m_priv->note_send();
+
     return ret;
 }
 
@@ -442,6 +574,8 @@ std::shared_ptr<DBus::Message> SendmsgTransport::readMessage() {
     std::shared_ptr<DBus::Message> retmsg =
         DBus::Message::create_from_data( header_raw, m_priv->rx_size(), fds );
 
+    m_priv->note_receive( total_len );
+
     return retmsg;
 }
 
@@ -453,6 +587,15 @@ int SendmsgTransport::fd() const {
     return m_priv->m_fd;
 }
 
+bool SendmsgTransport::has_borrowed_buffers() const {
+    return m_priv->m_receiveBuffer.capacity() > RECEIVE_BUFFER_SIZE ||
+        m_priv->m_sendBuffer.capacity() > SEND_BUFFER_SIZE;
+}
+
+std::chrono::steady_clock::time_point SendmsgTransport::release_idle_buffers() {
+    return m_priv->release_idle_buffers();
+}
+
 void SendmsgTransport::purgeData(){
 //    If a message is
 //    too long to fit in the supplied buffers, and MSG_PEEK is not set in
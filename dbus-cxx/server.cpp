@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "server.h"
+
+#include "connection.h"
+#include "dbus-cxx-private.h"
+#include "transport.h"
+#include "utility.h"
+
+#include <cstring>
+#include <libgen.h>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static const char* LOGGER_NAME = "DBus.Server";
+
+using DBus::Server;
+
+class Server::priv_data {
+public:
+    priv_data( bool allow_anonymous ) :
+        m_listenFd( -1 ),
+        m_allowAnonymous( allow_anonymous )
+    {}
+
+    int m_listenFd;
+    bool m_allowAnonymous;
+    std::string m_address;
+    std::vector<uint8_t> m_guid;
+    std::vector<uint8_t> m_nonce;
+    std::string m_nonceFile;
+};
+
+Server::Server( std::string address, bool allow_anonymous ) :
+    m_priv( std::make_unique<priv_data>( allow_anonymous ) ) {
+    std::random_device rd;
+    std::ostringstream addressWithGuid;
+
+    for( int x = 0; x < 16; x++ ) {
+        m_priv->m_guid.push_back( rd() & 0xFF );
+    }
+
+    priv::Transport::ListenInfo info = priv::Transport::open_listener( address );
+
+    m_priv->m_listenFd = info.fd;
+    m_priv->m_nonce = info.nonce;
+    m_priv->m_nonceFile = info.nonceFile;
+
+    if( m_priv->m_listenFd < 0 ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to listen on " + address );
+        return;
+    }
+
+    // Without a nonce, nobody on plain TCP can prove who they are
+    if( info.address.compare( 0, 4, "tcp:" ) == 0 && !allow_anonymous ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Not listening on " + address
+            + ": tcp: needs allow_anonymous, or use nonce-tcp: instead" );
+        close( m_priv->m_listenFd );
+        m_priv->m_listenFd = -1;
+        return;
+    }
+
+    addressWithGuid << info.address << ",guid=" << std::hex;
+
+    for( uint8_t byte : m_priv->m_guid ) {
+        addressWithGuid.width( 2 );
+        addressWithGuid.fill( '0' );
+        addressWithGuid << static_cast<int>( byte );
+    }
+
+    m_priv->m_address = addressWithGuid.str();
+}
+
+Server::~Server() {
+    struct sockaddr_un addr;
+    socklen_t addr_len = sizeof( addr );
+
+    if( m_priv->m_listenFd < 0 ) {
+        return;
+    }
+
+    // Clean up after ourselves if we were listening on a path
+    memset( &addr, 0, sizeof( addr ) );
+
+    if( getsockname( m_priv->m_listenFd, ( struct sockaddr* )&addr, &addr_len ) == 0 &&
+        addr.sun_family == AF_UNIX &&
+        addr.sun_path[ 0 ] != 0 ) {
+        unlink( addr.sun_path );
+    }
+
+    // The nonce file lives in a directory that we made just for it
+    if( !m_priv->m_nonceFile.empty() ) {
+        std::vector<char> nonceDir( m_priv->m_nonceFile.begin(), m_priv->m_nonceFile.end() );
+        nonceDir.push_back( 0 );
+
+        unlink( m_priv->m_nonceFile.c_str() );
+        rmdir( dirname( nonceDir.data() ) );
+    }
+
+    close( m_priv->m_listenFd );
+}
+
+std::shared_ptr<Server> Server::create( std::string address, bool allow_anonymous ) {
+    return std::shared_ptr<Server>( new Server( address, allow_anonymous ) );
+}
+
+bool Server::is_valid() const {
+    return m_priv->m_listenFd >= 0;
+}
+
+std::string Server::address() const {
+    return m_priv->m_address;
+}
+
+int Server::fd() const {
+    return m_priv->m_listenFd;
+}
+
+std::shared_ptr<DBus::Connection> Server::accept( int timeout_milliseconds ) {
+    if( !is_valid() ) {
+        return std::shared_ptr<Connection>();
+    }
+
+    std::vector<int> fds;
+    fds.push_back( m_priv->m_listenFd );
+
+    std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> fdResponse =
+        DBus::priv::wait_for_fd_activity( fds, timeout_milliseconds );
+
+    if( std::get<0>( fdResponse ) || std::get<2>( fdResponse ).empty() ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "No client connected in time" );
+        return std::shared_ptr<Connection>();
+    }
+
+    std::shared_ptr<priv::Transport> transport =
+        priv::Transport::accept_transport( m_priv->m_listenFd, m_priv->m_guid, m_priv->m_nonce,
+            m_priv->m_allowAnonymous );
+
+    if( !transport ) {
+        return std::shared_ptr<Connection>();
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Accepted new peer connection" );
+
+    return std::shared_ptr<Connection>( new Connection( transport ) );
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_SERVER_H
+#define DBUSCXX_SERVER_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <memory>
+#include <string>
+
+namespace DBus {
+
+class Connection;
+
+/**
+ * A Server listens for direct(peer-to-peer) connections from clients,
+ * without a bus daemon in between.  Clients connect to the address
+ * of the server with Connection::create_peer().
+ *
+ * Each accepted client results in a new Connection, which can then be
+ * added to a Dispatcher like any other Connection.  Since there is no
+ * bus daemon, these connections do not have a unique name and cannot
+ * request names or add matches on a bus; messages go straight to the
+ * other side.
+ *
+ * @ingroup core
+ */
+class Server {
+private:
+    Server( std::string address, bool allow_anonymous );
+
+public:
+    /**
+     * Create a new Server, listening on the given address.  The address must
+     * be in DBus transport format, e.g. unix:path=/tmp/dbus-test,
+     * unix:abstract=dbus-test, tcp:host=localhost,port=0 or
+     * nonce-tcp:host=localhost
+     *
+     * For TCP addresses, a port of 0 means to pick any free port; address()
+     * then returns the real port.  Clients connecting over TCP authenticate
+     * anonymously, since there is no way to check who they are, and cannot
+     * pass file descriptors.  With nonce-tcp:, clients must first prove that
+     * they can read the nonce file that we create.  Plain tcp: lets anybody
+     * who can reach the port connect, so it must be asked for with
+     * allow_anonymous; otherwise the server is not valid.
+     *
+     * @param address The address to listen on
+     * @param allow_anonymous True to let clients authenticate anonymously
+     * without a nonce.  Needed for tcp: addresses.
+     * @return The server.  Check is_valid() to see if we are listening.
+     */
+    static std::shared_ptr<Server> create( std::string address, bool allow_anonymous = false );
+
+    ~Server();
+
+    /** True if this server is listening for connections */
+    bool is_valid() const;
+
+    /**
+     * The address that clients should connect to.  This includes the GUID
+     * of this server.
+     */
+    std::string address() const;
+
+    /**
+     * The listening file descriptor.  This becomes readable whenever
+     * there is a client waiting to be accepted.
+     */
+    int fd() const;
+
+    /**
+     * Accept a new client, and perform the server side of the authentication.
+     *
+     * @param timeout_milliseconds How long to wait for a client to connect.
+     * If -1, waits forever.
+     * @return The new connection, or an invalid shared_ptr if no client
+     * connected in time or the client could not be authenticated.
+     */
+    std::shared_ptr<Connection> accept( int timeout_milliseconds = -1 );
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_SERVER_H */
@@ -82,6 +82,33 @@ public:
         }
     }
 
+    /**
+     * Send this signal to each of the given destinations, instead of
+     * broadcasting it.  The arguments are only marshaled once, and all of
+     * the copies are written out together.
+     *
+     * Local handlers are not called, and the emission policy does not
+     * apply; the signal is always sent right away.
+     *
+     * @param destinations The bus names to send the signal to
+     * @return True if the signal was queued for sending to at least one
+     * destination
+     */
+    bool emit_to( const std::vector<std::string>& destinations, T_type... args ) {
+        std::shared_ptr<SignalMessage> __msg = SignalMessage::create( path(), interface_name(), name() );
+        DBUSCXX_DEBUG_STDSTR( "DBus.Signal", "Sending following signal to "
+            << destinations.size()
+            << " destinations: "
+            << __msg->path()
+            << " "
+            << __msg->interface_name()
+            << " "
+            << __msg->member() );
+
+        ( *__msg << ... << args );
+        return this->handle_dbus_outgoing( __msg, destinations );
+    }
+
 protected:
 
     friend class Interface;
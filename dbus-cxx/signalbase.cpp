@@ -7,14 +7,32 @@
  ***************************************************************************/
 #include "signalbase.h"
 #include "connection.h"
+#include "emissionthrottle.h"
 #include "path.h"
+#include "signalmessage.h"
+#include "dbus-cxx-private.h"
+#include <mutex>
+
+static const char* LOGGER_NAME = "DBus.SignalBase";
 
 namespace DBus {
 class Message;
 
+/**
+ * The emission that is being held back, if any.  This is shared with the
+ * timer that sends it, since the signal may be gone by then.
+ */
+struct HeldEmission {
+    std::mutex lock;
+    priv::EmissionThrottle throttle;
+    std::shared_ptr<const Message> message;
+};
+
 class SignalBase::priv_data {
 public:
-    priv_data() {}
+    priv_data() :
+        m_held( std::make_shared<HeldEmission>() )
+    {}
 
     std::weak_ptr<Connection> m_connection;
     std::string m_sender;
@@ -23,6 +41,7 @@ public:
     std::string m_name;
     std::string m_destination;
     std::string m_match_rule;
+    std::shared_ptr<HeldEmission> m_held;
 };
 
 SignalBase::SignalBase( const std::string& path, const std::string& interface_name, const std::string& name ):
@@ -70,6 +89,7 @@ const std::string& SignalBase::sender() const {
 
 void SignalBase::set_sender( const std::string& s ) {
     m_priv->m_sender = s;
+    routes_changed();
 }
 
 const std::string& SignalBase::interface_name() const {
@@ -78,6 +98,7 @@ const std::string& SignalBase::interface_name() const {
 
 void SignalBase::set_interface( const std::string& i ) {
     m_priv->m_interface = i;
+    routes_changed();
 }
 
 const std::string& SignalBase::name() const {
@@ -86,6 +107,7 @@ const std::string& SignalBase::name() const {
 
 void SignalBase::set_name( const std::string& n ) {
     m_priv->m_name = n;
+    routes_changed();
 }
 
 const Path& SignalBase::path() const {
@@ -94,6 +116,7 @@ const Path& SignalBase::path() const {
 
 void SignalBase::set_path( const std::string& s ) {
     m_priv->m_path = s;
+    routes_changed();
 }
 
 const std::string& SignalBase::destination() const {
@@ -104,12 +127,89 @@ void SignalBase::set_destination( const std::string& s ) {
     m_priv->m_destination = s;
 }
 
+void SignalBase::routes_changed() {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( conn ) { conn->update_signal_route( this ); }
+}
+
+void SignalBase::set_emission_policy( EmissionMode mode, std::chrono::milliseconds interval ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_held->lock );
+    m_priv->m_held->throttle.set_policy( mode, interval );
+}
+
+EmissionMode SignalBase::emission_mode() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_held->lock );
+    return m_priv->m_held->throttle.mode();
+}
+
 bool SignalBase::handle_dbus_outgoing( std::shared_ptr<const Message> msg ) {
     std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
 
     if( !conn || !conn->is_valid() ) { return false; }
 
-    conn << msg;
+    std::shared_ptr<HeldEmission> held = m_priv->m_held;
+    std::chrono::steady_clock::time_point flush_at;
+    priv::EmissionThrottle::Action action;
+
+    {
+        std::unique_lock<std::mutex> lock( held->lock );
+        action = held->throttle.emitted( std::chrono::steady_clock::now(), flush_at );
+
+        if( action != priv::EmissionThrottle::Action::Send ) {
+            held->message = msg;
+        }
+    }
+
+    if( action == priv::EmissionThrottle::Action::Send ) {
+        conn << msg;
+    } else if( action == priv::EmissionThrottle::Action::HoldAndSchedule ) {
+        std::weak_ptr<Connection> weak_conn = conn;
+        std::weak_ptr<HeldEmission> weak_held = held;
+
+        conn->call_at( flush_at, [weak_conn, weak_held]() {
+            std::shared_ptr<Connection> conn = weak_conn.lock();
+            std::shared_ptr<HeldEmission> held = weak_held.lock();
+            std::shared_ptr<const Message> msg;
+
+            if( !held ) { return; }
+
+            {
+                std::unique_lock<std::mutex> lock( held->lock );
+                held->throttle.flushed( std::chrono::steady_clock::now() );
+                msg.swap( held->message );
+            }
+
+            if( conn && conn->is_valid() && msg ) { conn << msg; }
+        } );
+    }
+
+    return true;
+}
+
+bool SignalBase::handle_dbus_outgoing( std::shared_ptr<const SignalMessage> msg, const std::vector<std::string>& destinations ) {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( !conn || !conn->is_valid() ) { return false; }
+
+    std::vector<std::shared_ptr<const Message>> copies;
+    copies.reserve( destinations.size() );
+
+    for( const std::string& destination : destinations ) {
+        std::shared_ptr<SignalMessage> copy = msg->copy_to( destination );
+
+        if( !copy ) {
+            SIMPLELOGGER_WARN( LOGGER_NAME, "Not sending " << name() << " to invalid destination " << destination );
+            continue;
+        }
+
+        copies.push_back( copy );
+    }
+
+    if( copies.empty() ) { return false; }
+
+    conn->send_batch( copies );
+
     return true;
 }
 
@@ -7,9 +7,12 @@
  ***************************************************************************/
 #include <dbus-cxx/path.h>
 #include <dbus-cxx/dbus-cxx-config.h>
+#include <dbus-cxx/enums.h>
 #include <stddef.h>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 #ifndef DBUSCXX_SIGNALBASE_H
 #define DBUSCXX_SIGNALBASE_H
@@ -17,6 +20,7 @@
 namespace DBus {
 class Connection;
 class Message;
+class SignalMessage;
 
 /**
  * @defgroup signals Signals
@@ -70,6 +74,22 @@ public:
 
     void set_destination( const std::string& s );
 
+    /**
+     * Set how often this signal actually goes out on the bus, for signals
+     * that are emitted faster than anybody needs them.  Emissions that are
+     * held back are sent from the dispatching thread of the connection.
+     *
+     * Local handlers connected to the signal are still called on every
+     * emission.
+     *
+     * @param mode How to hold back emissions
+     * @param interval The window for EmissionMode::Coalesce, or the shortest
+     * time between emissions for EmissionMode::RateLimit
+     */
+    void set_emission_policy( EmissionMode mode, std::chrono::milliseconds interval = std::chrono::milliseconds( 0 ) );
+
+    EmissionMode emission_mode() const;
+
     /**
      * This method is needed to be able to create a duplicate of a child
      * capable of parsing their specific template type message.
@@ -86,6 +106,22 @@ public:
 protected:
     bool handle_dbus_outgoing( std::shared_ptr<const Message> );
 
+    /**
+     * Send a copy of the signal to each of the destinations, all at once.
+     * The emission policy does not apply; the copies are always sent
+     * right away.
+     *
+     * @return False if nothing was sent, because there is no connection or
+     * none of the destinations are valid bus names
+     */
+    bool handle_dbus_outgoing( std::shared_ptr<const SignalMessage> msg, const std::vector<std::string>& destinations );
+
+private:
+    /**
+     * Let our connection know that what we match on has changed.
+     */
+    void routes_changed();
+
 private:
     class priv_data;
 
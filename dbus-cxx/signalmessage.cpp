@@ -10,24 +10,39 @@
 #include "message.h"
 #include "validator.h"
 
+#include <map>
+#include <mutex>
+
 namespace DBus {
 
+class SignalMessage::priv_data {
+public:
+    mutable std::mutex m_argumentsLock;
+    /* Decoded arguments, keyed by the type that they were decoded into */
+    mutable std::map<std::type_index, std::shared_ptr<const void>> m_arguments;
+};
+
 SignalMessage::SignalMessage( ):
-    Message() {
+    Message(),
+    m_priv( std::make_unique<priv_data>() ) {
 }
 
 SignalMessage::SignalMessage( const std::string& name ):
-    Message( ) {
+    Message( ),
+    m_priv( std::make_unique<priv_data>() ) {
     this->set_member( name );
 }
 
 SignalMessage::SignalMessage( const std::string& path, const std::string& interface_name, const std::string& name ) :
-    Message() {
+    Message(),
+    m_priv( std::make_unique<priv_data>() ) {
     set_path( path );
     set_interface( interface_name );
     set_member( name );
 }
 
+SignalMessage::~SignalMessage() {}
+
 std::shared_ptr<SignalMessage> SignalMessage::create( ) {
     return std::shared_ptr<SignalMessage>( new SignalMessage() );
 }
@@ -107,5 +122,34 @@ MessageType SignalMessage::type() const {
     return MessageType::SIGNAL;
 }
 
+std::shared_ptr<SignalMessage> SignalMessage::copy_to( const std::string& destination ) const {
+    std::shared_ptr<SignalMessage> copy = SignalMessage::create();
+
+    copy->copy_contents_from( *this );
+
+    if( !copy->set_destination( destination ) ) {
+        return std::shared_ptr<SignalMessage>();
+    }
+
+    return copy;
+}
+
+std::shared_ptr<const void> SignalMessage::cached_arguments( const std::type_index& key ) const {
+    std::scoped_lock lock( m_priv->m_argumentsLock );
+    std::map<std::type_index, std::shared_ptr<const void>>::const_iterator it =
+        m_priv->m_arguments.find( key );
+
+    if( it == m_priv->m_arguments.end() ) {
+        return std::shared_ptr<const void>();
+    }
+
+    return it->second;
+}
+
+std::shared_ptr<const void> SignalMessage::cache_arguments( const std::type_index& key, std::shared_ptr<const void> value ) const {
+    std::scoped_lock lock( m_priv->m_argumentsLock );
+
+    return m_priv->m_arguments.insert( std::make_pair( key, value ) ).first->second;
 }
 
+}
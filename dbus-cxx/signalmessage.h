@@ -8,6 +8,8 @@
 #include <dbus-cxx/message.h>
 #include <memory>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
 #include <vector>
 #include "enums.h"
 #include "path.h"
@@ -44,6 +46,8 @@ public:
 
     static std::shared_ptr<SignalMessage> create( const std::string& path, const std::string& interface_name, const std::string& name );
 
+    ~SignalMessage();
+
     bool set_path( const std::string& p );
 
     Path path() const;
@@ -66,6 +70,53 @@ public:
 
     virtual MessageType type() const;
 
+    /**
+     * Create a copy of this signal that goes to the given destination.  The
+     * arguments are copied as they were marshaled, so this is cheaper than
+     * building the signal again for each destination.
+     *
+     * @param destination The bus name to send the copy to
+     * @return The copy, or nullptr if the destination is not a valid bus name.
+     */
+    std::shared_ptr<SignalMessage> copy_to( const std::string& destination ) const;
+
+    /**
+     * Get the arguments of this signal decoded as a T.  The first call for
+     * a given T decodes them with the given function; later calls for the
+     * same T, from any thread, return that same decoded value.  This lets a
+     * signal that goes to many SignalProxy objects be decoded only once.
+     *
+     * Do not change the message after its arguments have been decoded.
+     *
+     * @param decode Called with the T to decode the arguments into.  If it
+     * throws, nothing is kept and the exception is passed on.
+     */
+    template <typename T, typename Decoder>
+    std::shared_ptr<const T> decoded_arguments( Decoder decode ) const {
+        std::type_index key( typeid( T ) );
+        std::shared_ptr<const void> found = cached_arguments( key );
+
+        if( found ) {
+            return std::static_pointer_cast<const T>( found );
+        }
+
+        std::shared_ptr<T> value = std::make_shared<T>();
+        decode( *value );
+
+        return std::static_pointer_cast<const T>( cache_arguments( key, value ) );
+    }
+
+private:
+    std::shared_ptr<const void> cached_arguments( const std::type_index& key ) const;
+
+    /* Returns the value that ends up in the cache, which is an earlier one
+     * if another thread got there first */
+    std::shared_ptr<const void> cache_arguments( const std::type_index& key, std::shared_ptr<const void> value ) const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
 };
 
 }
@@ -14,15 +14,18 @@ namespace DBus {
 
 class SignalProxyBase::priv_data {
 public:
-    priv_data() {}
+    priv_data( const SignalMatchRule& rule ) :
+        m_rule( rule ),
+        m_match_rule( rule.match_rule() )
+    {}
 
+    SignalMatchRule m_rule;
     std::string m_match_rule;
 };
 
 SignalProxyBase::SignalProxyBase( const SignalMatchRule& matchRule ):
     SignalBase( matchRule.path(), matchRule.dbus_interface(), matchRule.member() ),
-    m_priv( std::make_unique<priv_data>() ) {
-    m_priv->m_match_rule = matchRule.match_rule();
+    m_priv( std::make_unique<priv_data>( matchRule ) ) {
 }
 
 SignalProxyBase::~SignalProxyBase() {
@@ -51,16 +54,23 @@ bool SignalProxyBase::matches( std::shared_ptr<const SignalMessage> msg ) {
 
     if( !path().empty() && path() != msg->path() ) { return false; }
 
-    return true;
+    if( !m_priv->m_rule.matches_path_namespace( msg->path() ) ) { return false; }
+
+    return m_priv->m_rule.matches_arguments( msg );
 }
 
 void SignalProxyBase::update_match_rule(){
-    m_priv->m_match_rule = MatchRuleBuilder::create()
+    MatchRuleBuilder builder = MatchRuleBuilder::create( m_priv->m_rule );
+
+    // An exact path takes the place of a path namespace
+    if( !path().empty() ) { builder.set_path_namespace( "" ); }
+
+    m_priv->m_rule = builder
             .set_path( path() )
             .set_interface( interface_name() )
             .set_member( name() )
-            .as_signal_match()
-            .match_rule();
+            .as_signal_match();
+    m_priv->m_match_rule = m_priv->m_rule.match_rule();
 }
 
 }
@@ -5,13 +5,16 @@
  *                                                                         *
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
+#include <dbus-cxx/demarshaling.h>
 #include <dbus-cxx/signalbase.h>
 #include <dbus-cxx/signalmessage.h>
+#include <dbus-cxx/filedescriptor.h>
 #include <dbus-cxx/utility.h>
 #include <functional>
 #include <memory>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include "enums.h"
 #include "error.h"
 #include "headerlog.h"
@@ -86,23 +89,33 @@ public:
 
 protected:
     HandlerResult on_dbus_incoming( std::shared_ptr<const SignalMessage> msg ) {
-        std::tuple<T_arg...> tup_args;
-        std::ostringstream debug_str;
-        DBus::priv::dbus_function_traits<std::function<void( T_arg... )>> method_sig_gen;
-
-        debug_str << "DBus::signal_proxy<";
-        debug_str << method_sig_gen.debug_string();
-        debug_str << ">::on_dbus_incoming method=";
-        debug_str << msg->member();
-        DBUSCXX_DEBUG_STDSTR( "DBus.signal_proxy", debug_str.str() );
+        DBUSCXX_DEBUG_STDSTR( "DBus.signal_proxy", "DBus::signal_proxy<"
+            << DBus::priv::dbus_function_traits<std::function<void( T_arg... )>>().debug_string()
+            << ">::on_dbus_incoming method="
+            << msg->member() );
 
         try {
-            MessageIterator i = msg->begin();
-            std::apply( [i]( auto&& ...arg ) mutable {
-                ( void )( i >> ... >> arg );
-            },
-            tup_args );
-            std::apply( &SignalProxy::emit, std::tuple_cat( std::make_tuple( this ), tup_args ) );
+            if constexpr( scalar_arguments ) {
+                // Anything else goes through a MessageIterator, which can convert between types
+                if( msg->signature().str() == scalar_signature() ) {
+                    emit_arguments( decode_scalars( msg ) );
+                    return HandlerResult::Handled;
+                }
+            } else {
+                // Every handler needs its own duplicate of a file descriptor, wherever it is
+                if( msg->signature().str().find( DBUSCXX_TYPE_UNIX_FD_AS_STRING ) == std::string::npos ) {
+                    std::shared_ptr<const std::tuple<T_arg...>> tup_args =
+                        msg->template decoded_arguments<std::tuple<T_arg...>>( [&msg]( std::tuple<T_arg...>& args ) {
+                            decode_arguments( msg, args );
+                        } );
+                    emit_arguments( *tup_args );
+                    return HandlerResult::Handled;
+                }
+            }
+
+            std::tuple<T_arg...> tup_args;
+            decode_arguments( msg, tup_args );
+            emit_arguments( tup_args );
         } catch( ErrorInvalidTypecast& e ) {
             DBUSCXX_DEBUG_STDSTR( "DBus.signal_proxy", "Caught error invalid typecast" );
             return HandlerResult::Not_Handled;
@@ -114,6 +127,76 @@ protected:
         return HandlerResult::Handled;
     }
 
+private:
+    template <typename T>
+    static constexpr bool is_scalar =
+        std::is_same_v<T, bool> || std::is_same_v<T, uint8_t> ||
+        std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t> ||
+        std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+        std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> ||
+        std::is_same_v<T, double>;
+
+    /* Scalars are cheaper to decode again than to share, so every proxy
+     * decodes them for itself.  Other arguments are decoded once and shared
+     * between all of the proxies for a signal(as long as they carry no file
+     * descriptors) */
+    static constexpr bool scalar_arguments = ( is_scalar<T_arg> && ... );
+
+    static const std::string& scalar_signature() {
+        static const std::string sig = priv::dbus_signature<T_arg...>().dbus_sig();
+        return sig;
+    }
+
+    /**
+     * Decode scalar arguments straight out of the body, without the
+     * allocations that a MessageIterator needs.  Only call this if the
+     * message has exactly scalar_signature().
+     */
+    static std::tuple<T_arg...> decode_scalars( const std::shared_ptr<const SignalMessage>& msg ) {
+        const std::vector<uint8_t>* body = msg->body();
+        Demarshaling demarshal( body->data(), body->size(), msg->endianess() );
+
+        // The elements of a braced list are decoded in order
+        return std::tuple<T_arg...>{ decode_scalar<T_arg>( demarshal )... };
+    }
+
+    template <typename T>
+    static T decode_scalar( Demarshaling& demarshal ) {
+        if constexpr( std::is_same_v<T, bool> ) {
+            return demarshal.demarshal_boolean();
+        } else if constexpr( std::is_same_v<T, uint8_t> ) {
+            return demarshal.demarshal_uint8_t();
+        } else if constexpr( std::is_same_v<T, int16_t> ) {
+            return demarshal.demarshal_int16_t();
+        } else if constexpr( std::is_same_v<T, uint16_t> ) {
+            return demarshal.demarshal_uint16_t();
+        } else if constexpr( std::is_same_v<T, int32_t> ) {
+            return demarshal.demarshal_int32_t();
+        } else if constexpr( std::is_same_v<T, uint32_t> ) {
+            return demarshal.demarshal_uint32_t();
+        } else if constexpr( std::is_same_v<T, int64_t> ) {
+            return demarshal.demarshal_int64_t();
+        } else if constexpr( std::is_same_v<T, uint64_t> ) {
+            return demarshal.demarshal_uint64_t();
+        } else {
+            return demarshal.demarshal_double();
+        }
+    }
+
+    static void decode_arguments( const std::shared_ptr<const SignalMessage>& msg, std::tuple<T_arg...>& tup_args ) {
+        MessageIterator i = msg->begin();
+        std::apply( [&i]( auto&& ...arg ) {
+            ( void )( i >> ... >> arg );
+        },
+        tup_args );
+    }
+
+    void emit_arguments( const std::tuple<T_arg...>& tup_args ) {
+        std::apply( [this]( const auto& ...arg ) {
+            this->emit( arg... );
+        },
+        tup_args );
+    }
 };
 
 
@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "signalqueue.h"
+#include "signalmessage.h"
+
+#include "dbus-cxx-private.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using DBus::SignalQueue;
+
+static const char* LOGGER_NAME = "DBus.SignalQueue";
+
+struct QueuedSignal {
+    std::shared_ptr<const DBus::SignalMessage> message;
+    /* path, interface and member; only filled in when coalescing */
+    std::string key;
+};
+
+typedef std::list<QueuedSignal> SignalList;
+
+class SignalQueue::priv_data {
+public:
+    priv_data( size_t max_size, SignalOverflowPolicy policy ) :
+        m_maxSize( max_size ),
+        m_policy( policy ),
+        m_dropped( 0 )
+    {}
+
+    static std::string coalesce_key( const std::shared_ptr<const SignalMessage>& message ) {
+        std::string key = message->path();
+
+        key += '\0';
+        key += message->interface_name();
+        key += '\0';
+        key += message->member();
+
+        return key;
+    }
+
+    void remove_front() {
+        SignalList::iterator front = m_signals.begin();
+        std::unordered_map<std::string, SignalList::iterator>::iterator latest =
+            m_latest.find( front->key );
+
+        if( latest != m_latest.end() && latest->second == front ) {
+            m_latest.erase( latest );
+        }
+
+        m_signals.pop_front();
+    }
+
+    void drop_front() {
+        remove_front();
+        m_dropped++;
+    }
+
+    void drop_back() {
+        SignalList::iterator back = std::prev( m_signals.end() );
+        std::unordered_map<std::string, SignalList::iterator>::iterator latest =
+            m_latest.find( back->key );
+
+        if( latest != m_latest.end() && latest->second == back ) {
+            m_latest.erase( latest );
+        }
+
+        m_signals.pop_back();
+        m_dropped++;
+    }
+
+    /* Rebuild the coalescing keys after the policy has changed */
+    void rekey() {
+        m_latest.clear();
+
+        for( SignalList::iterator it = m_signals.begin(); it != m_signals.end(); it++ ) {
+            if( m_policy == SignalOverflowPolicy::Coalesce ) {
+                it->key = coalesce_key( it->message );
+                m_latest[ it->key ] = it;
+            } else {
+                it->key.clear();
+            }
+        }
+    }
+
+    mutable std::mutex m_lock;
+    size_t m_maxSize;
+    SignalOverflowPolicy m_policy;
+    uint64_t m_dropped;
+    SignalList m_signals;
+    /* The last queued signal for each key, when coalescing */
+    std::unordered_map<std::string, SignalList::iterator> m_latest;
+};
+
+SignalQueue::SignalQueue( size_t max_size, SignalOverflowPolicy policy ) :
+    m_priv( std::make_unique<priv_data>( max_size, policy ) ) {
+}
+
+SignalQueue::~SignalQueue() {}
+
+std::shared_ptr<SignalQueue> SignalQueue::create( size_t max_size, SignalOverflowPolicy policy ) {
+    return std::shared_ptr<SignalQueue>( new SignalQueue( max_size, policy ) );
+}
+
+void SignalQueue::set_limit( size_t max_size, SignalOverflowPolicy policy ) {
+    std::scoped_lock lock( m_priv->m_lock );
+    bool rekey = ( m_priv->m_policy == SignalOverflowPolicy::Coalesce ) !=
+        ( policy == SignalOverflowPolicy::Coalesce );
+
+    m_priv->m_maxSize = max_size;
+    m_priv->m_policy = policy;
+
+    if( rekey ) {
+        m_priv->rekey();
+    }
+
+    while( max_size && m_priv->m_signals.size() > max_size ) {
+        if( policy == SignalOverflowPolicy::DropNewest ) {
+            m_priv->drop_back();
+        } else {
+            m_priv->drop_front();
+        }
+    }
+}
+
+size_t SignalQueue::max_size() const {
+    std::scoped_lock lock( m_priv->m_lock );
+    return m_priv->m_maxSize;
+}
+
+DBus::SignalOverflowPolicy SignalQueue::overflow_policy() const {
+    std::scoped_lock lock( m_priv->m_lock );
+    return m_priv->m_policy;
+}
+
+bool SignalQueue::push( std::shared_ptr<const SignalMessage> message ) {
+    if( !message ) { return false; }
+
+    std::scoped_lock lock( m_priv->m_lock );
+    QueuedSignal queued;
+    bool full = m_priv->m_maxSize && m_priv->m_signals.size() >= m_priv->m_maxSize;
+
+    if( m_priv->m_policy == SignalOverflowPolicy::Coalesce ) {
+        queued.key = priv_data::coalesce_key( message );
+    }
+
+    if( full ) {
+        switch( m_priv->m_policy ) {
+        case SignalOverflowPolicy::DropNewest:
+            m_priv->m_dropped++;
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Queue full, dropping new signal " << message->member() );
+            return false;
+
+        case SignalOverflowPolicy::Coalesce: {
+            std::unordered_map<std::string, SignalList::iterator>::iterator latest =
+                m_priv->m_latest.find( queued.key );
+
+            if( latest != m_priv->m_latest.end() ) {
+                latest->second->message = message;
+                m_priv->m_dropped++;
+                return true;
+            }
+
+            m_priv->drop_front();
+            break;
+        }
+
+        case SignalOverflowPolicy::DropOldest:
+            m_priv->drop_front();
+            break;
+        }
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Queue full, dropped oldest signal" );
+    }
+
+    m_priv->m_signals.push_back( std::move( queued ) );
+    m_priv->m_signals.back().message = message;
+
+    if( m_priv->m_policy == SignalOverflowPolicy::Coalesce ) {
+        m_priv->m_latest[ m_priv->m_signals.back().key ] = std::prev( m_priv->m_signals.end() );
+    }
+
+    return true;
+}
+
+std::shared_ptr<const DBus::SignalMessage> SignalQueue::pop() {
+    std::scoped_lock lock( m_priv->m_lock );
+
+    if( m_priv->m_signals.empty() ) {
+        return std::shared_ptr<const SignalMessage>();
+    }
+
+    std::shared_ptr<const SignalMessage> message = m_priv->m_signals.front().message;
+
+    m_priv->remove_front();
+
+    return message;
+}
+
+size_t SignalQueue::size() const {
+    std::scoped_lock lock( m_priv->m_lock );
+    return m_priv->m_signals.size();
+}
+
+bool SignalQueue::empty() const {
+    std::scoped_lock lock( m_priv->m_lock );
+    return m_priv->m_signals.empty();
+}
+
+uint64_t SignalQueue::dropped() const {
+    std::scoped_lock lock( m_priv->m_lock );
+    return m_priv->m_dropped;
+}
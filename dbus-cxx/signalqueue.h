@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_SIGNALQUEUE_H
+#define DBUSCXX_SIGNALQUEUE_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <dbus-cxx/enums.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace DBus {
+
+class SignalMessage;
+
+/**
+ * A thread-safe queue of signals, for a ThreadDispatcher to hold signals in
+ * until its thread gets around to emitting them.
+ *
+ * By default the queue can grow without limit.  If the queue is given a
+ * maximum size, signals that come in once it is full are dealt with
+ * according to its SignalOverflowPolicy, so that a thread that stops
+ * running its main loop can't use up all of the memory.  Every signal that
+ * is thrown away, or replaced by a newer one, is counted in dropped().
+ */
+class SignalQueue {
+private:
+    SignalQueue( size_t max_size, SignalOverflowPolicy policy );
+
+public:
+    /**
+     * Create a new queue.
+     *
+     * @param max_size The most signals that the queue holds at once, or 0
+     * for no limit.
+     * @param policy What to do with signals that come in when the queue is full.
+     */
+    static std::shared_ptr<SignalQueue> create( size_t max_size = 0,
+        SignalOverflowPolicy policy = SignalOverflowPolicy::DropOldest );
+
+    ~SignalQueue();
+
+    /**
+     * Change the size of the queue and what happens when it is full.  If the
+     * queue holds more signals than the new size allows, the extra signals
+     * are thrown away according to the new policy.
+     *
+     * @param max_size The most signals that the queue holds at once, or 0
+     * for no limit.
+     * @param policy What to do with signals that come in when the queue is full.
+     */
+    void set_limit( size_t max_size, SignalOverflowPolicy policy );
+
+    size_t max_size() const;
+
+    SignalOverflowPolicy overflow_policy() const;
+
+    /**
+     * Add a signal to the back of the queue.
+     *
+     * @return False if the queue was full and the signal was thrown away,
+     * true if it is now in the queue.
+     */
+    bool push( std::shared_ptr<const SignalMessage> message );
+
+    /**
+     * Take the signal at the front of the queue.
+     *
+     * @return The signal, or nullptr if the queue is empty.
+     */
+    std::shared_ptr<const SignalMessage> pop();
+
+    size_t size() const;
+
+    bool empty() const;
+
+    /**
+     * The number of signals that have been thrown away or replaced because
+     * the queue was full.
+     */
+    uint64_t dropped() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_SIGNALQUEUE_H */
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "signalroutingtable.h"
+#include "signalproxy.h"
+
+#include <algorithm>
+
+using DBus::priv::SignalRoutingTable;
+
+static const std::string MATCH_ANY;
+
+SignalRoutingTable::SignalRoutingTable() :
+    m_nextSequence( 0 ),
+    m_size( 0 ) {
+}
+
+void SignalRoutingTable::add( std::shared_ptr<SignalProxyBase> proxy, std::thread::id thread ) {
+    Entry entry;
+
+    if( !proxy ) { return; }
+
+    // A proxy that has gone away may have left its address behind for this one
+    if( take( proxy.get(), &entry ) && entry.proxy.lock() == proxy ) {
+        entry.thread = thread;
+    } else {
+        entry = Entry{ m_nextSequence++, proxy, thread, nullptr };
+    }
+
+    file( proxy, entry );
+}
+
+bool SignalRoutingTable::remove( std::shared_ptr<SignalProxyBase> proxy ) {
+    Entry entry;
+
+    if( !proxy ) { return false; }
+
+    return take( proxy.get(), &entry );
+}
+
+void SignalRoutingTable::update( const SignalBase* signal ) {
+    Entry entry;
+
+    if( !take( signal, &entry ) ) { return; }
+
+    std::shared_ptr<SignalProxyBase> proxy = entry.proxy.lock();
+
+    if( proxy ) { file( proxy, entry ); }
+}
+
+void SignalRoutingTable::clear() {
+    m_routes.clear();
+    m_locations.clear();
+    m_nextSequence = 0;
+    m_size = 0;
+}
+
+bool SignalRoutingTable::take( const SignalBase* signal, Entry* taken ) {
+    std::unordered_map<const SignalBase*, Location>::iterator location = m_locations.find( signal );
+
+    if( location == m_locations.end() ) { return false; }
+
+    InterfaceMap::iterator members = m_routes.find( location->second.interface_name );
+    MemberMap::iterator paths = members->second.find( location->second.member );
+    PathMap::iterator entries = paths->second.find( location->second.path );
+    Entries::iterator entry = std::find_if( entries->second.begin(), entries->second.end(),
+        [signal]( const Entry& e ) {
+            return e.signal == signal;
+        } );
+
+    *taken = *entry;
+    entries->second.erase( entry );
+
+    // Don't leave empty buckets behind for find() to look through
+    if( entries->second.empty() ) { paths->second.erase( entries ); }
+    if( paths->second.empty() ) { members->second.erase( paths ); }
+    if( members->second.empty() ) { m_routes.erase( members ); }
+
+    m_locations.erase( location );
+    m_size--;
+
+    return true;
+}
+
+void SignalRoutingTable::file( const std::shared_ptr<SignalProxyBase>& proxy, Entry entry ) {
+    const SignalBase* signal = proxy.get();
+
+    entry.signal = signal;
+    m_routes[ proxy->interface_name() ][ proxy->name() ][ proxy->path() ].push_back( entry );
+    m_locations[ signal ] = Location{ proxy->interface_name(), proxy->name(), proxy->path() };
+    m_size++;
+}
+
+void SignalRoutingTable::find( const std::string& interface_name,
+    const std::string& member,
+    const std::string& path,
+    std::vector<Route>& found ) const {
+    InterfaceMap::const_iterator it;
+
+    m_found.clear();
+
+    it = m_routes.find( interface_name );
+
+    if( it != m_routes.end() ) {
+        find_in_member( it->second, member, path, m_found );
+    }
+
+    if( !interface_name.empty() ) {
+        it = m_routes.find( MATCH_ANY );
+
+        if( it != m_routes.end() ) {
+            find_in_member( it->second, member, path, m_found );
+        }
+    }
+
+    // The proxies came out of different buckets; put them back in the order they were added
+    std::sort( m_found.begin(), m_found.end(),
+        []( const Entry& a, const Entry& b ) {
+            return a.sequence < b.sequence;
+        } );
+
+    for( Entry& entry : m_found ) {
+        std::shared_ptr<SignalProxyBase> proxy = entry.proxy.lock();
+
+        if( proxy ) {
+            found.push_back( Route{ proxy, entry.thread } );
+        }
+    }
+
+    m_found.clear();
+}
+
+size_t SignalRoutingTable::size() const {
+    return m_size;
+}
+
+void SignalRoutingTable::find_in_member( const MemberMap& members,
+    const std::string& member,
+    const std::string& path,
+    Entries& found ) const {
+    MemberMap::const_iterator it = members.find( member );
+
+    if( it != members.end() ) {
+        find_in_path( it->second, path, found );
+    }
+
+    if( !member.empty() ) {
+        it = members.find( MATCH_ANY );
+
+        if( it != members.end() ) {
+            find_in_path( it->second, path, found );
+        }
+    }
+}
+
+void SignalRoutingTable::find_in_path( const PathMap& paths,
+    const std::string& path,
+    Entries& found ) const {
+    PathMap::const_iterator it = paths.find( path );
+
+    if( it != paths.end() ) {
+        found.insert( found.end(), it->second.begin(), it->second.end() );
+    }
+
+    if( !path.empty() ) {
+        it = paths.find( MATCH_ANY );
+
+        if( it != paths.end() ) {
+            found.insert( found.end(), it->second.begin(), it->second.end() );
+        }
+    }
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_SIGNALROUTINGTABLE_H
+#define DBUSCXX_SIGNALROUTINGTABLE_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DBus {
+
+class SignalBase;
+class SignalProxyBase;
+
+namespace priv {
+
+/**
+ * An index of signal proxies, so that an incoming signal only has to be
+ * looked at by the proxies that may want it.
+ *
+ * Proxies are indexed by interface and member, and then by path.  An empty
+ * interface, member or path on a proxy matches anything, so those proxies
+ * are found under the empty string.  Anything else that the proxy looks at
+ * (such as the sender) is left for the proxy to check.
+ *
+ * This class is not thread-safe.
+ */
+class SignalRoutingTable {
+public:
+    /**
+     * Where a signal needs to go: the proxy that may want it, and the
+     * thread that the proxy handles signals on.
+     */
+    struct Route {
+        std::shared_ptr<SignalProxyBase> proxy;
+        std::thread::id thread;
+    };
+
+    SignalRoutingTable();
+
+    /**
+     * Add a proxy to the table.  Proxies are found in the order that they
+     * were added.  If the proxy is in the table already, it is only
+     * given the new thread.
+     *
+     * @param proxy The proxy
+     * @param thread The thread that the proxy handles signals on
+     */
+    void add( std::shared_ptr<SignalProxyBase> proxy, std::thread::id thread );
+
+    /**
+     * Take a proxy out of the table.
+     *
+     * @param proxy The proxy
+     * @return True if the proxy was in the table
+     */
+    bool remove( std::shared_ptr<SignalProxyBase> proxy );
+
+    /**
+     * File a proxy under the interface, member and path that it has now,
+     * if it is in the table.  It keeps its place in the order.
+     *
+     * @param signal The proxy that has changed
+     */
+    void update( const SignalBase* signal );
+
+    /**
+     * Remove every proxy from the table.
+     */
+    void clear();
+
+    /**
+     * Find the proxies that may want a signal.
+     *
+     * @param interface_name The interface of the signal
+     * @param member The member of the signal
+     * @param path The path of the signal
+     * @param found The routes are added to this, in the order that they were added to the table
+     */
+    void find( const std::string& interface_name,
+               const std::string& member,
+               const std::string& path,
+               std::vector<Route>& found ) const;
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        uint64_t sequence;
+        std::weak_ptr<SignalProxyBase> proxy;
+        std::thread::id thread;
+        /* What the proxy is filed under in m_locations */
+        const SignalBase* signal;
+    };
+
+    /* Where a proxy was filed, so that it can be found again once it changes */
+    struct Location {
+        std::string interface_name;
+        std::string member;
+        std::string path;
+    };
+
+    typedef std::vector<Entry> Entries;
+    typedef std::unordered_map<std::string, Entries> PathMap;
+    typedef std::unordered_map<std::string, PathMap> MemberMap;
+    typedef std::unordered_map<std::string, MemberMap> InterfaceMap;
+
+    /** Take the proxy out of its bucket, giving back its entry */
+    bool take( const SignalBase* signal, Entry* taken );
+
+    /** File an entry for the proxy under where it is now */
+    void file( const std::shared_ptr<SignalProxyBase>& proxy, Entry entry );
+
+    void find_in_member( const MemberMap& members,
+                         const std::string& member,
+                         const std::string& path,
+                         Entries& found ) const;
+
+    void find_in_path( const PathMap& paths,
+                       const std::string& path,
+                       Entries& found ) const;
+
+private:
+    InterfaceMap m_routes;
+    std::unordered_map<const SignalBase*, Location> m_locations;
+    uint64_t m_nextSequence;
+    size_t m_size;
+    /* Reused by find(), so that lookups don't allocate once it has grown */
+    mutable Entries m_found;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_SIGNALROUTINGTABLE_H */
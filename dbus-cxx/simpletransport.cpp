@@ -7,21 +7,31 @@
  ***************************************************************************/
 #include "simpletransport.h"
 
+#include "bufferpool.h"
 #include "dbus-cxx-private.h"
 #include "demarshaling.h"
 #include "message.h"
 #include "utility.h"
 #include "validator.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 
 using DBus::priv::SimpleTransport;
 
 static const char* LOGGER_NAME = "DBus.SimpleTransport";
 
+/*
+ * Size of the buffers that we keep for ourselves.  Anything larger is borrowed
+ * from the BufferPool only for as long as we need it.
+ */
+#define RECEIVE_BUFFER_SIZE 512
+#define SEND_BUFFER_SIZE    2048
+
 enum class ReadingState {
     FirstHeaderPart,
     SecondHeaderPart,
@@ -34,21 +44,89 @@ public:
         m_fd( fd ),
         m_ok( false ),
         m_readingState( ReadingState::FirstHeaderPart ),
-        m_receiveBuffer( nullptr ),
         m_receiveBufferLocation( 0 ),
-        m_receiveBufferSize( 512 ),
         m_headerLeftToRead( 0 )
     {}
 
+    /**
+     * Make sure that the receive buffer can hold at least size bytes,
+     * keeping the data that we have already read.
+     */
+    void grow_receive_buffer( uint32_t size ) {
+        if( m_receiveBuffer.capacity() < size ) {
+            std::vector<uint8_t> newbuffer = BufferPool::instance().acquire( size );
+            newbuffer.resize( m_receiveBufferLocation );
+            std::memcpy( newbuffer.data(), m_receiveBuffer.data(), m_receiveBufferLocation );
+            BufferPool::instance().release( std::move( m_receiveBuffer ) );
+            m_receiveBuffer = std::move( newbuffer );
+        }
+
+        m_receiveBuffer.resize( size );
+    }
+
+    /**
+     * Note that a message of the given size was read, so that a large
+     * receive buffer is not given back while we still need it.
+     */
+    void note_receive( uint32_t messageSize ) {
+        if( messageSize > RECEIVE_BUFFER_SIZE ) {
+            m_lastLargeReceive = std::chrono::steady_clock::now();
+        }
+    }
+
+    /**
+     * Note that the message in the send buffer went out, so that a large
+     * send buffer is not given back while we still need it.
+     */
+    void note_send() {
+        if( m_sendBuffer.size() > SEND_BUFFER_SIZE ) {
+            m_lastLargeSend = std::chrono::steady_clock::now();
+        }
+
+        m_sendBuffer.clear();
+    }
+
+    std::chrono::steady_clock::time_point release_idle_buffers() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+        std::chrono::milliseconds idleTimeout = BufferPool::instance().idle_timeout();
+
+        if( m_receiveBuffer.capacity() > RECEIVE_BUFFER_SIZE ) {
+            if( m_receiveBufferLocation != 0 ) {
+                // In the middle of a message; try again later
+                next = now + idleTimeout;
+            } else if( now - m_lastLargeReceive < idleTimeout ) {
+                next = m_lastLargeReceive + idleTimeout;
+            } else {
+                BufferPool::instance().release( std::move( m_receiveBuffer ) );
+                m_receiveBuffer = BufferPool::instance().acquire( RECEIVE_BUFFER_SIZE );
+                m_receiveBuffer.resize( RECEIVE_BUFFER_SIZE );
+            }
+        }
+
+        if( m_sendBuffer.capacity() > SEND_BUFFER_SIZE ) {
+            if( now - m_lastLargeSend < idleTimeout ) {
+                next = std::min( next, m_lastLargeSend + idleTimeout );
+            } else {
+                BufferPool::instance().release( std::move( m_sendBuffer ) );
+                m_sendBuffer = BufferPool::instance().acquire( SEND_BUFFER_SIZE );
+            }
+        }
+
+        return next;
+    }
+
     int m_fd;
     bool m_ok;
     ReadingState m_readingState;
     std::vector<uint8_t> m_sendBuffer;
-    uint8_t* m_receiveBuffer;
+    std::vector<uint8_t> m_receiveBuffer;
     uint32_t m_receiveBufferLocation;
-    uint32_t m_receiveBufferSize;
     uint32_t m_bodyLeftToRead;
     uint32_t m_headerLeftToRead;
+    /* When we last needed the big buffers */
+    std::chrono::steady_clock::time_point m_lastLargeReceive;
+    std::chrono::steady_clock::time_point m_lastLargeSend;
 };
 
 SimpleTransport::SimpleTransport( int fd, bool initialize ) :
@@ -56,7 +134,7 @@ SimpleTransport::SimpleTransport( int fd, bool initialize ) :
     uint8_t nulbyte = 0;
 
     if( initialize ) {
-        if( ::write( m_priv->m_fd, &nulbyte, 1 ) < 0 ) {
+        if( ::send( m_priv->m_fd, &nulbyte, 1, MSG_NOSIGNAL ) < 0 ) {
             int my_errno = errno;
             std::string errmsg = strerror( errno );
             SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to write nul byte: " + errmsg );
@@ -67,13 +145,17 @@ SimpleTransport::SimpleTransport( int fd, bool initialize ) :
         }
     }
 
-    m_priv->m_receiveBuffer = new uint8_t[ m_priv->m_receiveBufferSize ];
+    m_priv->m_receiveBuffer = BufferPool::instance().acquire( RECEIVE_BUFFER_SIZE );
+    m_priv->m_receiveBuffer.resize( RECEIVE_BUFFER_SIZE );
+    m_priv->m_sendBuffer = BufferPool::instance().acquire( SEND_BUFFER_SIZE );
+    m_priv->m_sendBuffer.clear();
     m_priv->m_ok = true;
 }
 
 SimpleTransport::~SimpleTransport() {
     close( m_priv->m_fd );
-    delete[] m_priv->m_receiveBuffer;
+    BufferPool::instance().release( std::move( m_priv->m_receiveBuffer ) );
+    BufferPool::instance().release( std::move( m_priv->m_sendBuffer ) );
 }
 
 
@@ -93,7 +175,8 @@ ssize_t SimpleTransport::writeMessage( std::shared_ptr<const Message> message, u
     DBus::hexdump( &m_priv->m_sendBuffer, &debug_str );
     SIMPLELOGGER_TRACE( LOGGER_NAME, debug_str.str() );
 
-    ssize_t bytesWritten = ::write( m_priv->m_fd, m_priv->m_sendBuffer.data(), m_priv->m_sendBuffer.size() );
+    // A TCP peer may go away at any time; that should be an error, not a SIGPIPE
+    ssize_t bytesWritten = ::send( m_priv->m_fd, m_priv->m_sendBuffer.data(), m_priv->m_sendBuffer.size(), MSG_NOSIGNAL );
 
     if( bytesWritten < 0 ) {
         int my_errno = errno;
@@ -102,6 +185,8 @@ ssize_t SimpleTransport::writeMessage( std::shared_ptr<const Message> message, u
         errno = my_errno;
     }
 
+    m_priv->note_send();
+
     return bytesWritten;
 }
 
@@ -115,7 +200,7 @@ std::shared_ptr<DBus::Message> SimpleTransport::readMessage() {
          * important data(including the size of the variable-length array)
          */
         bytesRead = ::read( m_priv->m_fd,
-                m_priv->m_receiveBuffer + m_priv->m_receiveBufferLocation,
+                m_priv->m_receiveBuffer.data() + m_priv->m_receiveBufferLocation,
                 16 - m_priv->m_receiveBufferLocation );
 
         if( bytesRead < 0 ) {
@@ -141,7 +226,7 @@ std::shared_ptr<DBus::Message> SimpleTransport::readMessage() {
          * Next part of the reading: read the variable-sized array in the header
          */
         if( m_priv->m_headerLeftToRead == 0 ) {
-            Demarshaling m( m_priv->m_receiveBuffer, 16, Endianess::Big );
+            Demarshaling m( m_priv->m_receiveBuffer.data(), 16, Endianess::Big );
             uint32_t totalMessageSize;
             uint32_t headerArraySize;
             int bytesToAdd;
@@ -183,12 +268,8 @@ std::shared_ptr<DBus::Message> SimpleTransport::readMessage() {
                     + m_priv->m_bodyLeftToRead
                     + 12 /* Extra padding */ );
 
-            if( m_priv->m_receiveBufferSize < totalMessageSize ) {
-                m_priv->m_receiveBufferSize = totalMessageSize;
-                uint8_t* newbuffer = new uint8_t[ m_priv->m_receiveBufferSize ];
-                std::memcpy( newbuffer, m_priv->m_receiveBuffer, m_priv->m_receiveBufferLocation );
-                delete[] m_priv->m_receiveBuffer;
-                m_priv->m_receiveBuffer = newbuffer;
+            if( m_priv->m_receiveBuffer.size() < totalMessageSize ) {
+                m_priv->grow_receive_buffer( totalMessageSize );
             }
         }
 
@@ -197,7 +278,7 @@ std::shared_ptr<DBus::Message> SimpleTransport::readMessage() {
          * try to read that number of bytes(to keep the number of read() calls down)
          */
         bytesRead = ::read( m_priv->m_fd,
-                m_priv->m_receiveBuffer + m_priv->m_receiveBufferLocation,
+                m_priv->m_receiveBuffer.data() + m_priv->m_receiveBufferLocation,
                 m_priv->m_headerLeftToRead + m_priv->m_bodyLeftToRead );
 
         if( bytesRead < 0 ) {
@@ -222,7 +303,7 @@ std::shared_ptr<DBus::Message> SimpleTransport::readMessage() {
     if( m_priv->m_readingState == ReadingState::Body ) {
         if( m_priv->m_bodyLeftToRead ) {
             bytesRead = ::read( m_priv->m_fd,
-                    m_priv->m_receiveBuffer + m_priv->m_receiveBufferLocation,
+                    m_priv->m_receiveBuffer.data() + m_priv->m_receiveBufferLocation,
                     m_priv->m_bodyLeftToRead );
 
             if( bytesRead < 0 ) {
@@ -236,11 +317,12 @@ std::shared_ptr<DBus::Message> SimpleTransport::readMessage() {
             // We have a full message at this point!
             std::ostringstream debug_str;
             debug_str << "Going to create a message from the following data: " << std::endl;
-            DBus::hexdump( m_priv->m_receiveBuffer, m_priv->m_receiveBufferLocation, &debug_str );
+            DBus::hexdump( m_priv->m_receiveBuffer.data(), m_priv->m_receiveBufferLocation, &debug_str );
             SIMPLELOGGER_TRACE( LOGGER_NAME, debug_str.str() );
 
-            retmsg = Message::create_from_data( m_priv->m_receiveBuffer, m_priv->m_receiveBufferLocation );
+            retmsg = Message::create_from_data( m_priv->m_receiveBuffer.data(), m_priv->m_receiveBufferLocation );
 
+            m_priv->note_receive( m_priv->m_receiveBufferLocation );
             m_priv->m_receiveBufferLocation = 0;
             m_priv->m_readingState = ReadingState::FirstHeaderPart;
             m_priv->m_headerLeftToRead = 0;
@@ -258,6 +340,15 @@ int SimpleTransport::fd() const {
     return m_priv->m_fd;
 }
 
+bool SimpleTransport::has_borrowed_buffers() const {
+    return m_priv->m_receiveBuffer.capacity() > RECEIVE_BUFFER_SIZE ||
+        m_priv->m_sendBuffer.capacity() > SEND_BUFFER_SIZE;
+}
+
+std::chrono::steady_clock::time_point SimpleTransport::release_idle_buffers() {
+    return m_priv->release_idle_buffers();
+}
+
 void SimpleTransport::purgeData(){
     uint8_t purgeBuffer[ 1024 ];
     ssize_t bytes_read;
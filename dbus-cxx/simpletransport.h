@@ -53,6 +53,10 @@ public:
 
     int fd() const;
 
+    bool has_borrowed_buffers() const;
+
+    std::chrono::steady_clock::time_point release_idle_buffers();
+
 private:
     void purgeData();
 
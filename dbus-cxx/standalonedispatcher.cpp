@@ -7,6 +7,7 @@
  ***************************************************************************/
 #include <dbus-cxx/connection.h>
 #include <dbus-cxx/dbus-cxx-private.h>
+#include <atomic>
 #include <thread>
 #include <mutex>
 #include <vector>
@@ -14,12 +15,26 @@
 #include <errno.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <algorithm>
 #include <deque>
+#include <unordered_map>
 #include <utility>
 #include <string.h>
 
 #include "standalonedispatcher.h"
 
+#if defined( DBUS_CXX_HAS_EPOLL ) && defined( DBUS_CXX_HAS_EVENTFD )
+    #define USE_EPOLL
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/ioctl.h>
+#endif
+
+#ifdef DBUS_CXX_HAS_PTHREAD_SETAFFINITY_NP
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
 #if defined( _WIN32 ) && defined( connect )
     #undef connect
 #endif
@@ -28,37 +43,195 @@ using DBus::StandaloneDispatcher;
 
 static const char* LOGGER_NAME = "DBus.StandaloneDispatcher";
 
+/* Default number of messages to process on one connection per loop */
+#define DEFAULT_DISPATCH_MESSAGE_LIMIT 1024
+
+#ifdef USE_EPOLL
+/* The most events that we take from the kernel at once */
+#define MAX_EPOLL_EVENTS 64
+
+/**
+ * A connection, along with what the dispatch thread knows about it.
+ * The dispatch thread lets go of these once the connection is gone.  epoll
+ * only knows the ID, so an event for a removed connection finds nothing;
+ * a wakeup that races with the removal holds on to an entry with no
+ * connection, which is skipped.
+ */
+struct DispatchedConnection {
+    std::shared_ptr<DBus::Connection> connection;
+    /* What epoll knows us as; never 0, that is the wakeup eventfd */
+    uint64_t id;
+    /* Our slot on the connection's signal_needs_dispatch() */
+    sigc::connection wakeSlot;
+    /* True if this is in the list of connections to dispatch on this loop */
+    bool queued;
+    /* True if another thread asked for this to be dispatched.  Guarded by m_wokenLock */
+    bool woken;
+};
+#endif
+
 class StandaloneDispatcher::priv_data {
 public:
     priv_data() :
         m_running( false ),
-        m_dispatch_loop_limit( 0 ) {
+        m_cpu( -1 ),
+#ifdef USE_EPOLL
+        m_nextId( 1 ),
+#endif
+        m_dispatch_loop_limit( DEFAULT_DISPATCH_MESSAGE_LIMIT ),
+        m_dispatch_time_limit_us( 0 ) {
+
+    }
+
+#ifdef USE_EPOLL
+    /**
+     * Start watching the connection's fd for the given events, or change
+     * the events that we are watching for.
+     */
+    void watch( DispatchedConnection* entry, uint32_t events ) {
+        int fd = entry->connection->unix_fd();
+        struct epoll_event event;
 
+        if( fd < 0 ) { return; }
+
+        memset( &event, 0, sizeof( event ) );
+        event.events = events | EPOLLET;
+        event.data.u64 = entry->id;
+
+        // A connection that is still connecting may have moved on to a new socket
+        if( epoll_ctl( m_epollFd, EPOLL_CTL_MOD, fd, &event ) < 0 &&
+            ( errno != ENOENT || epoll_ctl( m_epollFd, EPOLL_CTL_ADD, fd, &event ) < 0 ) ) {
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to watch fd " << fd << ": " << strerror( errno ) );
+        }
     }
 
+    /** Dispatch this connection on this loop of the dispatch thread */
+    void queue( DispatchedConnection* entry ) {
+        if( entry->queued ) { return; }
+
+        entry->queued = true;
+        m_ready.push_back( entry );
+    }
+
+    /** Called from any thread when a connection has something for us to do */
+    void wake( std::shared_ptr<DispatchedConnection> entry ) {
+        {
+            std::unique_lock<std::mutex> lock( m_wokenLock );
+
+            // The dispatch thread has already been woken up for this one
+            if( entry->woken ) { return; }
+
+            entry->woken = true;
+            m_woken.push_back( entry );
+        }
+
+        wakeup();
+    }
+
+    /**
+     * How long we can sleep for before a call on one of our connections
+     * times out, or -1 if we can sleep forever.  Connections whose calls
+     * have already timed out are queued up to be dispatched.
+     */
+    int queue_timed_out() {
+        int timeout = -1;
+
+        for( DispatchedConnection* entry : m_known ) {
+            int conn_timeout = entry->connection->next_timeout_milliseconds();
+
+            if( conn_timeout == 0 ) {
+                queue( entry );
+            } else if( conn_timeout > 0 && ( timeout < 0 || conn_timeout < timeout ) ) {
+                timeout = conn_timeout;
+            }
+        }
+
+        return timeout;
+    }
+
+    void wakeup() {
+        uint64_t to_write = 1;
+
+        if( write( m_wakeupFd, &to_write, sizeof( to_write ) ) < 0 ) {
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Can't write to eventfd?!" );
+        }
+    }
+#endif
+
+    /* Connections may be added from any thread */
+    std::mutex m_connectionsLock;
     std::vector<std::shared_ptr<Connection>> m_connections;
     volatile bool m_running;
     std::thread m_dispatch_thread;
+    /* The CPU that the dispatch thread is pinned to, or -1 */
+    std::atomic<int> m_cpu;
+    sigc::signal<void(std::shared_ptr<Connection>)> m_connectionRemoved;
+#ifdef USE_EPOLL
+    int m_epollFd;
+    /* eventfd for telling the thread to process data */
+    int m_wakeupFd;
+    /* Every connection that we have; guarded by m_connectionsLock */
+    std::vector<std::shared_ptr<DispatchedConnection>> m_dispatched;
+    /* The ID to give to the next connection; guarded by m_connectionsLock */
+    uint64_t m_nextId;
+    /* Connections that the dispatch thread has not seen yet; guarded by m_connectionsLock */
+    std::vector<DispatchedConnection*> m_newConnections;
+    std::mutex m_wokenLock;
+    std::vector<std::shared_ptr<DispatchedConnection>> m_woken;
+    /* Connections that are still connecting.  Only used from the dispatch thread */
+    std::vector<DispatchedConnection*> m_connecting;
+    /* Connections to dispatch on this loop.  Only used from the dispatch thread */
+    std::vector<DispatchedConnection*> m_ready;
+    /* Every connection that the dispatch thread has seen.  Only used from the dispatch thread */
+    std::vector<DispatchedConnection*> m_known;
+    /* The same connections, by the ID that epoll gives us.  Only used from the dispatch thread */
+    std::unordered_map<uint64_t, DispatchedConnection*> m_byId;
+#else
     /* socketpair for telling the thread to process data */
     int process_fd[ 2 ];
+#endif
     /**
-     * This is the maximum number of dispatches that will occur for a
+     * This is the maximum number of messages that will be processed for a
      * connection in one iteration of the dispatch thread.
      *
      * If set to 0, a particular connection will continue to dispatch
-     * as long as its status remains DISPATCH_DATA_REMAINS.
+     * until there is nothing left to read.
      */
-    unsigned int m_dispatch_loop_limit;
+    std::atomic<uint32_t> m_dispatch_loop_limit;
+    /* The most time to spend on one connection per iteration, 0 for no limit */
+    std::atomic<int64_t> m_dispatch_time_limit_us;
 
 };
 
 StandaloneDispatcher::StandaloneDispatcher( bool is_running ) {
     m_priv = std::make_unique<priv_data>();
 
+#ifdef USE_EPOLL
+    struct epoll_event event;
+
+    m_priv->m_epollFd = epoll_create1( EPOLL_CLOEXEC );
+    m_priv->m_wakeupFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    memset( &event, 0, sizeof( event ) );
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+
+    if( m_priv->m_epollFd < 0 ||
+        m_priv->m_wakeupFd < 0 ||
+        epoll_ctl( m_priv->m_epollFd, EPOLL_CTL_ADD, m_priv->m_wakeupFd, &event ) < 0 ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "error creating epoll instance: " << strerror( errno ) );
+
+        if( m_priv->m_epollFd >= 0 ) { close( m_priv->m_epollFd ); }
+        if( m_priv->m_wakeupFd >= 0 ) { close( m_priv->m_wakeupFd ); }
+
+        throw ErrorDispatcherInitFailed();
+    }
+#else
     if( socketpair( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, m_priv->process_fd ) < 0 ) {
         SIMPLELOGGER_ERROR( LOGGER_NAME, "error creating socket pair" );
         throw ErrorDispatcherInitFailed();
     }
+#endif
 
     if( is_running ) { this->start(); }
 }
@@ -69,6 +242,14 @@ std::shared_ptr<StandaloneDispatcher> StandaloneDispatcher::create( bool is_runn
 
 StandaloneDispatcher::~StandaloneDispatcher() {
     this->stop();
+
+#ifdef USE_EPOLL
+    close( m_priv->m_epollFd );
+    close( m_priv->m_wakeupFd );
+#else
+    close( m_priv->process_fd[ 0 ] );
+    close( m_priv->process_fd[ 1 ] );
+#endif
 }
 
 std::shared_ptr<DBus::Connection> StandaloneDispatcher::create_connection( std::string address ) {
@@ -90,11 +271,47 @@ std::shared_ptr<DBus::Connection> StandaloneDispatcher::create_connection( BusTy
 }
 
 bool StandaloneDispatcher::add_connection( std::shared_ptr<Connection> connection ) {
-    if( !connection || !connection->is_valid() ) { return false; }
+    if( !connection ) { return false; }
+
+    // Asynchronous connections are driven along by our dispatch thread
+    if( !connection->is_valid() && !connection->is_connecting() ) { return false; }
 
     connection->set_dispatching_thread( m_priv->m_dispatch_thread.get_id() );
+
+#ifdef USE_EPOLL
+    DispatchedConnection* entry;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_connectionsLock );
+        m_priv->m_connections.push_back( connection );
+        m_priv->m_dispatched.push_back( std::make_shared<DispatchedConnection>() );
+
+        entry = m_priv->m_dispatched.back().get();
+        entry->connection = connection;
+        entry->id = m_priv->m_nextId++;
+        entry->queued = false;
+        entry->woken = false;
+
+        m_priv->m_newConnections.push_back( entry );
+    }
+
+    // Only this connection needs to be looked at when it has something to send
+    priv_data* priv = m_priv.get();
+    std::weak_ptr<DispatchedConnection> weakEntry = m_priv->m_dispatched.back();
+    entry->wakeSlot = connection->signal_needs_dispatch().connect( [priv, weakEntry]() {
+        std::shared_ptr<DispatchedConnection> woken = weakEntry.lock();
+
+        if( woken ) { priv->wake( woken ); }
+    } );
+#else
     connection->signal_needs_dispatch().connect( sigc::mem_fun( *this, &StandaloneDispatcher::wakeup_thread ) );
-    m_priv->m_connections.push_back( connection );
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_connectionsLock );
+        m_priv->m_connections.push_back( connection );
+    }
+#endif
+
     wakeup_thread();
 
     return true;
@@ -107,6 +324,10 @@ bool StandaloneDispatcher::start() {
 
     m_priv->m_dispatch_thread = std::thread( &StandaloneDispatcher::dispatch_thread_main, this );
 
+    if( m_priv->m_cpu >= 0 ) {
+        apply_cpu_affinity();
+    }
+
     return true;
 }
 
@@ -128,18 +349,329 @@ bool StandaloneDispatcher::is_running() {
     return m_priv->m_running;
 }
 
+void StandaloneDispatcher::set_dispatch_budget( uint32_t max_messages, std::chrono::microseconds max_time ) {
+    m_priv->m_dispatch_loop_limit = max_messages;
+    m_priv->m_dispatch_time_limit_us = max_time.count();
+}
+
+bool StandaloneDispatcher::set_cpu_affinity( int cpu ) {
+#ifdef DBUS_CXX_HAS_PTHREAD_SETAFFINITY_NP
+    if( cpu >= CPU_SETSIZE ) {
+        return false;
+    }
+
+    m_priv->m_cpu = cpu;
+
+    if( !m_priv->m_dispatch_thread.joinable() ) {
+        // We will do it once the thread is started
+        return true;
+    }
+
+    return apply_cpu_affinity();
+#else
+    SIMPLELOGGER_WARN( LOGGER_NAME, "Setting the CPU affinity is not supported on this platform" );
+    return false;
+#endif
+}
+
+bool StandaloneDispatcher::apply_cpu_affinity() {
+#ifdef DBUS_CXX_HAS_PTHREAD_SETAFFINITY_NP
+    cpu_set_t cpus;
+
+    CPU_ZERO( &cpus );
+
+    if( m_priv->m_cpu < 0 ) {
+        for( int x = 0; x < CPU_SETSIZE; x++ ) {
+            CPU_SET( x, &cpus );
+        }
+    } else {
+        CPU_SET( m_priv->m_cpu, &cpus );
+    }
+
+    int stat = pthread_setaffinity_np( m_priv->m_dispatch_thread.native_handle(), sizeof( cpus ), &cpus );
+
+    if( stat != 0 ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to set CPU affinity to " << m_priv->m_cpu << ": " << strerror( stat ) );
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+sigc::signal<void(std::shared_ptr<DBus::Connection>)>& StandaloneDispatcher::signal_connection_removed() {
+    return m_priv->m_connectionRemoved;
+}
+
+std::thread::id StandaloneDispatcher::dispatch_thread_id() const {
+    return m_priv->m_dispatch_thread.get_id();
+}
+
+std::vector<std::shared_ptr<DBus::Connection>> StandaloneDispatcher::connections() {
+    std::unique_lock<std::mutex> lock( m_priv->m_connectionsLock );
+
+    return m_priv->m_connections;
+}
+
+#ifdef USE_EPOLL
+
+void StandaloneDispatcher::dispatch_thread_main() {
+    struct epoll_event events[ MAX_EPOLL_EVENTS ];
+
+    for( std::shared_ptr<Connection> conn : connections() ) {
+        conn->set_dispatching_thread( std::this_thread::get_id() );
+    }
+
+    while( m_priv->m_running ) {
+        update_connections();
+
+        // Wake up in time to time out calls that are waiting for replies
+        int timeout = m_priv->queue_timed_out();
+
+        // Don't sleep if a connection still has work left over from the last loop
+        if( !m_priv->m_ready.empty() ) {
+            timeout = 0;
+        }
+
+        int numEvents = epoll_wait( m_priv->m_epollFd, events, MAX_EPOLL_EVENTS, timeout );
+
+        if( numEvents < 0 && errno != EINTR ) {
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to wait for events: " << strerror( errno ) );
+        }
+
+        for( int x = 0; x < numEvents; x++ ) {
+            uint64_t id = events[ x ].data.u64;
+
+            if( id == 0 ) {
+                uint64_t discard;
+
+                if( read( m_priv->m_wakeupFd, &discard, sizeof( discard ) ) < 0 ) {
+                    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Failure reading from dispatch thread eventfd: "
+                                        << strerror( errno ) );
+                }
+
+                continue;
+            }
+
+            std::unordered_map<uint64_t, DispatchedConnection*>::iterator found = m_priv->m_byId.find( id );
+
+            // This connection has been removed since
+            if( found == m_priv->m_byId.end() ) { continue; }
+
+            m_priv->queue( found->second );
+        }
+
+        {
+            std::unique_lock<std::mutex> lock( m_priv->m_wokenLock );
+
+            for( std::shared_ptr<DispatchedConnection> entry : m_priv->m_woken ) {
+                entry->woken = false;
+
+                // This connection was removed after it asked to be woken up
+                if( !entry->connection ) { continue; }
+
+                m_priv->queue( entry.get() );
+            }
+
+            m_priv->m_woken.clear();
+        }
+
+        dispatch_connections();
+    }
+}
+
+void StandaloneDispatcher::update_connections() {
+    std::vector<DispatchedConnection*> newConnections;
+    std::vector<std::shared_ptr<Connection>> failed;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_connectionsLock );
+        newConnections.swap( m_priv->m_newConnections );
+    }
+
+    for( DispatchedConnection* entry : newConnections ) {
+        entry->connection->set_dispatching_thread( std::this_thread::get_id() );
+        m_priv->m_known.push_back( entry );
+        m_priv->m_byId[ entry->id ] = entry;
+
+        if( entry->connection->is_connecting() ) {
+            m_priv->m_connecting.push_back( entry );
+            continue;
+        }
+
+        m_priv->watch( entry, EPOLLIN | EPOLLRDHUP );
+
+        if( !entry->connection->is_registered() ) {
+            entry->connection->bus_register();
+        }
+
+        // It may have had messages queued up before we knew about it
+        m_priv->queue( entry );
+    }
+
+    /*
+     * Connections that are still connecting need different events depending
+     * on where they are in the process, and may change sockets.  There should
+     * only ever be a few of these.
+     */
+    for( std::vector<DispatchedConnection*>::iterator it = m_priv->m_connecting.begin();
+        it != m_priv->m_connecting.end(); ) {
+        DispatchedConnection* entry = *it;
+        std::shared_ptr<Connection> conn = entry->connection;
+
+        if( conn->is_connecting() ) {
+            m_priv->watch( entry, conn->connect_wants_write() ? EPOLLOUT : EPOLLIN );
+            it++;
+            continue;
+        }
+
+        if( conn->is_valid() ) {
+            m_priv->watch( entry, EPOLLIN | EPOLLRDHUP );
+            m_priv->queue( entry );
+        } else {
+            failed.push_back( conn );
+        }
+
+        it = m_priv->m_connecting.erase( it );
+    }
+
+    for( std::shared_ptr<Connection> conn : failed ) {
+        remove_connection( conn );
+    }
+}
+
+void StandaloneDispatcher::dispatch_connections() {
+    uint32_t loop_limit = m_priv->m_dispatch_loop_limit;
+    std::chrono::microseconds time_limit( m_priv->m_dispatch_time_limit_us );
+    std::vector<DispatchedConnection*> ready;
+
+    ready.swap( m_priv->m_ready );
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Dispatching " << ready.size() << " connections" );
+
+    for( DispatchedConnection* entry : ready ) {
+        std::shared_ptr<Connection> conn = entry->connection;
+        DispatchStatus stat;
+
+        entry->queued = false;
+        stat = conn->dispatch_all( loop_limit, time_limit );
+
+        /*
+         * We only hear about new data once, so if the transport stopped early
+         * (e.g. it threw away a bad message) we need to come back on our own.
+         */
+        if( stat == DispatchStatus::COMPLETE && conn->is_valid() && !conn->is_connecting() ) {
+            int available = 0;
+
+            if( ioctl( conn->unix_fd(), FIONREAD, &available ) == 0 && available > 0 ) {
+                stat = DispatchStatus::DATA_REMAINS;
+            }
+        }
+
+        if( stat != DispatchStatus::COMPLETE ) {
+            m_priv->queue( entry );
+        } else if( !conn->is_valid() && !conn->is_connecting() ) {
+            // Any calls that were waiting have been failed by now
+            remove_connection( conn );
+        }
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "done dispatching" );
+}
+
+void StandaloneDispatcher::remove_connection( std::shared_ptr<Connection> connection ) {
+    std::vector<std::shared_ptr<DispatchedConnection>>::iterator found;
+    std::shared_ptr<DispatchedConnection> entry;
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Connection is gone, no longer dispatching it" );
+
+    /*
+     * The socket is not taken out of epoll here: it may be closed already,
+     * and the number given to somebody else.  The kernel takes it out once
+     * it is closed, and any event before then is for an ID we don't know.
+     */
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_connectionsLock );
+
+        found = std::find_if( m_priv->m_dispatched.begin(), m_priv->m_dispatched.end(),
+            [connection]( const std::shared_ptr<DispatchedConnection>& e ) {
+                return e->connection == connection;
+            } );
+
+        if( found == m_priv->m_dispatched.end() ) { return; }
+
+        entry = *found;
+        m_priv->m_dispatched.erase( found );
+        m_priv->m_connections.erase(
+            std::remove( m_priv->m_connections.begin(), m_priv->m_connections.end(), connection ),
+            m_priv->m_connections.end() );
+    }
+
+    entry->wakeSlot.disconnect();
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_wokenLock );
+        m_priv->m_woken.erase(
+            std::remove( m_priv->m_woken.begin(), m_priv->m_woken.end(), entry ),
+            m_priv->m_woken.end() );
+        entry->connection.reset();
+    }
+
+    m_priv->m_byId.erase( entry->id );
+    m_priv->m_known.erase(
+        std::remove( m_priv->m_known.begin(), m_priv->m_known.end(), entry.get() ),
+        m_priv->m_known.end() );
+    m_priv->m_connecting.erase(
+        std::remove( m_priv->m_connecting.begin(), m_priv->m_connecting.end(), entry.get() ),
+        m_priv->m_connecting.end() );
+    m_priv->m_ready.erase(
+        std::remove( m_priv->m_ready.begin(), m_priv->m_ready.end(), entry.get() ),
+        m_priv->m_ready.end() );
+
+    m_priv->m_connectionRemoved.emit( connection );
+}
+
+void StandaloneDispatcher::wakeup_thread() {
+    m_priv->wakeup();
+}
+
+#else
+
 void StandaloneDispatcher::dispatch_thread_main() {
     std::vector<int> fds;
+    std::vector<int> writeFds;
+    int timeout;
 
-    for( std::shared_ptr<Connection> conn : m_priv->m_connections ) {
+    for( std::shared_ptr<Connection> conn : connections() ) {
         conn->set_dispatching_thread( std::this_thread::get_id() );
     }
 
     while( m_priv->m_running ) {
         fds.clear();
+        writeFds.clear();
         fds.push_back( m_priv->process_fd[ 1 ] );
+        timeout = -1;
+
+        for( std::shared_ptr<Connection> conn : connections() ) {
+            int conn_timeout = conn->next_timeout_milliseconds();
+
+            // Wake up in time to time out calls that are waiting for replies
+            if( conn_timeout >= 0 && ( timeout < 0 || conn_timeout < timeout ) ) {
+                timeout = conn_timeout;
+            }
+
+            if( conn->is_connecting() ) {
+                if( conn->connect_wants_write() ) {
+                    writeFds.push_back( conn->unix_fd() );
+                } else {
+                    fds.push_back( conn->unix_fd() );
+                }
+
+                continue;
+            }
 
-        for( std::shared_ptr<Connection> conn : m_priv->m_connections ) {
             if( !conn->is_registered() ) {
                 conn->bus_register();
             }
@@ -148,10 +680,10 @@ void StandaloneDispatcher::dispatch_thread_main() {
         }
 
         std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> fdResponse =
-            DBus::priv::wait_for_fd_activity( fds, -1 );
+            DBus::priv::wait_for_fd_activity( fds, timeout, writeFds );
         std::vector<int> fdsToRead = std::get<2>( fdResponse );
 
-        if( fdsToRead[ 0 ] == m_priv->process_fd[ 1 ] ) {
+        if( !fdsToRead.empty() && fdsToRead[ 0 ] == m_priv->process_fd[ 1 ] ) {
             char discard;
             if( read( m_priv->process_fd[ 1 ], &discard, sizeof( char ) ) < 0 ){
                 SIMPLELOGGER_DEBUG( LOGGER_NAME, "Failure reading from dispatch thread process_fd: "
@@ -163,32 +695,39 @@ void StandaloneDispatcher::dispatch_thread_main() {
     }
 }
 
+void StandaloneDispatcher::update_connections() {
+    // Nothing to do, we look at every connection on every loop
+}
+
 void StandaloneDispatcher::dispatch_connections() {
     uint32_t loop_limit = m_priv->m_dispatch_loop_limit;
-
-    if( loop_limit == 0 ) {
-        loop_limit = UINT32_MAX;
-    }
+    std::chrono::microseconds time_limit( m_priv->m_dispatch_time_limit_us );
 
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "Dispatching connections" );
 
-    for( std::shared_ptr<Connection> conn : m_priv->m_connections ) {
-        for( uint32_t x = 0; x < loop_limit; x++ ) {
-            DispatchStatus stat = conn->dispatch();
-
-            if( stat == DispatchStatus::COMPLETE ) {
-                break;
-            }
-        }
-
-        if( conn->dispatch_status() != DispatchStatus::COMPLETE ) {
+    for( std::shared_ptr<Connection> conn : connections() ) {
+        // Only go around again(and pay for a wakeup) if the budget ran out
+        if( conn->dispatch_all( loop_limit, time_limit ) != DispatchStatus::COMPLETE ) {
             wakeup_thread();
+        } else if( !conn->is_valid() && !conn->is_connecting() ) {
+            remove_connection( conn );
         }
     }
 
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "done dispatching" );
 }
 
+void StandaloneDispatcher::remove_connection( std::shared_ptr<Connection> connection ) {
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_connectionsLock );
+        m_priv->m_connections.erase(
+            std::remove( m_priv->m_connections.begin(), m_priv->m_connections.end(), connection ),
+            m_priv->m_connections.end() );
+    }
+
+    m_priv->m_connectionRemoved.emit( connection );
+}
+
 void StandaloneDispatcher::wakeup_thread() {
     char to_write = '0';
 
@@ -196,3 +735,5 @@ void StandaloneDispatcher::wakeup_thread() {
         SIMPLELOGGER_ERROR( LOGGER_NAME, "Can't write to socketpair?!" );
     }
 }
+
+#endif
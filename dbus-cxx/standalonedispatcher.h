@@ -9,6 +9,12 @@
 #define DBUSCXX_STANDALONE_DISPATCHER
 
 #include "dispatcher.h"
+#include <sigc++/sigc++.h>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <thread>
+#include <vector>
 
 namespace DBus {
 
@@ -18,7 +24,10 @@ class Connection;
  * The StandaloneDispatcher creates a new thread that handles all of the
  * reading and writing to the bus.
  *
- * One dispatcher can handle multiple connections.
+ * One dispatcher can handle multiple connections.  Where epoll is available,
+ * each connection is registered with the kernel once and only the
+ * connections that have something to do are dispatched, so a dispatcher
+ * can handle many connections cheaply.
  */
 class StandaloneDispatcher : public Dispatcher {
 private:
@@ -39,6 +48,13 @@ public:
 
     bool add_connection( std::shared_ptr<Connection> connection );
 
+    /**
+     * Emitted from the dispatch thread once a connection has gone away for
+     * good(it was disconnected, or failed to connect) and we have stopped
+     * dispatching it.
+     */
+    sigc::signal<void(std::shared_ptr<Connection>)>& signal_connection_removed();
+
     //@}
 
     bool start();
@@ -47,17 +63,71 @@ public:
 
     bool is_running();
 
+    /**
+     * Set how much work is done on one connection before moving on to the
+     * next one.  Each time the dispatch thread wakes up, it reads and
+     * processes every message that is waiting on a connection(see
+     * Connection::dispatch_all()) until this budget runs out.  If the budget
+     * runs out, the remaining messages are handled on the next loop.
+     *
+     * By default, at most 1024 messages are processed per connection with
+     * no time limit.
+     *
+     * @param max_messages The most messages to process per connection.
+     * If 0, there is no limit.
+     * @param max_time How long to spend on one connection.  If 0, there is no limit.
+     */
+    void set_dispatch_budget( uint32_t max_messages,
+                              std::chrono::microseconds max_time = std::chrono::microseconds::zero() );
+
+    /**
+     * Only let the dispatch thread run on the given CPU.  This may be called
+     * before or after the dispatcher is started.
+     *
+     * @param cpu The CPU to run on, or -1 to let it run on any CPU
+     * @return True if the affinity could be set(or will be set when the
+     * thread is started), false if it is not supported or the CPU is invalid.
+     */
+    bool set_cpu_affinity( int cpu );
+
+    /**
+     * The ID of the thread that dispatches our connections.  This is only
+     * valid while the dispatcher is running.
+     */
+    std::thread::id dispatch_thread_id() const;
+
 private:
 
     void dispatch_thread_main();
 
     void wakeup_thread();
 
+    /** Apply the CPU affinity to the dispatch thread */
+    bool apply_cpu_affinity();
+
+    /**
+     * Get a copy of our connections, so the dispatch thread does not need
+     * to hold the lock while it dispatches.
+     */
+    std::vector<std::shared_ptr<Connection>> connections();
+
     /**
-     * Dispatch all of our connections
+     * Pick up connections that have been added, and keep track of
+     * connections that are still connecting.
+     */
+    void update_connections();
+
+    /**
+     * Dispatch all of our connections that have something to do
      */
     void dispatch_connections();
 
+    /**
+     * Stop dispatching a connection that is gone and will not come back.
+     * Only called from the dispatch thread.
+     */
+    void remove_connection( std::shared_ptr<Connection> connection );
+
 private:
     class priv_data;
 
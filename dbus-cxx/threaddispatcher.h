@@ -73,6 +73,8 @@ public:
     /**
      * When a new signal message comes in that needs to be processed, this method
      * is called with the SignalMessage that must be emitted from this thread.
+     * This is only called for signals that may match one of the signal proxies
+     * that were added with add_signal_proxy.
      *
      * Generally, this method should push the SignalMesage onto some sort of
      * mutex-locked queue and then wakeup this thread.  This thread will then
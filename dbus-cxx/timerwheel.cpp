@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "timerwheel.h"
+
+#include <limits>
+
+using DBus::priv::TimerWheel;
+
+static const uint64_t NO_TICK = std::numeric_limits<uint64_t>::max();
+
+TimerWheel::TimerWheel( std::chrono::milliseconds tick_length, size_t num_slots ) :
+    m_tickLength( tick_length ),
+    m_start( std::chrono::steady_clock::now() ),
+    m_slots( num_slots ),
+    m_currentTick( 0 ),
+    m_nextTick( NO_TICK ),
+    m_size( 0 ) {
+}
+
+void TimerWheel::add( uint32_t id, TimePoint deadline ) {
+    uint64_t tick = tick_for( deadline );
+
+    // Anything that has already expired goes in the next tick that we will look at
+    if( tick <= m_currentTick ) {
+        tick = m_currentTick + 1;
+    }
+
+    m_slots[ tick % m_slots.size() ].push_back( Entry{ id, tick } );
+    m_size++;
+
+    if( tick < m_nextTick ) {
+        m_nextTick = tick;
+    }
+}
+
+bool TimerWheel::remove( uint32_t id, TimePoint deadline ) {
+    uint64_t tick = tick_for( deadline );
+
+    if( tick <= m_currentTick ) {
+        tick = m_currentTick + 1;
+    }
+
+    std::vector<Entry>& slot = m_slots[ tick % m_slots.size() ];
+
+    for( size_t x = 0; x < slot.size(); x++ ) {
+        if( slot[ x ].id == id ) {
+            slot[ x ] = slot.back();
+            slot.pop_back();
+            m_size--;
+
+            // m_nextTick may now be early, which is allowed
+            if( m_size == 0 ) {
+                m_nextTick = NO_TICK;
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<uint32_t> TimerWheel::expire( TimePoint now ) {
+    std::vector<uint32_t> expired;
+    uint64_t nowTick = 0;
+
+    if( now > m_start ) {
+        nowTick = ( now - m_start ) / m_tickLength;
+    }
+
+    if( nowTick <= m_currentTick ) {
+        return expired;
+    }
+
+    if( m_size > 0 && nowTick >= m_nextTick ) {
+        // Each slot only needs to be looked at once, no matter how much time has gone by
+        uint64_t lastTick = nowTick;
+
+        if( nowTick - m_currentTick > m_slots.size() ) {
+            lastTick = m_currentTick + m_slots.size();
+        }
+
+        for( uint64_t tick = m_currentTick + 1; tick <= lastTick; tick++ ) {
+            std::vector<Entry>& slot = m_slots[ tick % m_slots.size() ];
+
+            for( size_t x = 0; x < slot.size(); ) {
+                if( slot[ x ].tick <= nowTick ) {
+                    expired.push_back( slot[ x ].id );
+                    slot[ x ] = slot.back();
+                    slot.pop_back();
+                    m_size--;
+                } else {
+                    x++;
+                }
+            }
+        }
+    }
+
+    m_currentTick = nowTick;
+    update_next_tick();
+
+    return expired;
+}
+
+TimerWheel::TimePoint TimerWheel::next_expiry() const {
+    if( m_nextTick == NO_TICK ) {
+        return TimePoint::max();
+    }
+
+    return time_for( m_nextTick );
+}
+
+void TimerWheel::clear() {
+    for( std::vector<Entry>& slot : m_slots ) {
+        slot.clear();
+    }
+
+    m_nextTick = NO_TICK;
+    m_size = 0;
+}
+
+size_t TimerWheel::size() const {
+    return m_size;
+}
+
+std::chrono::milliseconds TimerWheel::tick_length() const {
+    return m_tickLength;
+}
+
+uint64_t TimerWheel::tick_for( TimePoint time ) const {
+    if( time <= m_start ) {
+        return 0;
+    }
+
+    std::chrono::nanoseconds since_start = time - m_start;
+    std::chrono::nanoseconds tick_length = m_tickLength;
+
+    // Round up, so that nothing expires early
+    return ( since_start.count() + tick_length.count() - 1 ) / tick_length.count();
+}
+
+TimerWheel::TimePoint TimerWheel::time_for( uint64_t tick ) const {
+    return m_start + tick * m_tickLength;
+}
+
+void TimerWheel::update_next_tick() {
+    if( m_size == 0 ) {
+        m_nextTick = NO_TICK;
+        return;
+    }
+
+    // Look one time around the wheel for the next thing to expire
+    for( uint64_t tick = m_currentTick + 1; tick <= m_currentTick + m_slots.size(); tick++ ) {
+        for( const Entry& entry : m_slots[ tick % m_slots.size() ] ) {
+            if( entry.tick == tick ) {
+                m_nextTick = tick;
+                return;
+            }
+        }
+    }
+
+    // Everything is further away than that; check again once we've gone around
+    m_nextTick = m_currentTick + m_slots.size();
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUSCXX_TIMERWHEEL_H
+#define DBUSCXX_TIMERWHEEL_H
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * Keeps track of when a large number of timeouts expire, without keeping
+ * them sorted.
+ *
+ * Time is cut up into ticks of tick_length(), and each timeout is put in
+ * the slot for the tick that it expires in.  Adding and removing a timeout
+ * only touches that one slot, and expiring timeouts only looks at the slots
+ * for the ticks that have gone by.  A timeout may expire up to one tick late,
+ * but never early.
+ *
+ * This class is not thread-safe.
+ */
+class TimerWheel {
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    TimerWheel( std::chrono::milliseconds tick_length = std::chrono::milliseconds( 10 ),
+                size_t num_slots = 256 );
+
+    /**
+     * Start keeping track of a timeout.
+     *
+     * @param id What to return from expire() when the timeout expires
+     * @param deadline When the timeout expires
+     */
+    void add( uint32_t id, TimePoint deadline );
+
+    /**
+     * Stop keeping track of a timeout.
+     *
+     * @param id The ID that was given to add()
+     * @param deadline The deadline that was given to add()
+     * @return True if the timeout was found
+     */
+    bool remove( uint32_t id, TimePoint deadline );
+
+    /**
+     * Remove every timeout that has expired as of now.
+     *
+     * @return The IDs of the timeouts that expired
+     */
+    std::vector<uint32_t> expire( TimePoint now );
+
+    /**
+     * Stop keeping track of every timeout.
+     */
+    void clear();
+
+    /**
+     * When expire() next needs to be called.  This may be earlier than
+     * the next timeout actually expires, but is never later.  If there are
+     * no timeouts, returns TimePoint::max().
+     */
+    TimePoint next_expiry() const;
+
+    size_t size() const;
+
+    std::chrono::milliseconds tick_length() const;
+
+private:
+    struct Entry {
+        uint32_t id;
+        uint64_t tick;
+    };
+
+    uint64_t tick_for( TimePoint time ) const;
+
+    TimePoint time_for( uint64_t tick ) const;
+
+    /** Find the earliest tick that something expires in */
+    void update_next_tick();
+
+private:
+    std::chrono::milliseconds m_tickLength;
+    TimePoint m_start;
+    std::vector<std::vector<Entry>> m_slots;
+    /* The last tick that expire() has dealt with */
+    uint64_t m_currentTick;
+    /* expire() must be called at or after this tick */
+    uint64_t m_nextTick;
+    size_t m_size;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUSCXX_TIMERWHEEL_H */
@@ -11,21 +11,75 @@
 #include "simpletransport.h"
 #include "sendmsgtransport.h"
 #include "sasl.h"
+#include "utility.h"
 
+#include <climits>
 #include <cstring>
 #include <fcntl.h>
 #include <map>
+#include <random>
 #include <vector>
 #include <string>
 #include <unistd.h>
 
+#include <netdb.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/un.h>
 
 static const char* LOGGER_NAME = "DBus.Transport";
 
+/* Number of bytes in the nonce for nonce-tcp */
+#define NONCE_LENGTH 16
+/* How long a newly accepted client has for its nonce and authentication, all together */
+#define HANDSHAKE_TIMEOUT_MS 30000
+
 using DBus::priv::Transport;
+using DBus::priv::TransportConnector;
+
+enum class AddressType {
+    Unix,
+    Tcp
+};
+
+struct ConnectAddress {
+    AddressType type;
+    /* For unix: the path to the socket */
+    std::string path;
+    bool is_abstract;
+    /* For tcp: one of the resolved addresses of the host */
+    struct sockaddr_storage tcpAddr;
+    socklen_t tcpAddrLen;
+    /* For nonce-tcp: the file that holds the nonce that we need to send */
+    std::string nonceFile;
+    int sendBufferSize;
+    int receiveBufferSize;
+};
+
+class TransportConnector::priv_data {
+public:
+    priv_data( bool blocking_connect ) :
+        m_blockingConnect( blocking_connect ),
+        m_nextAddress( 0 ),
+        m_fd( -1 ),
+        m_wantsWrite( false ),
+        m_status( Status::InProgress )
+    {}
+
+    bool m_blockingConnect;
+    std::vector<ConnectAddress> m_addresses;
+    size_t m_nextAddress;
+    int m_fd;
+    bool m_wantsWrite;
+    Status m_status;
+    std::shared_ptr<Transport> m_transport;
+    std::unique_ptr<SASL> m_sasl;
+};
 
 class ParsedTransport {
 public:
@@ -39,6 +93,14 @@ enum class ParsingState {
     Parsing_Value
 };
 
+static void set_nonblocking( int fd ) {
+    int flags = fcntl( fd, F_GETFL, 0 );
+
+    if( fcntl( fd, F_SETFL, flags | O_NONBLOCK ) < 0 ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to set non-blocking" );
+    }
+}
+
 static std::vector<ParsedTransport> parseTransports( std::string address_str ) {
     std::string tmpTransportName;
     std::string tmpKey;
@@ -109,14 +171,67 @@ static std::vector<ParsedTransport> parseTransports( std::string address_str ) {
     return retval;
 }
 
-static int open_unix_socket( std::string socketAddress, bool is_abstract ) {
+/**
+ * Connect the socket to the given address.  The socket is always non-blocking
+ * once we return.  If blocking_connect is false and the connection can't be
+ * completed right away, in_progress is set to true and the socket will become
+ * writable once the connection has finished.
+ *
+ * On error, the socket is closed and -1 is returned.
+ */
+static int connect_socket( int fd, const struct sockaddr* addr, socklen_t addr_len, std::string description, bool blocking_connect, bool* in_progress ) {
+    int stat;
+
+    *in_progress = false;
+
+    if( !blocking_connect ) {
+        set_nonblocking( fd );
+    }
+
+    do {
+        stat = ::connect( fd, addr, addr_len );
+    } while( stat < 0 && errno == EINTR );
+
+    if( stat < 0 && !blocking_connect && errno == EINPROGRESS ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Connection to " + description + " is in progress" );
+        *in_progress = true;
+        return fd;
+    }
+
+    if( stat < 0 ) {
+        int my_errno = errno;
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to connect to " + description + ": " + errmsg );
+        close( fd );
+        errno = my_errno;
+        return -1;
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Opened dbus connection to " + description );
+
+    if( blocking_connect ) {
+        set_nonblocking( fd );
+    }
+
+    return fd;
+}
+
+static int open_unix_socket( std::string socketAddress, bool is_abstract, bool blocking_connect, bool* in_progress ) {
     struct sockaddr_un addr;
     int fd;
     int stat;
     int passcred = 1;
     socklen_t data_len = 0;
 
+    *in_progress = false;
     memset( &addr, 0, sizeof( struct sockaddr_un ) );
+
+    if( socketAddress.size() >= sizeof( addr.sun_path ) ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Socket path too long: " + socketAddress );
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
     fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
 
     if( fd < 0 ) {
@@ -125,6 +240,17 @@ static int open_unix_socket( std::string socketAddress, bool is_abstract ) {
         return fd;
     }
 
+    stat = ::setsockopt( fd, SOL_SOCKET, SO_PASSCRED, &passcred, sizeof( int ) );
+
+    if( stat < 0 ) {
+        int my_errno = errno;
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to set passcred: " + errmsg );
+        close( fd );
+        errno = my_errno;
+        return stat;
+    }
+
     addr.sun_family = AF_UNIX;
 
     if( is_abstract ) {
@@ -135,100 +261,778 @@ static int open_unix_socket( std::string socketAddress, bool is_abstract ) {
         data_len = sizeof( addr );
     }
 
-    stat = ::connect( fd, ( struct sockaddr* )&addr, data_len );
+    return connect_socket( fd, ( struct sockaddr* )&addr, data_len, socketAddress, blocking_connect, in_progress );
+}
 
-    if( stat < 0 ) {
-        int my_errno = errno;
+/**
+ * Parse a socket buffer size from an address.  Returns 0(use the system
+ * default) if the value is empty or not valid.
+ */
+static int parse_buffer_size( const std::string& value ) {
+    if( value.empty() ) {
+        return 0;
+    }
+
+    char* end;
+    long size = strtol( value.c_str(), &end, 10 );
+
+    if( *end != '\0' || size <= 0 || size > INT_MAX ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Ignoring invalid socket buffer size " + value );
+        return 0;
+    }
+
+    return size;
+}
+
+static void set_tcp_options( int fd, int sendBufferSize, int receiveBufferSize ) {
+    int nodelay = 1;
+
+    // Messages are small and latency sensitive; don't wait to fill up a packet
+    if( ::setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof( int ) ) < 0 ) {
         std::string errmsg = strerror( errno );
-        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to connect: " + errmsg );
-        errno = my_errno;
-        return stat;
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to set TCP_NODELAY: " + errmsg );
     }
 
-    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Opened dbus connection to " + socketAddress );
+    if( sendBufferSize > 0 &&
+        ::setsockopt( fd, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof( int ) ) < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to set send buffer size: " + errmsg );
+    }
 
-    stat = ::setsockopt( fd, SOL_SOCKET, SO_PASSCRED, &passcred, sizeof( int ) );
+    if( receiveBufferSize > 0 &&
+        ::setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof( int ) ) < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to set receive buffer size: " + errmsg );
+    }
+}
 
-    if( stat < 0 ) {
-        int my_errno = errno;
+static std::string describe_tcp_address( const struct sockaddr_storage& addr ) {
+    char host[ INET6_ADDRSTRLEN ];
+    int port;
+
+    if( addr.ss_family == AF_INET6 ) {
+        const struct sockaddr_in6* addr6 = reinterpret_cast<const struct sockaddr_in6*>( &addr );
+        inet_ntop( AF_INET6, &addr6->sin6_addr, host, sizeof( host ) );
+        port = ntohs( addr6->sin6_port );
+    } else {
+        const struct sockaddr_in* addr4 = reinterpret_cast<const struct sockaddr_in*>( &addr );
+        inet_ntop( AF_INET, &addr4->sin_addr, host, sizeof( host ) );
+        port = ntohs( addr4->sin_port );
+    }
+
+    return std::string( host ) + ":" + std::to_string( port );
+}
+
+static int open_tcp_socket( const ConnectAddress& address, bool blocking_connect, bool* in_progress ) {
+    int fd = ::socket( address.tcpAddr.ss_family, SOCK_STREAM, 0 );
+
+    *in_progress = false;
+
+    if( fd < 0 ) {
         std::string errmsg = strerror( errno );
-        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to set passcred: " + errmsg );
-        errno = my_errno;
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to create socket: " + errmsg );
+        return fd;
+    }
+
+    set_tcp_options( fd, address.sendBufferSize, address.receiveBufferSize );
+
+    return connect_socket( fd, ( const struct sockaddr* )&address.tcpAddr, address.tcpAddrLen,
+            describe_tcp_address( address.tcpAddr ), blocking_connect, in_progress );
+}
+
+/**
+ * Resolve the host of a tcp: or nonce-tcp: address.  This is the only part
+ * of connecting that may block(on DNS).
+ */
+static std::vector<ConnectAddress> resolve_tcp_address( ParsedTransport& param ) {
+    std::vector<ConnectAddress> retval;
+    std::string host = param.m_config[ "host" ];
+    std::string port = param.m_config[ "port" ];
+    std::string family = param.m_config[ "family" ];
+    struct addrinfo hints;
+    struct addrinfo* result;
+
+    if( host.empty() ) {
+        host = "localhost";
+    }
+
+    if( port.empty() ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "No port given for " + param.m_transportName + " address" );
+        return retval;
+    }
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_family = AF_UNSPEC;
+
+    if( family == "ipv4" ) {
+        hints.ai_family = AF_INET;
+    } else if( family == "ipv6" ) {
+        hints.ai_family = AF_INET6;
+    }
+
+    int stat = getaddrinfo( host.c_str(), port.c_str(), &hints, &result );
+
+    if( stat != 0 ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to resolve " + host + ": " + gai_strerror( stat ) );
+        return retval;
+    }
+
+    for( struct addrinfo* info = result; info != nullptr; info = info->ai_next ) {
+        ConnectAddress address;
+
+        address.type = AddressType::Tcp;
+        address.is_abstract = false;
+        memcpy( &address.tcpAddr, info->ai_addr, info->ai_addrlen );
+        address.tcpAddrLen = info->ai_addrlen;
+        address.nonceFile = param.m_config[ "noncefile" ];
+        address.sendBufferSize = parse_buffer_size( param.m_config[ "sndbuf" ] );
+        address.receiveBufferSize = parse_buffer_size( param.m_config[ "rcvbuf" ] );
+
+        retval.push_back( address );
+    }
+
+    freeaddrinfo( result );
+
+    return retval;
+}
+
+static bool read_nonce_file( const std::string& nonceFile, std::vector<uint8_t>* nonce ) {
+    int fd = open( nonceFile.c_str(), O_RDONLY | O_CLOEXEC );
+    uint8_t buffer[ NONCE_LENGTH ];
+    size_t bytesRead = 0;
+
+    if( fd < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to open nonce file " + nonceFile + ": " + errmsg );
+        return false;
+    }
+
+    while( bytesRead < NONCE_LENGTH ) {
+        ssize_t ret = ::read( fd, buffer + bytesRead, NONCE_LENGTH - bytesRead );
+
+        if( ret < 0 && errno == EINTR ) {
+            continue;
+        }
+
+        if( ret <= 0 ) {
+            break;
+        }
+
+        bytesRead += ret;
+    }
+
+    close( fd );
+
+    if( bytesRead != NONCE_LENGTH ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Nonce file " + nonceFile + " is too short" );
+        return false;
+    }
+
+    nonce->assign( buffer, buffer + NONCE_LENGTH );
+
+    return true;
+}
+
+/**
+ * Write all of the data to a socket that may be non-blocking.  Only used for
+ * the few bytes that we send before the transport exists.
+ */
+static bool write_all( int fd, const uint8_t* data, size_t len ) {
+    size_t written = 0;
+
+    while( written < len ) {
+        ssize_t ret = ::send( fd, data + written, len - written, MSG_NOSIGNAL );
+
+        if( ret < 0 && ( errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+            pollfd pollfd;
+            pollfd.fd = fd;
+            pollfd.events = POLLOUT;
+            poll( &pollfd, 1, -1 );
+            continue;
+        }
+
+        if( ret < 0 ) {
+            return false;
+        }
+
+        written += ret;
+    }
+
+    return true;
+}
+
+/**
+ * Read the nonce from a newly accepted client, and check that it is correct.
+ */
+static bool check_nonce( int fd, const std::vector<uint8_t>& nonce, std::chrono::steady_clock::time_point deadline ) {
+    uint8_t buffer[ NONCE_LENGTH ];
+    size_t bytesRead = 0;
+    uint8_t difference = 0;
+
+    while( bytesRead < NONCE_LENGTH ) {
+        pollfd pollfd;
+        pollfd.fd = fd;
+        pollfd.events = POLLIN;
+
+        if( poll( &pollfd, 1, DBus::priv::milliseconds_until( deadline ) ) <= 0 ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Timed out waiting for nonce from client" );
+            return false;
+        }
+
+        ssize_t ret = ::read( fd, buffer + bytesRead, NONCE_LENGTH - bytesRead );
+
+        if( ret < 0 && ( errno == EINTR || errno == EAGAIN ) ) {
+            continue;
+        }
+
+        if( ret <= 0 ) {
+            return false;
+        }
+
+        bytesRead += ret;
+    }
+
+    // Look at every byte, so that how long this takes tells nothing about the nonce
+    for( size_t x = 0; x < NONCE_LENGTH; x++ ) {
+        difference |= buffer[ x ] ^ nonce[ x ];
+    }
+
+    return difference == 0;
+}
+
+/**
+ * Create a new nonce, and write it to a file that only we can read.
+ */
+static bool create_nonce_file( std::vector<uint8_t>* nonce, std::string* nonceFile ) {
+    char dirTemplate[] = "/tmp/dbus-cxx-XXXXXX";
+    std::random_device rd;
+
+    if( mkdtemp( dirTemplate ) == nullptr ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to create nonce directory: " + errmsg );
+        return false;
+    }
+
+    nonce->clear();
+
+    for( int x = 0; x < NONCE_LENGTH; x++ ) {
+        nonce->push_back( rd() & 0xFF );
+    }
+
+    *nonceFile = std::string( dirTemplate ) + "/nonce";
+
+    int fd = open( nonceFile->c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR );
+
+    if( fd < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to create nonce file: " + errmsg );
+        rmdir( dirTemplate );
+        return false;
+    }
+
+    bool ok = ::write( fd, nonce->data(), nonce->size() ) == NONCE_LENGTH;
+    close( fd );
+
+    if( !ok ) {
+        unlink( nonceFile->c_str() );
+        rmdir( dirTemplate );
+        return false;
+    }
+
+    return true;
+}
+
+static int listen_tcp_socket( ParsedTransport& param, bool use_nonce, Transport::ListenInfo* info ) {
+    std::string host = param.m_config[ "host" ];
+    std::string bind = param.m_config[ "bind" ];
+    std::string port = param.m_config[ "port" ];
+    std::string family = param.m_config[ "family" ];
+    struct addrinfo hints;
+    struct addrinfo* result;
+    struct sockaddr_storage boundAddr;
+    socklen_t boundAddrLen = sizeof( boundAddr );
+    int reuse = 1;
+    int fd = -1;
+
+    if( host.empty() ) {
+        host = "localhost";
+    }
+
+    if( bind.empty() ) {
+        bind = host;
+    }
+
+    if( port.empty() ) {
+        port = "0";
+    }
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_family = AF_UNSPEC;
+
+    if( family == "ipv4" ) {
+        hints.ai_family = AF_INET;
+    } else if( family == "ipv6" ) {
+        hints.ai_family = AF_INET6;
+    }
+
+    int stat = getaddrinfo( bind == "*" ? nullptr : bind.c_str(), port.c_str(), &hints, &result );
+
+    if( stat != 0 ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to resolve " + bind + ": " + gai_strerror( stat ) );
+        return -1;
+    }
+
+    for( struct addrinfo* addrinfo = result; addrinfo != nullptr; addrinfo = addrinfo->ai_next ) {
+        fd = ::socket( addrinfo->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+        if( fd < 0 ) {
+            continue;
+        }
+
+        ::setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( int ) );
+
+        // Accepted sockets inherit these from the listening socket
+        set_tcp_options( fd,
+            parse_buffer_size( param.m_config[ "sndbuf" ] ),
+            parse_buffer_size( param.m_config[ "rcvbuf" ] ) );
+
+        if( ::bind( fd, addrinfo->ai_addr, addrinfo->ai_addrlen ) == 0 &&
+            ::listen( fd, SOMAXCONN ) == 0 ) {
+            break;
+        }
+
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to listen on " + bind + ": " + errmsg );
         close( fd );
-        return stat;
+        fd = -1;
     }
 
-    // Turn the FD into non-blocking
-    {
-        int flags = fcntl( fd, F_GETFL, 0 );
+    freeaddrinfo( result );
 
-        if( fcntl( fd, F_SETFL, flags | O_NONBLOCK ) < 0 ) {
-            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to set non-blocking" );
+    if( fd < 0 ) {
+        return -1;
+    }
+
+    // If we were given port 0, find out which port we really got
+    if( getsockname( fd, ( struct sockaddr* )&boundAddr, &boundAddrLen ) == 0 ) {
+        if( boundAddr.ss_family == AF_INET6 ) {
+            port = std::to_string( ntohs( reinterpret_cast<struct sockaddr_in6*>( &boundAddr )->sin6_port ) );
+        } else {
+            port = std::to_string( ntohs( reinterpret_cast<struct sockaddr_in*>( &boundAddr )->sin_port ) );
         }
     }
 
+    info->address = param.m_transportName + ":host=" + host + ",port=" + port;
+
+    if( !family.empty() ) {
+        info->address += ",family=" + family;
+    }
+
+    if( use_nonce ) {
+        if( !create_nonce_file( &info->nonce, &info->nonceFile ) ) {
+            close( fd );
+            return -1;
+        }
+
+        info->address += ",noncefile=" + info->nonceFile;
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Listening for peer connections on " + info->address );
+
+    return fd;
+}
+
+static int listen_unix_socket( std::string socketAddress, bool is_abstract ) {
+    struct sockaddr_un addr;
+    int fd;
+    int stat;
+    socklen_t data_len = 0;
+
+    memset( &addr, 0, sizeof( struct sockaddr_un ) );
+
+    if( socketAddress.size() >= sizeof( addr.sun_path ) ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Socket path too long: " + socketAddress );
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+    if( fd < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to create socket: " + errmsg );
+        return fd;
+    }
+
+    addr.sun_family = AF_UNIX;
+
+    if( is_abstract ) {
+        memcpy( &addr.sun_path[ 1 ], socketAddress.c_str(), socketAddress.size() );
+        data_len = offsetof( struct sockaddr_un, sun_path ) + socketAddress.size() + 1;
+    } else {
+        // A stale socket from a previous run would make bind() fail
+        unlink( socketAddress.c_str() );
+        memcpy( addr.sun_path, socketAddress.c_str(), socketAddress.size() );
+        data_len = sizeof( addr );
+    }
+
+    stat = ::bind( fd, ( struct sockaddr* )&addr, data_len );
+
+    if( stat == 0 ) {
+        stat = ::listen( fd, SOMAXCONN );
+    }
+
+    if( stat < 0 ) {
+        int my_errno = errno;
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to listen on " + socketAddress + ": " + errmsg );
+        close( fd );
+        errno = my_errno;
+        return stat;
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Listening for peer connections on " + socketAddress );
+
     return fd;
 }
 
 Transport::~Transport() {}
 
+bool Transport::has_borrowed_buffers() const {
+    return false;
+}
+
+std::chrono::steady_clock::time_point Transport::release_idle_buffers() {
+    return std::chrono::steady_clock::time_point::max();
+}
+
 std::shared_ptr<Transport> Transport::open_transport( std::string address ) {
+    std::shared_ptr<TransportConnector> connector = TransportConnector::create( address, true );
+
+    while( connector->status() == TransportConnector::Status::InProgress ) {
+        pollfd pollfd;
+        pollfd.fd = connector->fd();
+        pollfd.events = connector->wants_write() ? POLLOUT : POLLIN;
+
+        if( poll( &pollfd, 1, -1 ) < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+
+            std::string errmsg = strerror( errno );
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to poll while connecting: " + errmsg );
+            return std::shared_ptr<Transport>();
+        }
+
+        connector->step();
+    }
+
+    return connector->transport();
+}
+
+Transport::ListenInfo Transport::open_listener( std::string address ) {
     std::vector<ParsedTransport> transports = parseTransports( address );
-    std::shared_ptr<Transport> retTransport;
-    bool negotiateFD = false;
+    ListenInfo info;
+
+    info.fd = -1;
 
     for( ParsedTransport param : transports ) {
         if( param.m_transportName == "unix" ) {
             std::string path = param.m_config[ "path" ];
             std::string abstractPath = param.m_config[ "abstract" ];
-            int fd;
 
             if( !path.empty() ) {
-                fd = open_unix_socket( path, false );
+                info.fd = listen_unix_socket( path, false );
+            } else if( !abstractPath.empty() ) {
+                info.fd = listen_unix_socket( abstractPath, true );
+            }
+
+            info.address = address;
+        } else if( param.m_transportName == "tcp" ) {
+            info.fd = listen_tcp_socket( param, false, &info );
+        } else if( param.m_transportName == "nonce-tcp" ) {
+            info.fd = listen_tcp_socket( param, true, &info );
+        }
 
-                if( fd >= 0 ) {
-                    retTransport = SendmsgTransport::create( fd, true );
+        if( info.fd >= 0 ) {
+            return info;
+        }
+    }
 
-                    if( !retTransport->is_valid() ) {
-                        retTransport.reset();
-                        continue;
-                    }
+    return info;
+}
 
-                    negotiateFD = true;
-                    break;
-                }
+std::shared_ptr<Transport> Transport::accept_transport( int listen_fd,
+        const std::vector<uint8_t>& serverGUID,
+        const std::vector<uint8_t>& nonce,
+        bool allowAnonymous ) {
+    std::shared_ptr<Transport> retTransport;
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof( addr );
+    int fd = ::accept4( listen_fd, ( struct sockaddr* )&addr, &addr_len, SOCK_CLOEXEC );
+    bool is_tcp;
+    // The client gets this long for the whole handshake, no matter how slowly it sends
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds( HANDSHAKE_TIMEOUT_MS );
+
+    if( fd < 0 ) {
+        std::string errmsg = strerror( errno );
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to accept: " + errmsg );
+        return retTransport;
+    }
+
+    is_tcp = addr.ss_family == AF_INET || addr.ss_family == AF_INET6;
+
+    if( !nonce.empty() && !check_nonce( fd, nonce, deadline ) ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Client did not send the correct nonce" );
+        close( fd );
+        return retTransport;
+    }
+
+    if( is_tcp ) {
+        set_tcp_options( fd, 0, 0 );
+    }
+
+    /*
+     * We can't find out who is on the other end of a TCP connection,
+     * so clients can only authenticate anonymously there.  That is only
+     * allowed if they sent the nonce, or we were told that anybody may connect.
+     */
+    priv::SASL saslAuth( fd, !is_tcp );
+    std::tuple<bool, bool> resp = saslAuth.authenticate_server( serverGUID, deadline,
+        is_tcp && ( !nonce.empty() || allowAnonymous ) );
+
+    if( std::get<0>( resp ) == false ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Client did not authenticate" );
+        close( fd );
+        return retTransport;
+    }
+
+    set_nonblocking( fd );
+
+    if( is_tcp ) {
+        retTransport = SimpleTransport::create( fd, false );
+    } else {
+        retTransport = SendmsgTransport::create( fd, false );
+    }
+
+    if( !retTransport->is_valid() ) {
+        retTransport.reset();
+        return retTransport;
+    }
+
+    retTransport->m_serverAddress = serverGUID;
+
+    return retTransport;
+}
+
+TransportConnector::TransportConnector( bool blocking_connect ) :
+    m_priv( std::make_unique<priv_data>( blocking_connect ) ) {
+}
+
+TransportConnector::~TransportConnector() {
+    // Once we have a transport, it owns the FD
+    if( !m_priv->m_transport && m_priv->m_fd >= 0 ) {
+        close( m_priv->m_fd );
+    }
+}
+
+std::shared_ptr<TransportConnector> TransportConnector::create( std::string address, bool blocking_connect ) {
+    std::shared_ptr<TransportConnector> connector( new TransportConnector( blocking_connect ) );
+
+    for( ParsedTransport param : parseTransports( address ) ) {
+        if( param.m_transportName == "unix" ) {
+            std::string path = param.m_config[ "path" ];
+            std::string abstractPath = param.m_config[ "abstract" ];
+            ConnectAddress unixAddress;
+
+            unixAddress.type = AddressType::Unix;
+            unixAddress.tcpAddrLen = 0;
+            unixAddress.sendBufferSize = 0;
+            unixAddress.receiveBufferSize = 0;
+
+            if( !path.empty() ) {
+                unixAddress.path = path;
+                unixAddress.is_abstract = false;
+                connector->m_priv->m_addresses.push_back( unixAddress );
             }
 
             if( !abstractPath.empty() ) {
-                fd = open_unix_socket( abstractPath, true );
+                unixAddress.path = abstractPath;
+                unixAddress.is_abstract = true;
+                connector->m_priv->m_addresses.push_back( unixAddress );
+            }
+        } else if( param.m_transportName == "tcp" ||
+            param.m_transportName == "nonce-tcp" ) {
+            if( param.m_transportName == "nonce-tcp" && param.m_config[ "noncefile" ].empty() ) {
+                SIMPLELOGGER_DEBUG( LOGGER_NAME, "nonce-tcp address without a noncefile" );
+                continue;
+            }
 
-                if( fd >= 0 ) {
-                    retTransport = SendmsgTransport::create( fd, true );
+            for( ConnectAddress tcpAddress : resolve_tcp_address( param ) ) {
+                connector->m_priv->m_addresses.push_back( tcpAddress );
+            }
+        }
+    }
 
-                    if( !retTransport->is_valid() ) {
-                        retTransport.reset();
-                        continue;
-                    }
+    connector->connect_next_address();
 
-                    negotiateFD = true;
-                    break;
-                }
-            }
+    return connector;
+}
+
+int TransportConnector::fd() const {
+    if( m_priv->m_status != Status::InProgress ) {
+        return -1;
+    }
+
+    return m_priv->m_fd;
+}
+
+bool TransportConnector::wants_write() const {
+    return m_priv->m_wantsWrite;
+}
+
+TransportConnector::Status TransportConnector::status() const {
+    return m_priv->m_status;
+}
+
+TransportConnector::Status TransportConnector::step() {
+    if( m_priv->m_status != Status::InProgress ) {
+        return m_priv->m_status;
+    }
+
+    if( m_priv->m_wantsWrite ) {
+        int error = 0;
+        socklen_t errorLen = sizeof( error );
+        pollfd pollfd;
+        pollfd.fd = m_priv->m_fd;
+        pollfd.events = POLLOUT;
+
+        // We may be called before the connection has finished
+        if( poll( &pollfd, 1, 0 ) == 0 ) {
+            return m_priv->m_status;
+        }
+
+        if( getsockopt( m_priv->m_fd, SOL_SOCKET, SO_ERROR, &error, &errorLen ) < 0 ) {
+            error = errno;
+        }
+
+        if( error != 0 ) {
+            std::string errmsg = strerror( error );
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to connect: " + errmsg );
+            close( m_priv->m_fd );
+            m_priv->m_fd = -1;
+            connect_next_address();
+        } else {
+            connected();
+        }
+
+        return m_priv->m_status;
+    }
+
+    SASL::Status saslStatus = m_priv->m_sasl->continue_authenticate();
+
+    if( saslStatus == SASL::Status::Success ) {
+        m_priv->m_transport->m_serverAddress = m_priv->m_sasl->server_guid();
+        m_priv->m_sasl.reset();
+        m_priv->m_status = Status::Done;
+    } else if( saslStatus == SASL::Status::Failed ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Did not authenticate with server" );
+        m_priv->m_sasl.reset();
+        m_priv->m_transport.reset();
+        m_priv->m_fd = -1;
+        m_priv->m_status = Status::Failed;
+    }
+
+    return m_priv->m_status;
+}
+
+std::shared_ptr<Transport> TransportConnector::transport() const {
+    if( m_priv->m_status != Status::Done ) {
+        return std::shared_ptr<Transport>();
+    }
+
+    return m_priv->m_transport;
+}
+
+void TransportConnector::connect_next_address() {
+    m_priv->m_wantsWrite = false;
+
+    while( m_priv->m_nextAddress < m_priv->m_addresses.size() ) {
+        const ConnectAddress& address = m_priv->m_addresses[ m_priv->m_nextAddress++ ];
+        bool in_progress;
+        int fd;
+
+        if( address.type == AddressType::Tcp ) {
+            fd = open_tcp_socket( address, m_priv->m_blockingConnect, &in_progress );
+        } else {
+            fd = open_unix_socket( address.path, address.is_abstract, m_priv->m_blockingConnect, &in_progress );
         }
+
+        if( fd < 0 ) {
+            continue;
+        }
+
+        m_priv->m_fd = fd;
+
+        if( in_progress ) {
+            m_priv->m_wantsWrite = true;
+        } else {
+            connected();
+        }
+
+        return;
     }
 
-    if( retTransport ) {
-        priv::SASL saslAuth( retTransport->fd(), negotiateFD );
-        std::tuple<bool, bool, std::vector<uint8_t>> resp =
-                saslAuth.authenticate();
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to connect to any address" );
+    m_priv->m_status = Status::Failed;
+}
+
+void TransportConnector::connected() {
+    const ConnectAddress& address = m_priv->m_addresses[ m_priv->m_nextAddress - 1 ];
+    bool is_tcp = address.type == AddressType::Tcp;
+
+    m_priv->m_wantsWrite = false;
 
-        retTransport->m_serverAddress = std::get<2>( resp );
+    // For nonce-tcp, the nonce must come before anything else
+    if( !address.nonceFile.empty() ) {
+        std::vector<uint8_t> nonce;
 
-        if( std::get<0>( resp ) == false ) {
-            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Did not authenticate with server" );
-            retTransport.reset();
+        if( !read_nonce_file( address.nonceFile, &nonce ) ||
+            !write_all( m_priv->m_fd, nonce.data(), nonce.size() ) ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to send nonce" );
+            close( m_priv->m_fd );
+            m_priv->m_fd = -1;
+            connect_next_address();
+            return;
         }
     }
 
-    return retTransport;
+    // File descriptors can only be passed over unix sockets
+    if( is_tcp ) {
+        m_priv->m_transport = SimpleTransport::create( m_priv->m_fd, true );
+    } else {
+        m_priv->m_transport = SendmsgTransport::create( m_priv->m_fd, true );
+    }
+
+    if( !m_priv->m_transport->is_valid() ) {
+        // The transport has closed the FD already
+        m_priv->m_transport.reset();
+        m_priv->m_fd = -1;
+        connect_next_address();
+        return;
+    }
+
+    m_priv->m_sasl = std::make_unique<SASL>( m_priv->m_fd, !is_tcp );
+
+    if( !m_priv->m_sasl->begin_authenticate() ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to start authentication" );
+        m_priv->m_sasl.reset();
+        m_priv->m_transport.reset();
+        m_priv->m_fd = -1;
+        m_priv->m_status = Status::Failed;
+    }
 }
@@ -8,6 +8,8 @@
 #ifndef DBUSCXX_TRANSPORT_H
 #define DBUSCXX_TRANSPORT_H
 
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <chrono>
 #include <memory>
 #include <stdint.h>
 #include <string>
@@ -54,18 +56,143 @@ public:
      */
     virtual int fd() const = 0;
 
+    /**
+     * Check to see if this transport is holding on to a buffer that it
+     * borrowed from the BufferPool for a large message.
+     */
+    virtual bool has_borrowed_buffers() const;
+
+    /**
+     * Give the borrowed buffers that have not been needed for the pool's
+     * idle timeout back to the pool.  Must not be called while a message
+     * is being written.
+     *
+     * @return When this should be called again, or time_point::max() if
+     * nothing is borrowed anymore
+     */
+    virtual std::chrono::steady_clock::time_point release_idle_buffers();
+
     /**
      * Open and return a transport based off of the given address.
      *
+     * For tcp: and nonce-tcp: addresses, TCP_NODELAY is always set.  The
+     * socket buffer sizes may be set with the sndbuf= and rcvbuf= keys,
+     * e.g. tcp:host=localhost,port=1234,sndbuf=262144,rcvbuf=262144
+     *
      * @param address The address to connect to, in DBus transport format
      * (e.g. unix:path=/tmp/dbus-test)
      * @return An opened file descriptor, or -1 on error(with errno set)
      */
     static std::shared_ptr<Transport> open_transport( std::string address );
 
+    struct ListenInfo {
+        /** The listening file descriptor, or -1 on error */
+        int fd;
+        /** The address that clients should connect to */
+        std::string address;
+        /** For nonce-tcp, the nonce that clients must send */
+        std::vector<uint8_t> nonce;
+        /** For nonce-tcp, the file that the nonce was written to */
+        std::string nonceFile;
+    };
+
+    /**
+     * Open a listening socket on the given address, so that clients may
+     * connect to us directly(peer-to-peer) without going through a bus daemon.
+     *
+     * For tcp: and nonce-tcp: addresses, a port of 0(or no port) means to
+     * pick any free port; the address in the returned ListenInfo has the
+     * real port.  For nonce-tcp:, a new nonce file is created.
+     *
+     * @param address The address to listen on, in DBus transport format
+     * (e.g. unix:path=/tmp/dbus-test, unix:abstract=dbus-test or
+     * tcp:host=localhost,port=0)
+     * @return Information about the listening socket
+     */
+    static ListenInfo open_listener( std::string address );
+
+    /**
+     * Accept a new client on a socket opened with open_listener, and
+     * perform the server side of the authentication.
+     *
+     * @param listen_fd The listening socket
+     * @param serverGUID The GUID that we give to clients
+     * @param nonce For nonce-tcp, the nonce that the client must send
+     * @param allowAnonymous True to let TCP clients authenticate anonymously
+     * even if they did not send a nonce
+     * @return The transport for the new client, or an invalid shared_ptr
+     * if the client could not be accepted or authenticated.
+     */
+    static std::shared_ptr<Transport> accept_transport( int listen_fd,
+            const std::vector<uint8_t>& serverGUID,
+            const std::vector<uint8_t>& nonce,
+            bool allowAnonymous = false );
+
 protected:
     std::vector<uint8_t> m_serverAddress;
 
+    friend class TransportConnector;
+};
+
+/**
+ * Opens a transport to the given address without blocking.
+ *
+ * This connects the socket and runs the SASL handshake as a state machine.
+ * Whenever fd() becomes readable(or writable, if wants_write() is true),
+ * step() must be called to make progress, until status() is no longer
+ * Status::InProgress.  The data from the server may come in any number of
+ * pieces.
+ */
+class TransportConnector {
+public:
+    enum class Status {
+        InProgress,
+        Done,
+        Failed
+    };
+
+private:
+    TransportConnector( bool blocking_connect );
+
+public:
+    ~TransportConnector();
+
+    /**
+     * Start connecting to the given address.
+     *
+     * @param address The address to connect to, in DBus transport format
+     * @param blocking_connect True if the connect() itself may block.  The
+     * SASL handshake is never blocking.
+     * @return The connector.  Check status() to see if we failed right away.
+     */
+    static std::shared_ptr<TransportConnector> create( std::string address, bool blocking_connect = false );
+
+    /** The FD that we are waiting on, or -1 if we are not connecting */
+    int fd() const;
+
+    /** True if we are waiting for fd() to become writable instead of readable */
+    bool wants_write() const;
+
+    Status status() const;
+
+    /**
+     * Make progress on the connection.  Call when fd() is ready.
+     *
+     * @return The new status
+     */
+    Status step();
+
+    /** The transport, once status() is Status::Done */
+    std::shared_ptr<Transport> transport() const;
+
+private:
+    void connect_next_address();
+    void connected();
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
 };
 
 } /* namepsace priv */
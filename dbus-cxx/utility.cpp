@@ -18,24 +18,37 @@
 #include "simplelogger_defs.h"
 #include <locale>
 #include <chrono>
+#include <limits>
 
 #include <poll.h>
 
-/* Extern function for logging in headers */
+/* Extern function and level for logging in headers */
 simplelogger_log_function dbuscxx_log_function = nullptr;
+enum SL_LogLevel dbuscxx_header_log_level = SL_TRACE;
 
-namespace DBus {
+/* The level that log_std_err() prints from */
+static enum SL_LogLevel dbuscxx_log_level = SL_INFO;
 
-static enum SL_LogLevel log_level = SL_INFO;
+/* Only skip messages in the headers that log_std_err() would throw away anyway */
+static void update_header_log_level() {
+    if( dbuscxx_log_function == DBus::log_std_err ) {
+        dbuscxx_header_log_level = dbuscxx_log_level;
+    } else {
+        dbuscxx_header_log_level = SL_TRACE;
+    }
+}
+
+namespace DBus {
 
 void set_logging_function( simplelogger_log_function function ) {
     dbuscxx_log_function = function;
+    update_header_log_level();
 }
 
 void log_std_err( const char* logger_name, const struct SL_LogLocation* location,
     const enum SL_LogLevel level,
     const char* log_string ) {
-    if( level < log_level ) { return; }
+    if( level < dbuscxx_log_level ) { return; }
 
     char buffer[ 4096 ];
     const char* stringLevel;
@@ -50,7 +63,8 @@ void log_std_err( const char* logger_name, const struct SL_LogLocation* location
 }
 
 void set_log_level( const enum SL_LogLevel level ) {
-    log_level = level;
+    dbuscxx_log_level = level;
+    update_header_log_level();
 }
 
 void hexdump( const std::vector<uint8_t>* vec, std::ostream* stream ) {
@@ -92,14 +106,14 @@ void hexdump( const uint8_t* vec, uint32_t len, std::ostream* stream ) {
     }
 }
 
-std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> priv::wait_for_fd_activity( std::vector<int> fds, int timeout_ms ) {
+std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> priv::wait_for_fd_activity( std::vector<int> fds, int timeout_ms, std::vector<int> writeFds ) {
     std::vector<pollfd> toListen;
     bool timeout;
     int poll_ret;
     std::chrono::milliseconds ms_waited;
     std::vector<int> fdsToRead;
 
-    toListen.reserve( fds.size() );
+    toListen.reserve( fds.size() + writeFds.size() );
 
     for( int fd : fds ) {
         struct pollfd pollfd;
@@ -109,6 +123,14 @@ std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> priv::wait_fo
         toListen.push_back( pollfd );
     }
 
+    for( int fd : writeFds ) {
+        struct pollfd pollfd;
+        pollfd.fd = fd;
+        pollfd.events = POLLOUT;
+        pollfd.revents = 0;
+        toListen.push_back( pollfd );
+    }
+
     std::chrono::time_point start = std::chrono::steady_clock::now();
 
     do {
@@ -121,7 +143,7 @@ std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> priv::wait_fo
                 );
 
             for( pollfd pollentry : toListen ) {
-                if( pollentry.revents & POLLIN ) {
+                if( pollentry.revents & ( POLLIN | POLLOUT ) ) {
                     fdsToRead.push_back( pollentry.fd );
                 }
             }
@@ -136,6 +158,19 @@ std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> priv::wait_fo
 
     return std::make_tuple( timeout, poll_ret, fdsToRead, ms_waited );
 }
+
+int priv::milliseconds_until( std::chrono::steady_clock::time_point deadline ) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if( deadline <= now ) {
+        return 0;
+    }
+
+    std::chrono::milliseconds::rep ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>( deadline - now + std::chrono::milliseconds( 1 ) ).count();
+
+    return ms > std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : static_cast<int>( ms );
+}
 }
 
 
@@ -99,6 +99,10 @@ void log_std_err( const char* logger_name, const struct ::SL_LogLocation* locati
 /**
  * When used in conjunction with DBus::logStdErr, will only print out log messages above the set level.
  * By default, this is set to SL_INFO
+ *
+ * While DBus::log_std_err is the logging function, messages below this level
+ * that are logged from the library headers are not even formatted.  Any other
+ * logging function gets every message, and does its own filtering.
  */
 void set_log_level( const enum ::SL_LogLevel level );
 
@@ -350,13 +354,22 @@ struct dbus_function_traits<std::function<DBus::MultipleReturn<T_ret...>( Args..
  *
  * @param fds The FDs to monitor
  * @param timeout The timeout, in milliseconds to wait.  -1 means infite.
+ * @param writeFds FDs to monitor for becoming writable instead of readable
  * @return Tuple containing:
  * - bool true if we timedout, false otherwise
  * - int # of FDs to read
- * - vector of FDs to read
+ * - vector of FDs to read(or write, for the FDs in writeFds)
  * - milliseconds # of MS we waited
  */
-std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> wait_for_fd_activity( std::vector<int> fds, int timeout_ms );
+std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> wait_for_fd_activity( std::vector<int> fds, int timeout_ms, std::vector<int> writeFds = std::vector<int>() );
+
+/**
+ * How long to wait for until the given deadline, suitable for poll().
+ *
+ * @param deadline When to stop waiting
+ * @return The number of milliseconds left, rounded up, or 0 if the deadline has passed
+ */
+int milliseconds_until( std::chrono::steady_clock::time_point deadline );
 
 } /* namespace priv */
 
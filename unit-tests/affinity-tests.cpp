@@ -140,6 +140,42 @@ bool affinity_signal_main_thread() {
     return false;
 }
 
+bool affinity_signal_targeted() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<AffinityThreadDispatcher> afDisp = std::shared_ptr<AffinityThreadDispatcher>( new AffinityThreadDispatcher );
+    conn->add_thread_dispatcher( afDisp );
+    int otherSignals = 0;
+
+    std::shared_ptr<DBus::SignalProxy<void()>> proxy = conn->create_free_signal_proxy<void()>(
+                DBus::MatchRuleBuilder::create()
+                .set_interface( "interface.name" )
+                .set_member( "myname" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::CurrentThread );
+
+    std::shared_ptr<DBus::SignalProxy<void()>> otherProxy = conn->create_free_signal_proxy<void()>(
+                DBus::MatchRuleBuilder::create()
+                .set_interface( "interface.other" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+    otherProxy->connect( [&otherSignals]() {
+        otherSignals++;
+    } );
+
+    conn->create_free_signal<void()>( "/", "interface.other", "othername" )->emit();
+    conn->create_free_signal<void()>( "/", "interface.name", "myname" )->emit();
+    conn->create_free_signal<void()>( "/", "interface.other", "othername" )->emit();
+
+    std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+
+    // Only the signal that the main thread wants is queued up for it
+    TEST_EQUALS_RET_FAIL( otherSignals, 2 );
+    TEST_EQUALS_RET_FAIL( afDisp->m_signalMessages.size(), 1 );
+    TEST_EQUALS_RET_FAIL( afDisp->m_signalMessages[ 0 ]->member(), "myname" );
+
+    return true;
+}
+
 bool affinity_message_dispatch_thread() {
     std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
     conn->request_name( "dbuscxx.test" );
@@ -253,6 +289,7 @@ int main( int argc, char** argv ) {
 
     ADD_TEST( signal_dispatcher_thread );
     ADD_TEST( signal_main_thread );
+    ADD_TEST( signal_targeted );
     ADD_TEST( message_dispatch_thread );
     ADD_TEST( message_main_thread );
     ADD_TEST( message_change_thread );
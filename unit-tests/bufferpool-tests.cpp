@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <dbus-cxx/bufferpool.h>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+#include "test_macros.h"
+
+using DBus::priv::BufferPool;
+
+bool bufferpool_size_class() {
+    TEST_EQUALS_RET_FAIL( BufferPool::size_class( 0 ), 512 );
+    TEST_EQUALS_RET_FAIL( BufferPool::size_class( 512 ), 512 );
+    TEST_EQUALS_RET_FAIL( BufferPool::size_class( 513 ), 1024 );
+    TEST_EQUALS_RET_FAIL( BufferPool::size_class( 70000 ), 131072 );
+
+    // A new buffer is not filled in
+    std::vector<uint8_t> buffer = BufferPool::instance().acquire( 3000 );
+    TEST_ASSERT_RET_FAIL( buffer.capacity() >= 4096 );
+    TEST_EQUALS_RET_FAIL( buffer.size(), 0 );
+
+    return true;
+}
+
+bool bufferpool_reuse() {
+    BufferPool& pool = BufferPool::instance();
+    std::vector<uint8_t> buffer = pool.acquire( 8192 );
+    uint8_t* data = buffer.data();
+
+    pool.release( std::move( buffer ) );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 8192 );
+
+    std::vector<uint8_t> again = pool.acquire( 5000 );
+    TEST_ASSERT_RET_FAIL( again.data() == data );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 0 );
+
+    return true;
+}
+
+bool bufferpool_high_water_mark() {
+    BufferPool& pool = BufferPool::instance();
+    pool.set_high_water_mark( 4096 );
+
+    pool.release( pool.acquire( 4096 ) );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 4096 );
+
+    // No more room, so this one must be freed
+    pool.release( pool.acquire( 1024 ) );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 4096 );
+
+    pool.set_high_water_mark( 0 );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 0 );
+
+    return true;
+}
+
+bool bufferpool_idle_trim() {
+    BufferPool& pool = BufferPool::instance();
+    pool.set_idle_timeout( std::chrono::milliseconds( 10 ) );
+
+    pool.release( pool.acquire( 65536 ) );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 65536 );
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+    TEST_ASSERT_RET_FAIL( pool.trim() == std::chrono::steady_clock::time_point::max() );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 0 );
+
+    return true;
+}
+
+bool bufferpool_large_buffer() {
+    BufferPool& pool = BufferPool::instance();
+    std::shared_ptr<DBus::Dispatcher> dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::atomic<bool> received( false );
+
+    // A buffer for the largest message there can be is never kept around
+    pool.release( pool.acquire( 64 * 1024 * 1024 ) );
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 0 );
+
+    pool.set_idle_timeout( std::chrono::milliseconds( 500 ) );
+
+    std::shared_ptr<DBus::Signal<void(std::vector<uint8_t>)>> signal =
+        conn->create_free_signal<void(std::vector<uint8_t>)>( "/test/bufferpool", "test.bufferpool", "Large" );
+    std::shared_ptr<DBus::SignalProxy<void(std::vector<uint8_t>)>> proxy =
+        conn->create_free_signal_proxy<void(std::vector<uint8_t>)>(
+            DBus::MatchRuleBuilder::create()
+            .set_path( "/test/bufferpool" )
+            .set_interface( "test.bufferpool" )
+            .set_member( "Large" )
+            .as_signal_match(),
+            DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( [&received]( std::vector<uint8_t> ) { received = true; } );
+
+    // Both the send and the receive buffer have to grow for this
+    signal->emit( std::vector<uint8_t>( 128 * 1024 ) );
+
+    for( int x = 0; x < 500 && !received; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    TEST_ASSERT_RET_FAIL( received );
+
+    // With no more traffic, the transport gives the large buffers back...
+    bool givenBack = false;
+
+    for( int x = 0; x < 5000 && !givenBack; x++ ) {
+        givenBack = pool.pooled_bytes() >= 128 * 1024;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    TEST_ASSERT_RET_FAIL( givenBack );
+
+    // ...and the pool frees them once they have been idle for long enough
+    for( int x = 0; x < 500 && pool.pooled_bytes() != 0; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( pool.pooled_bytes(), 0 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = bufferpool_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( size_class );
+    ADD_TEST( reuse );
+    ADD_TEST( high_water_mark );
+    ADD_TEST( idle_trim );
+    ADD_TEST( large_buffer );
+
+    return !ret;
+}
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "test_macros.h"
+
+static std::atomic<int> running_calls;
+static std::atomic<int> max_running_calls;
+
+static int32_t slow_call( int32_t value ) {
+    int running = ++running_calls;
+    int max = max_running_calls;
+
+    while( running > max && !max_running_calls.compare_exchange_weak( max, running ) ) {}
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    running_calls--;
+
+    return value;
+}
+
+/**
+ * Call the 'slow' method from the given number of threads at once, and return
+ * how long it took for all of the calls to finish.
+ */
+static std::chrono::milliseconds call_concurrently( DBus::ThreadForCalling calling, int num_calls ) {
+    std::shared_ptr<DBus::Dispatcher> dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> server = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+
+    server->set_call_pool( DBus::CallPool::create( num_calls ) );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/callpool", calling );
+    object->create_method<int32_t( int32_t )>( "dbuscxx.callpool", "slow", sigc::ptr_fun( slow_call ) );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = client->create_object_proxy( server->unique_name(), "/dbuscxx/callpool" );
+    std::shared_ptr<DBus::MethodProxy<int32_t( int32_t )>> slow_proxy =
+        proxy->create_method<int32_t( int32_t )>( "dbuscxx.callpool", "slow" );
+
+    running_calls = 0;
+    max_running_calls = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::future<int32_t>> results;
+
+    for( int x = 0; x < num_calls; x++ ) {
+        results.push_back( std::async( std::launch::async, [slow_proxy, x]() {
+            return ( *slow_proxy )( x );
+        } ) );
+    }
+
+    for( int x = 0; x < num_calls; x++ ) {
+        if( results[ x ].get() != x ) {
+            return std::chrono::milliseconds::max();
+        }
+    }
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - start );
+}
+
+bool callpool_stealing() {
+    std::shared_ptr<DBus::CallPool> pool = DBus::CallPool::create( 4 );
+    std::mutex lock;
+    std::set<std::thread::id> threads;
+    std::promise<void> done;
+    std::atomic<int> remaining( 64 );
+
+    TEST_EQUALS_RET_FAIL( pool->num_threads(), 4 );
+
+    // All of the work is submitted from one pool thread, so the others must steal it
+    pool->submit( [&]() {
+        for( int x = 0; x < 64; x++ ) {
+            pool->submit( [&]() {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+                {
+                    std::unique_lock<std::mutex> l( lock );
+                    threads.insert( std::this_thread::get_id() );
+                }
+
+                if( --remaining == 0 ) {
+                    done.set_value();
+                }
+            } );
+        }
+    } );
+
+    TEST_ASSERT_RET_FAIL( done.get_future().wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( threads.size() > 1 );
+
+    return true;
+}
+
+bool callpool_strand_order() {
+    std::shared_ptr<DBus::CallPool> pool = DBus::CallPool::create( 4 );
+    std::shared_ptr<DBus::CallPool::Strand> strand = DBus::CallPool::create_strand();
+    std::vector<int> order;
+    std::atomic<int> running( 0 );
+    std::atomic<bool> overlapped( false );
+    std::promise<void> done;
+
+    for( int x = 0; x < 100; x++ ) {
+        pool->submit( strand, [&, x]() {
+            if( ++running != 1 ) {
+                overlapped = true;
+            }
+
+            order.push_back( x );
+            running--;
+
+            if( x == 99 ) {
+                done.set_value();
+            }
+        } );
+    }
+
+    TEST_ASSERT_RET_FAIL( done.get_future().wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( !overlapped );
+    TEST_EQUALS_RET_FAIL( order.size(), 100 );
+
+    for( int x = 0; x < 100; x++ ) {
+        TEST_EQUALS_RET_FAIL( order[ x ], x );
+    }
+
+    return true;
+}
+
+bool callpool_method_concurrent() {
+    std::chrono::milliseconds taken = call_concurrently( DBus::ThreadForCalling::Pool, 4 );
+
+    TEST_ASSERT_RET_FAIL( taken != std::chrono::milliseconds::max() );
+    TEST_ASSERT_RET_FAIL( max_running_calls > 1 );
+
+    return true;
+}
+
+bool callpool_method_serialized() {
+    std::chrono::milliseconds taken = call_concurrently( DBus::ThreadForCalling::PoolSerialized, 4 );
+
+    TEST_ASSERT_RET_FAIL( taken != std::chrono::milliseconds::max() );
+    TEST_EQUALS_RET_FAIL( max_running_calls, 1 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = callpool_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+
+    ADD_TEST( stealing );
+    ADD_TEST( strand_order );
+    ADD_TEST( method_concurrent );
+    ADD_TEST( method_serialized );
+
+    return !ret;
+}
@@ -19,6 +19,12 @@
  *   along with this software. If not see <http://www.gnu.org/licenses/>.  *
  ***************************************************************************/
 #include <dbus-cxx.h>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
 
 #include "test_macros.h"
 
@@ -111,6 +117,569 @@ bool connection_test_method_2arg() {
     return true;
 }
 
+bool connection_async_connect() {
+    std::vector<std::shared_ptr<DBus::Connection>> connections;
+    std::atomic<int> numConnected( 0 );
+    std::atomic<int> numFailed( 0 );
+
+    for( int x = 0; x < 5; x++ ) {
+        std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_async( DBus::BusType::SESSION );
+        TEST_ASSERT_RET_FAIL( conn->is_connecting() );
+
+        conn->signal_connected().connect( [&numConnected, &numFailed]( bool success ) {
+            if( success ) {
+                numConnected++;
+            } else {
+                numFailed++;
+            }
+        } );
+
+        TEST_ASSERT_RET_FAIL( dispatch->add_connection( conn ) );
+        connections.push_back( conn );
+    }
+
+    for( int x = 0; x < 200 && numConnected + numFailed < 5; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( numConnected.load(), 5 );
+    TEST_EQUALS_RET_FAIL( numFailed.load(), 0 );
+
+    for( std::shared_ptr<DBus::Connection> conn : connections ) {
+        TEST_ASSERT_RET_FAIL( conn->is_valid() );
+        TEST_ASSERT_RET_FAIL( !conn->is_connecting() );
+        TEST_ASSERT_RET_FAIL( conn->is_registered() );
+        TEST_ASSERT_RET_FAIL( !conn->unique_name().empty() );
+    }
+
+    TEST_ASSERT_RET_FAIL( connections[ 0 ]->unique_name() != connections[ 1 ]->unique_name() );
+
+    return true;
+}
+
+bool connection_async_connect_hung_daemon() {
+    // A server that never accepts anybody, so authentication never finishes
+    std::shared_ptr<DBus::Server> server = DBus::Server::create( "unix:abstract=dbuscxx-hung-daemon" );
+    TEST_ASSERT_RET_FAIL( server->is_valid() );
+
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_async( "unix:abstract=dbuscxx-hung-daemon", 500 );
+    std::shared_ptr<std::promise<bool>> connected = std::make_shared<std::promise<bool>>();
+    std::future<bool> connected_future = connected->get_future();
+    conn->signal_connected().connect( [connected]( bool success ) {
+        connected->set_value( success );
+    } );
+    TEST_ASSERT_RET_FAIL( conn->is_connecting() );
+    TEST_ASSERT_RET_FAIL( dispatch->add_connection( conn ) );
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+    TEST_ASSERT_RET_FAIL( conn->is_connecting() );
+    TEST_ASSERT_RET_FAIL( !conn->is_valid() );
+
+    // We give up once the time is up, even though the server never said anything
+    TEST_ASSERT_RET_FAIL( connected_future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( !connected_future.get() );
+    TEST_ASSERT_RET_FAIL( !conn->is_connecting() );
+    TEST_ASSERT_RET_FAIL( !conn->is_valid() );
+    TEST_EQUALS_RET_FAIL( conn->next_timeout_milliseconds(), -1 );
+
+    return true;
+}
+
+bool connection_async_connect_bad_address() {
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_async( "unix:path=/this/does/not/exist" );
+
+    TEST_ASSERT_RET_FAIL( !conn->is_connecting() );
+    TEST_ASSERT_RET_FAIL( !conn->is_valid() );
+    TEST_ASSERT_RET_FAIL( !dispatch->add_connection( conn ) );
+
+    return true;
+}
+
+bool connection_dispatch_all() {
+    // Dispatch these ourselves, from this thread
+    std::shared_ptr<DBus::Connection> receiver = DBus::Connection::create( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> sender = DBus::Connection::create( DBus::BusType::SESSION );
+    int received = 0;
+
+    TEST_ASSERT_RET_FAIL( receiver->bus_register() );
+    TEST_ASSERT_RET_FAIL( sender->bus_register() );
+
+    std::shared_ptr<DBus::SignalProxy<void( int )>> proxy = receiver->create_free_signal_proxy<void( int )>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/dispatch/all" )
+                .set_interface( "dbuscxx.dispatch" )
+                .set_member( "Count" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+    proxy->connect( [&received]( int ) { received++; } );
+
+    std::shared_ptr<DBus::Signal<void( int )>> signal =
+        sender->create_free_signal<void( int )>( "/dispatch/all", "dbuscxx.dispatch", "Count" );
+
+    // Get rid of anything the bus sent us while we were registering
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+    receiver->dispatch_all();
+
+    for( int x = 0; x < 50; x++ ) {
+        signal->emit( x );
+    }
+
+    sender->flush();
+    std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+
+    // The budget stops us part of the way through
+    TEST_EQUALS_RET_FAIL( receiver->dispatch_all( 10 ), DBus::DispatchStatus::DATA_REMAINS );
+    TEST_EQUALS_RET_FAIL( received, 10 );
+
+    for( int x = 0; x < 100 && received < 50; x++ ) {
+        receiver->dispatch_all();
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( received, 50 );
+    TEST_EQUALS_RET_FAIL( receiver->dispatch_all(), DBus::DispatchStatus::COMPLETE );
+
+    return true;
+}
+
+bool connection_many_connections() {
+    std::shared_ptr<DBus::Connection> server = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<DBus::Connection>> clients;
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/many", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<double( double, double )>( "Calculator.Basic", "add", sigc::ptr_fun( add ) );
+
+    for( int x = 0; x < 30; x++ ) {
+        clients.push_back( dispatch->create_connection( DBus::BusType::SESSION ) );
+    }
+
+    // Every connection has to be woken up for its own reply, no matter how many others there are
+    for( int round = 0; round < 3; round++ ) {
+        for( size_t x = 0; x < clients.size(); x++ ) {
+            std::shared_ptr<DBus::ObjectProxy> proxy =
+                clients[ x ]->create_object_proxy( server->unique_name(), "/dbuscxx/many" );
+            DBus::MethodProxy<double( double, double )>& add_proxy =
+                *( proxy->create_method<double( double, double )>( "Calculator.Basic", "add" ) );
+
+            TEST_EQUALS_RET_FAIL( add_proxy( x, round ), x + round );
+        }
+    }
+
+    return true;
+}
+
+bool connection_concurrent_send() {
+    std::shared_ptr<DBus::Connection> receiver = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> sender = dispatch->create_connection( DBus::BusType::SESSION );
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<int> last( 8, -1 );
+    int received = 0;
+    bool in_order = true;
+
+    std::shared_ptr<DBus::SignalProxy<void( int, int )>> proxy = receiver->create_free_signal_proxy<void( int, int )>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/concurrent/send" )
+                .set_interface( "dbuscxx.concurrent" )
+                .set_member( "Value" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+    proxy->connect( [&]( int thread, int value ) {
+        std::unique_lock<std::mutex> l( lock );
+
+        // Each thread's signals must come out in the order that they were sent
+        if( value != last[ thread ] + 1 ) {
+            in_order = false;
+        }
+
+        last[ thread ] = value;
+        received++;
+        cv.notify_all();
+    } );
+
+    std::shared_ptr<DBus::Signal<void( int, int )>> signal =
+        sender->create_free_signal<void( int, int )>( "/concurrent/send", "dbuscxx.concurrent", "Value" );
+    std::vector<std::thread> threads;
+
+    // Give the match rule time to get to the bus
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+    for( int x = 0; x < 8; x++ ) {
+        threads.push_back( std::thread( [signal, x]() {
+            for( int y = 0; y < 200; y++ ) {
+                signal->emit( x, y );
+            }
+        } ) );
+    }
+
+    for( std::thread& thr : threads ) {
+        thr.join();
+    }
+
+    std::unique_lock<std::mutex> l( lock );
+    cv.wait_for( l, std::chrono::seconds( 10 ), [&received]() { return received == 8 * 200; } );
+
+    TEST_EQUALS_RET_FAIL( received, 8 * 200 );
+    TEST_ASSERT_RET_FAIL( in_order );
+
+    return true;
+}
+
+static int32_t slow_reply( int32_t value ) {
+    std::this_thread::sleep_for( std::chrono::milliseconds( 500 ) );
+    return value;
+}
+
+bool connection_reply_timeout() {
+    // The server gets its own thread, so that the slow method doesn't hold up the client
+    std::shared_ptr<DBus::Dispatcher> server_dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> server = server_dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/timeout", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<int32_t( int32_t )>( "dbuscxx.timeout", "slow", sigc::ptr_fun( slow_reply ) );
+
+    TEST_EQUALS_RET_FAIL( client->next_timeout_milliseconds(), -1 );
+
+    std::shared_ptr<DBus::CallMessage> call =
+        DBus::CallMessage::create( server->unique_name(), "/dbuscxx/timeout", "dbuscxx.timeout", "slow" );
+    call << int32_t( 5 );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::future<bool> result = std::async( std::launch::async, [client, call]() {
+        try {
+            client->send_with_reply_blocking( call, 100 );
+        } catch( DBus::ErrorNoReply& ) {
+            return true;
+        }
+
+        return false;
+    } );
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+    int pending = client->next_timeout_milliseconds();
+    TEST_ASSERT_RET_FAIL( pending > 0 && pending <= 100 );
+
+    TEST_ASSERT_RET_FAIL( result.get() );
+    TEST_ASSERT_RET_FAIL( std::chrono::steady_clock::now() - start < std::chrono::milliseconds( 400 ) );
+    TEST_EQUALS_RET_FAIL( client->next_timeout_milliseconds(), -1 );
+
+    return true;
+}
+
+static int count_threads() {
+    int threads = 0;
+    std::ifstream status( "/proc/self/status" );
+    std::string line;
+
+    while( std::getline( status, line ) ) {
+        if( line.compare( 0, 8, "Threads:" ) == 0 ) {
+            threads = std::stoi( line.substr( 8 ) );
+        }
+    }
+
+    return threads;
+}
+
+bool connection_call_async_many() {
+    std::shared_ptr<DBus::Connection> server = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/async", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<double( double, double )>( "Calculator.Basic", "add", sigc::ptr_fun( add ) );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = client->create_object_proxy( server->unique_name(), "/dbuscxx/async" );
+    std::shared_ptr<DBus::MethodProxy<double( double, double )>> add_proxy =
+        proxy->create_method<double( double, double )>( "Calculator.Basic", "add" );
+    std::vector<std::future<double>> results;
+    int threads_before = count_threads();
+
+    for( int x = 0; x < 500; x++ ) {
+        results.push_back( add_proxy->call_async( x, 1 ) );
+    }
+
+    // No threads were started to wait for the replies
+    TEST_ASSERT_RET_FAIL( count_threads() <= threads_before );
+
+    for( int x = 0; x < 500; x++ ) {
+        TEST_ASSERT_RET_FAIL( results[ x ].wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+        TEST_EQUALS_RET_FAIL( results[ x ].get(), x + 1 );
+    }
+
+    return true;
+}
+
+bool connection_call_async_callback() {
+    std::shared_ptr<DBus::Dispatcher> server_dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> server = server_dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/async", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<double( double, double )>( "Calculator.Basic", "add", sigc::ptr_fun( add ) );
+    object->create_method<int32_t( int32_t )>( "dbuscxx.timeout", "slow", sigc::ptr_fun( slow_reply ) );
+
+    std::promise<double> sum;
+    std::shared_ptr<DBus::CallMessage> call =
+        DBus::CallMessage::create( server->unique_name(), "/dbuscxx/async", "Calculator.Basic", "add" );
+    call << 2.0 << 3.0;
+
+    std::shared_ptr<DBus::PendingCall> pending = client->send_with_reply_async( call, -1,
+        [&sum]( std::shared_ptr<DBus::PendingCall> reply ) {
+            double value;
+            reply->return_message() >> value;
+            sum.set_value( value );
+        } );
+
+    TEST_ASSERT_RET_FAIL( pending );
+    TEST_ASSERT_RET_FAIL( sum.get_future().wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( pending->completed() );
+
+    // Calls that don't get an answer in time get ErrorNoReply
+    std::shared_ptr<DBus::CallMessage> slow_call =
+        DBus::CallMessage::create( server->unique_name(), "/dbuscxx/async", "dbuscxx.timeout", "slow" );
+    slow_call << int32_t( 1 );
+
+    std::promise<bool> timed_out;
+    std::shared_ptr<DBus::PendingCall> slow_pending = client->send_with_reply_async( slow_call, 100,
+        [&timed_out]( std::shared_ptr<DBus::PendingCall> reply ) {
+            try {
+                reply->return_message();
+                timed_out.set_value( false );
+            } catch( DBus::ErrorNoReply& ) {
+                timed_out.set_value( true );
+            }
+        } );
+    std::future<bool> timed_out_future = timed_out.get_future();
+
+    TEST_ASSERT_RET_FAIL( timed_out_future.wait_for( std::chrono::milliseconds( 400 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( timed_out_future.get() );
+
+    // A canceled call still completes, but doesn't call back
+    bool called = false;
+    std::shared_ptr<DBus::PendingCall> canceled = client->send_with_reply_async( call, -1,
+        [&called]( std::shared_ptr<DBus::PendingCall> ) {
+            called = true;
+        } );
+    canceled->cancel();
+    canceled->block();
+    TEST_ASSERT_RET_FAIL( !called );
+
+    return true;
+}
+
+static std::vector<std::shared_ptr<const DBus::CallMessage>> make_add_calls( std::shared_ptr<DBus::Connection> server, int count ) {
+    std::vector<std::shared_ptr<const DBus::CallMessage>> calls;
+
+    for( int x = 0; x < count; x++ ) {
+        std::shared_ptr<DBus::CallMessage> call =
+            DBus::CallMessage::create( server->unique_name(), "/dbuscxx/batch", "Calculator.Basic", "add" );
+        call << double( x ) << 1.0;
+        calls.push_back( call );
+    }
+
+    return calls;
+}
+
+static bool check_add_replies( const std::vector<std::shared_ptr<DBus::Message>>& replies, int count ) {
+    TEST_EQUALS_RET_FAIL( replies.size(), static_cast<size_t>( count ) );
+
+    for( int x = 0; x < count; x++ ) {
+        double value = 0;
+        TEST_ASSERT_RET_FAIL( replies[ x ] && replies[ x ]->type() == DBus::MessageType::RETURN );
+        std::static_pointer_cast<DBus::ReturnMessage>( replies[ x ] ) >> value;
+        TEST_EQUALS_RET_FAIL( value, x + 1 );
+    }
+
+    return true;
+}
+
+bool connection_call_batch() {
+    std::shared_ptr<DBus::Dispatcher> server_dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> server = server_dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> caller = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/batch", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<double( double, double )>( "Calculator.Basic", "add", sigc::ptr_fun( add ) );
+
+    // Replies come back in order, and a failed call doesn't fail the others
+    std::vector<std::shared_ptr<const DBus::CallMessage>> calls = make_add_calls( server, 1000 );
+    calls.push_back( DBus::CallMessage::create( server->unique_name(), "/dbuscxx/batch", "Calculator.Basic", "missing" ) );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = client->create_object_proxy( server->unique_name(), "/dbuscxx/batch" );
+    std::vector<std::shared_ptr<DBus::Message>> replies = proxy->call_batch( calls );
+
+    TEST_ASSERT_RET_FAIL( replies.back() && replies.back()->type() == DBus::MessageType::ERROR );
+    replies.pop_back();
+    TEST_ASSERT_RET_FAIL( check_add_replies( replies, 1000 ) );
+
+    // From the dispatching thread, the replies are read right there
+    std::shared_ptr<DBus::Object> batcher = client->create_object( "/dbuscxx/batcher", DBus::ThreadForCalling::DispatcherThread );
+    batcher->create_method<bool( int32_t )>( "dbuscxx.batch", "batch",
+        sigc::slot<bool( int32_t )>( [client, server]( int32_t count ) {
+            return check_add_replies( client->send_with_reply_batch( make_add_calls( server, count ) ), count );
+        } ) );
+
+    std::shared_ptr<DBus::CallMessage> batch_call =
+        DBus::CallMessage::create( client->unique_name(), "/dbuscxx/batcher", "dbuscxx.batch", "batch" );
+    batch_call << int32_t( 500 );
+    bool batch_ok = false;
+    caller->send_with_reply_blocking( batch_call ) >> batch_ok;
+    TEST_ASSERT_RET_FAIL( batch_ok );
+
+    return true;
+}
+
+bool connection_blocking_call_flood() {
+    // The server and the flood get their own threads, so that they don't hold up the client
+    std::shared_ptr<DBus::Dispatcher> server_dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Dispatcher> flood_dispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> server = server_dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> flooder = flood_dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> caller = dispatch->create_connection( DBus::BusType::SESSION );
+    std::atomic<int> received( 0 );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/flood", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<double( double, double )>( "Calculator.Basic", "add", sigc::ptr_fun( add ) );
+    object->create_method<int32_t( int32_t )>( "dbuscxx.timeout", "slow", sigc::ptr_fun( slow_reply ) );
+
+    std::shared_ptr<DBus::SignalProxy<void( int32_t )>> flood_proxy = client->create_free_signal_proxy<void( int32_t )>(
+                DBus::MatchRuleBuilder::create()
+                .set_interface( "dbuscxx.flood" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+    flood_proxy->connect( [&received]( int32_t ) {
+        received++;
+    } );
+
+    // Blocking calls made from the dispatching thread, while the signals are flooding in
+    std::shared_ptr<DBus::Object> blocker = client->create_object( "/dbuscxx/blocker", DBus::ThreadForCalling::DispatcherThread );
+    blocker->create_method<bool()>( "dbuscxx.blocker", "timed_out",
+        sigc::slot<bool()>( [client, server]() {
+            std::shared_ptr<DBus::CallMessage> slow_call =
+                DBus::CallMessage::create( server->unique_name(), "/dbuscxx/flood", "dbuscxx.timeout", "slow" );
+            slow_call << int32_t( 1 );
+
+            try {
+                client->send_with_reply_blocking( slow_call, 100 );
+            } catch( DBus::ErrorNoReply& ) {
+                return true;
+            }
+
+            return false;
+        } ) );
+    blocker->create_method<double()>( "dbuscxx.blocker", "add",
+        sigc::slot<double()>( [client, server]() {
+            std::shared_ptr<DBus::CallMessage> add_call =
+                DBus::CallMessage::create( server->unique_name(), "/dbuscxx/flood", "Calculator.Basic", "add" );
+            add_call << 2.0 << 5.0;
+            double value = 0;
+            client->send_with_reply_blocking( add_call ) >> value;
+            return value;
+        } ) );
+
+    std::atomic<bool> flooding( true );
+    std::atomic<int> sent( 0 );
+    std::thread flood_thread( [flooder, &flooding, &sent]() {
+        std::shared_ptr<DBus::Signal<void( int32_t )>> signal =
+            flooder->create_free_signal<void( int32_t )>( "/dbuscxx/flood", "dbuscxx.flood", "Flood" );
+
+        while( flooding ) {
+            signal->emit( sent++ );
+            std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+        }
+    } );
+
+    // Make sure that the flood is going before we make the calls
+    for( int x = 0; x < 500 && received == 0; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    bool timed_out = false;
+    double sum = 0;
+    caller->send_with_reply_blocking(
+        DBus::CallMessage::create( client->unique_name(), "/dbuscxx/blocker", "dbuscxx.blocker", "timed_out" ) ) >> timed_out;
+    caller->send_with_reply_blocking(
+        DBus::CallMessage::create( client->unique_name(), "/dbuscxx/blocker", "dbuscxx.blocker", "add" ) ) >> sum;
+
+    flooding = false;
+    flood_thread.join();
+
+    // The flood can't keep the call from timing out, or hide the reply to the next one
+    TEST_ASSERT_RET_FAIL( timed_out );
+    TEST_EQUALS_RET_FAIL( sum, 7 );
+
+    // The signals that came in during the calls were kept, not lost
+    for( int x = 0; x < 500 && received != sent; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( received, sent );
+
+    return true;
+}
+
+bool connection_match_rules() {
+    std::shared_ptr<DBus::Connection> server = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<DBus::SignalProxy<void( int32_t )>>> proxies;
+    std::atomic<int> received( 0 );
+
+    // None of these wait on the bus
+    for( int x = 0; x < 500; x++ ) {
+        std::shared_ptr<DBus::SignalProxy<void( int32_t )>> proxy = client->create_free_signal_proxy<void( int32_t )>(
+                    DBus::MatchRuleBuilder::create()
+                    .set_interface( "dbuscxx.match" )
+                    .set_member( "Member" + std::to_string( x % 250 ) )
+                    .as_signal_match(),
+                    DBus::ThreadForCalling::DispatcherThread );
+        proxy->connect( [&received]( int32_t ) {
+            received++;
+        } );
+        proxies.push_back( proxy );
+    }
+
+    // Each rule is in use twice; dropping one use must leave the rule with the bus
+    for( int x = 0; x < 250; x++ ) {
+        TEST_ASSERT_RET_FAIL( client->remove_free_signal_proxy( proxies[ x ] ) );
+    }
+
+    TEST_ASSERT_RET_FAIL( !client->remove_match( "type='signal',interface='dbuscxx.unused'" ) );
+
+    // The bus handles our calls in order, so once this is back the rules are in
+    client->name_has_owner( server->unique_name() );
+
+    server->create_free_signal<void( int32_t )>( "/dbuscxx/match", "dbuscxx.match", "Member249" )->emit( 1 );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    TEST_EQUALS_RET_FAIL( received, 1 );
+
+    // Errors from the bus come back later
+    std::shared_ptr<std::promise<std::string>> bad_rule = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> bad_rule_future = bad_rule->get_future();
+    client->signal_match_rule_error().connect( [bad_rule]( std::string rule, std::string ) {
+        bad_rule->set_value( rule );
+    } );
+
+    client->add_match_nonblocking( "type='bogus'" );
+    TEST_ASSERT_RET_FAIL( bad_rule_future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_EQUALS_RET_FAIL( bad_rule_future.get(), "type='bogus'" );
+
+    TEST_ASSERT_RET_FAIL( !client->add_match( "type='alsobogus'" ) );
+
+    // A refused rule is not remembered, so the bus is asked again
+    TEST_ASSERT_RET_FAIL( !client->add_match( "type='alsobogus'" ) );
+    TEST_ASSERT_RET_FAIL( !client->remove_match( "type='alsobogus'" ) );
+
+    // Somebody adding a rule that is still on its way waits for the bus to answer
+    std::string pending_rule = "type='signal',interface='dbuscxx.match',member='Pending'";
+    client->add_match_nonblocking( pending_rule );
+    TEST_ASSERT_RET_FAIL( client->add_match( pending_rule ) );
+
+    return true;
+}
+
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
             ret = connection_##name();\
         } \
@@ -133,6 +702,18 @@ int main( int argc, char** argv ) {
     ADD_TEST( get_signal_proxy_by_iface_and_name );
     ADD_TEST( create_void_signal );
     ADD_TEST( create_int_signal );
+    ADD_TEST( async_connect );
+    ADD_TEST( async_connect_hung_daemon );
+    ADD_TEST( async_connect_bad_address );
+    ADD_TEST( dispatch_all );
+    ADD_TEST( many_connections );
+    ADD_TEST( concurrent_send );
+    ADD_TEST( reply_timeout );
+    ADD_TEST( call_async_many );
+    ADD_TEST( call_async_callback );
+    ADD_TEST( call_batch );
+    ADD_TEST( blocking_call_flood );
+    ADD_TEST( match_rules );
 
     return !ret;
 }
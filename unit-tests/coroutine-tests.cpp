@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+
+#include "test_macros.h"
+
+static std::shared_ptr<DBus::Dispatcher> dispatch;
+static std::shared_ptr<DBus::Connection> server;
+static std::shared_ptr<DBus::Connection> client;
+static std::shared_ptr<DBus::ObjectProxy> proxy;
+
+/**
+ * A coroutine that nobody waits on; the tests wait on a std::promise instead.
+ */
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return DetachedTask(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct CallResult {
+    double sum = 0;
+    bool void_returned = false;
+    std::thread::id resumed_on;
+};
+
+static double add( double a, double b ) {
+    return a + b;
+}
+
+static void nothing( int32_t ) {}
+
+static DetachedTask call_add( std::shared_ptr<std::promise<CallResult>> result ) {
+    std::shared_ptr<DBus::MethodProxy<double( double, double )>> add_proxy =
+        proxy->create_method<double( double, double )>( "dbuscxx.coroutine", "add" );
+    std::shared_ptr<DBus::MethodProxy<void( int32_t )>> nothing_proxy =
+        proxy->create_method<void( int32_t )>( "dbuscxx.coroutine", "nothing" );
+    CallResult ret;
+
+    ret.sum = co_await add_proxy->co_call( 4.5, 3.25 );
+    co_await nothing_proxy->co_call( 5 );
+    ret.void_returned = true;
+    ret.resumed_on = std::this_thread::get_id();
+
+    result->set_value( ret );
+}
+
+static DetachedTask call_missing( std::shared_ptr<std::promise<std::string>> result ) {
+    std::shared_ptr<DBus::MethodProxy<int32_t()>> missing_proxy =
+        proxy->create_method<int32_t()>( "dbuscxx.coroutine", "missing" );
+
+    try {
+        co_await missing_proxy->co_call();
+        result->set_value( "" );
+    } catch( const DBus::Error& err ) {
+        result->set_value( err.name() );
+    }
+}
+
+static DetachedTask call_on_pool( std::shared_ptr<DBus::CallPool> pool,
+    std::shared_ptr<std::promise<std::thread::id>> result ) {
+    std::shared_ptr<DBus::MethodProxy<double( double, double )>> add_proxy =
+        proxy->create_method<double( double, double )>( "dbuscxx.coroutine", "add" );
+
+    co_await add_proxy->co_call( 1, 2 ).resume_on( pool );
+
+    result->set_value( std::this_thread::get_id() );
+}
+
+static DetachedTask get_property( std::shared_ptr<DBus::PropertyProxy<int32_t>> prop,
+    std::shared_ptr<std::promise<int32_t>> result ) {
+    int32_t first = co_await prop->co_value();
+    DBus::Variant second = co_await prop->co_variant_value();
+
+    result->set_value( first == second.to_int32() ? first : -1 );
+}
+
+bool coroutine_method() {
+    std::shared_ptr<std::promise<CallResult>> result = std::make_shared<std::promise<CallResult>>();
+    std::future<CallResult> future = result->get_future();
+
+    call_add( result );
+
+    TEST_ASSERT_RET_FAIL( future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    CallResult ret = future.get();
+    TEST_EQUALS_RET_FAIL( ret.sum, 7.75 );
+    TEST_ASSERT_RET_FAIL( ret.void_returned );
+    // By default, the coroutine carries on on the dispatching thread
+    TEST_ASSERT_RET_FAIL( ret.resumed_on != std::this_thread::get_id() );
+
+    return true;
+}
+
+bool coroutine_error() {
+    std::shared_ptr<std::promise<std::string>> result = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = result->get_future();
+
+    call_missing( result );
+
+    TEST_ASSERT_RET_FAIL( future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_EQUALS_RET_FAIL( future.get(), std::string( DBUSCXX_ERROR_UNKNOWN_METHOD ) );
+
+    return true;
+}
+
+bool coroutine_resume_on() {
+    std::shared_ptr<DBus::CallPool> pool = DBus::CallPool::create( 1 );
+    std::shared_ptr<std::promise<std::thread::id>> pool_thread = std::make_shared<std::promise<std::thread::id>>();
+    std::shared_ptr<std::promise<std::thread::id>> result = std::make_shared<std::promise<std::thread::id>>();
+    std::future<std::thread::id> future = result->get_future();
+
+    pool->submit( [pool_thread]() {
+        pool_thread->set_value( std::this_thread::get_id() );
+    } );
+
+    call_on_pool( pool, result );
+
+    TEST_ASSERT_RET_FAIL( future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( future.get() == pool_thread->get_future().get() );
+
+    return true;
+}
+
+bool coroutine_property() {
+    std::shared_ptr<DBus::PropertyProxy<int32_t>> prop =
+        proxy->create_property<int32_t>( "dbuscxx.coroutine", "intproperty" );
+    std::shared_ptr<std::promise<int32_t>> result = std::make_shared<std::promise<int32_t>>();
+    std::future<int32_t> future = result->get_future();
+
+    get_property( prop, result );
+
+    TEST_ASSERT_RET_FAIL( future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_EQUALS_RET_FAIL( future.get(), 9834 );
+
+    // Now that the value is known, there is nothing left to ask for
+    TEST_ASSERT_RET_FAIL( !prop->variant_value_async() );
+
+    return true;
+}
+
+bool coroutine_property_destroyed() {
+    std::shared_ptr<DBus::PropertyProxy<int32_t>> prop =
+        proxy->create_property<int32_t>( "dbuscxx.coroutine", "intproperty" );
+    std::shared_ptr<std::promise<bool>> result = std::make_shared<std::promise<bool>>();
+    std::future<bool> future = result->get_future();
+
+    TEST_ASSERT_RET_FAIL( prop->variant_value_async( [result]( std::shared_ptr<DBus::PendingCall> call ) {
+        result->set_value( call->reply()->type() == DBus::MessageType::RETURN );
+    } ) );
+
+    // Nobody is left to take the value when the reply comes in
+    proxy->interface_by_name( "dbuscxx.coroutine" )->remove_property( prop );
+    prop.reset();
+
+    TEST_ASSERT_RET_FAIL( future.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( future.get() );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = coroutine_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+
+    dispatch = DBus::StandaloneDispatcher::create();
+    server = dispatch->create_connection( DBus::BusType::SESSION );
+    client = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/coroutine", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<double( double, double )>( "dbuscxx.coroutine", "add", sigc::ptr_fun( add ) );
+    object->create_method<void( int32_t )>( "dbuscxx.coroutine", "nothing", sigc::ptr_fun( nothing ) );
+    object->create_property<int32_t>( "dbuscxx.coroutine", "intproperty" )->set_value( 9834 );
+
+    proxy = client->create_object_proxy( server->unique_name(), "/dbuscxx/coroutine" );
+
+    ADD_TEST( method );
+    ADD_TEST( error );
+    ADD_TEST( resume_on );
+    ADD_TEST( property );
+    ADD_TEST( property_destroyed );
+
+    return !ret;
+}
@@ -0,0 +1,22 @@
+#!/bin/sh
+
+# Peer-to-peer tests don't need a bus daemon at all: start up the server
+# side and then run the client against it directly.
+export PATH=$PATH:$(pwd)
+
+./test-peer server $1 &
+SERVER_PID=$!
+sleep .1
+./test-peer client $1
+# get the exit code 
+EXIT_CODE=$?
+
+# wait for server to be done
+wait $SERVER_PID
+SERVER_EXIT_CODE=$?
+
+if [ $EXIT_CODE -eq 0 ]; then
+    EXIT_CODE=$SERVER_EXIT_CODE
+fi
+
+exit $EXIT_CODE
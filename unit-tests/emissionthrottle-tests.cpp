@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx/emissionthrottle.h>
+#include <iostream>
+#include <string>
+
+#include "test_macros.h"
+
+using DBus::priv::EmissionThrottle;
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+bool emissionthrottle_immediate() {
+    EmissionThrottle throttle;
+    TimePoint now = std::chrono::steady_clock::now();
+    TimePoint flush_at;
+
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now, flush_at ) == EmissionThrottle::Action::Send );
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now, flush_at ) == EmissionThrottle::Action::Send );
+    TEST_ASSERT_RET_FAIL( !throttle.is_holding() );
+
+    return true;
+}
+
+bool emissionthrottle_coalesce() {
+    EmissionThrottle throttle;
+    TimePoint now = std::chrono::steady_clock::now();
+    TimePoint flush_at;
+
+    throttle.set_policy( DBus::EmissionMode::Coalesce, std::chrono::milliseconds( 50 ) );
+
+    // The first emission opens the window, and the rest land in it
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now, flush_at ) == EmissionThrottle::Action::HoldAndSchedule );
+    TEST_ASSERT_RET_FAIL( flush_at == now + std::chrono::milliseconds( 50 ) );
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now + std::chrono::milliseconds( 10 ), flush_at ) == EmissionThrottle::Action::Hold );
+    TEST_ASSERT_RET_FAIL( throttle.is_holding() );
+
+    throttle.flushed( now + std::chrono::milliseconds( 50 ) );
+    TEST_ASSERT_RET_FAIL( !throttle.is_holding() );
+
+    // A new window opens with the next emission
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now + std::chrono::milliseconds( 500 ), flush_at ) == EmissionThrottle::Action::HoldAndSchedule );
+    TEST_ASSERT_RET_FAIL( flush_at == now + std::chrono::milliseconds( 550 ) );
+
+    return true;
+}
+
+bool emissionthrottle_rate_limit() {
+    EmissionThrottle throttle;
+    TimePoint now = std::chrono::steady_clock::now();
+    TimePoint flush_at;
+
+    throttle.set_policy( DBus::EmissionMode::RateLimit, std::chrono::milliseconds( 50 ) );
+
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now, flush_at ) == EmissionThrottle::Action::Send );
+
+    // Too soon: held until the interval is up
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now + std::chrono::milliseconds( 10 ), flush_at ) == EmissionThrottle::Action::HoldAndSchedule );
+    TEST_ASSERT_RET_FAIL( flush_at == now + std::chrono::milliseconds( 50 ) );
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now + std::chrono::milliseconds( 20 ), flush_at ) == EmissionThrottle::Action::Hold );
+
+    throttle.flushed( now + std::chrono::milliseconds( 50 ) );
+
+    // The flush counts as a send
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now + std::chrono::milliseconds( 60 ), flush_at ) == EmissionThrottle::Action::HoldAndSchedule );
+    TEST_ASSERT_RET_FAIL( flush_at == now + std::chrono::milliseconds( 100 ) );
+    throttle.flushed( now + std::chrono::milliseconds( 100 ) );
+
+    TEST_ASSERT_RET_FAIL( throttle.emitted( now + std::chrono::milliseconds( 200 ), flush_at ) == EmissionThrottle::Action::Send );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = emissionthrottle_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( immediate );
+    ADD_TEST( coalesce );
+    ADD_TEST( rate_limit );
+
+    return !ret;
+}
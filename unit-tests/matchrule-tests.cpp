@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "test_macros.h"
+
+static std::shared_ptr<DBus::SignalMessage> make_signal( const std::string& path ) {
+    return DBus::SignalMessage::create( path, "test.matchrule", "Member" );
+}
+
+bool matchrule_string() {
+    DBus::SignalMatchRule rule = DBus::MatchRuleBuilder::create()
+        .set_path_namespace( "/test" )
+        .set_interface( "test.matchrule" )
+        .set_arg( 2, "it's" )
+        .set_arg( 0, "first" )
+        .set_arg_path( 1, "/test/" )
+        .set_arg0_namespace( "com.example" )
+        .set_eavesdrop( true )
+        .as_signal_match();
+
+    TEST_EQUALS_RET_FAIL( rule.match_rule(),
+        std::string( "type='signal',interface='test.matchrule',path_namespace='/test',"
+                     "arg0='first',arg2='it'\\''s',arg1path='/test/',"
+                     "arg0namespace='com.example',eavesdrop='true'" ) );
+
+    // Copying the rule into a new builder leaves the original alone
+    DBus::SignalMatchRule copy = DBus::MatchRuleBuilder::create( rule )
+        .set_member( "Member" )
+        .as_signal_match();
+
+    TEST_EQUALS_RET_FAIL( rule.member(), std::string() );
+    TEST_EQUALS_RET_FAIL( copy.member(), std::string( "Member" ) );
+    TEST_EQUALS_RET_FAIL( copy.args().size(), 2u );
+
+    return true;
+}
+
+bool matchrule_invalid() {
+    try {
+        DBus::MatchRuleBuilder::create().set_arg( 64, "value" );
+        return false;
+    } catch( const DBus::ErrorMatchRuleInvalid& ) {}
+
+    try {
+        DBus::MatchRuleBuilder::create()
+            .set_path( "/test" )
+            .set_path_namespace( "/test" )
+            .as_signal_match();
+        return false;
+    } catch( const DBus::ErrorMatchRuleInvalid& ) {}
+
+    return true;
+}
+
+bool matchrule_path_namespace() {
+    DBus::SignalMatchRule rule = DBus::MatchRuleBuilder::create()
+        .set_path_namespace( "/test/obj" )
+        .as_signal_match();
+    DBus::SignalMatchRule root = DBus::MatchRuleBuilder::create()
+        .set_path_namespace( "/" )
+        .as_signal_match();
+
+    TEST_ASSERT_RET_FAIL( rule.matches_path_namespace( "/test/obj" ) );
+    TEST_ASSERT_RET_FAIL( rule.matches_path_namespace( "/test/obj/child" ) );
+    TEST_ASSERT_RET_FAIL( !rule.matches_path_namespace( "/test/object" ) );
+    TEST_ASSERT_RET_FAIL( !rule.matches_path_namespace( "/test" ) );
+    TEST_ASSERT_RET_FAIL( root.matches_path_namespace( "/anything/at/all" ) );
+
+    return true;
+}
+
+bool matchrule_args() {
+    DBus::SignalMatchRule rule = DBus::MatchRuleBuilder::create()
+        .set_arg( 0, "first" )
+        .set_arg( 2, "third" )
+        .as_signal_match();
+
+    std::shared_ptr<DBus::SignalMessage> match = make_signal( "/test" );
+    match << std::string( "first" ) << int32_t( 5 ) << std::string( "third" );
+    TEST_ASSERT_RET_FAIL( rule.matches_arguments( match ) );
+
+    std::shared_ptr<DBus::SignalMessage> wrong = make_signal( "/test" );
+    wrong << std::string( "first" ) << int32_t( 5 ) << std::string( "other" );
+    TEST_ASSERT_RET_FAIL( !rule.matches_arguments( wrong ) );
+
+    std::shared_ptr<DBus::SignalMessage> missing = make_signal( "/test" );
+    missing << std::string( "first" );
+    TEST_ASSERT_RET_FAIL( !rule.matches_arguments( missing ) );
+
+    // argN only matches strings, not object paths
+    std::shared_ptr<DBus::SignalMessage> path = make_signal( "/test" );
+    path << DBus::Path( "/first" );
+    TEST_ASSERT_RET_FAIL( !DBus::MatchRuleBuilder::create()
+        .set_arg( 0, "/first" )
+        .as_signal_match()
+        .matches_arguments( path ) );
+
+    return true;
+}
+
+bool matchrule_arg_path() {
+    DBus::SignalMatchRule rule = DBus::MatchRuleBuilder::create()
+        .set_arg_path( 0, "/aa/bb/" )
+        .as_signal_match();
+    std::vector<std::string> matching = { "/", "/aa/", "/aa/bb/", "/aa/bb/cc/", "/aa/bb/cc" };
+    std::vector<std::string> not_matching = { "/aa/b", "/aa", "/aa/bb" };
+
+    for( const std::string& value : matching ) {
+        std::shared_ptr<DBus::SignalMessage> msg = make_signal( "/test" );
+        msg << DBus::Path( value );
+        TEST_ASSERT_RET_FAIL( rule.matches_arguments( msg ) );
+    }
+
+    for( const std::string& value : not_matching ) {
+        std::shared_ptr<DBus::SignalMessage> msg = make_signal( "/test" );
+        msg << value;
+        TEST_ASSERT_RET_FAIL( !rule.matches_arguments( msg ) );
+    }
+
+    return true;
+}
+
+bool matchrule_arg0_namespace() {
+    DBus::SignalMatchRule rule = DBus::MatchRuleBuilder::create()
+        .set_arg0_namespace( "com.example.backend1" )
+        .as_signal_match();
+
+    std::shared_ptr<DBus::SignalMessage> exact = make_signal( "/test" );
+    exact << std::string( "com.example.backend1" );
+    TEST_ASSERT_RET_FAIL( rule.matches_arguments( exact ) );
+
+    std::shared_ptr<DBus::SignalMessage> child = make_signal( "/test" );
+    child << std::string( "com.example.backend1.foo.bar" );
+    TEST_ASSERT_RET_FAIL( rule.matches_arguments( child ) );
+
+    std::shared_ptr<DBus::SignalMessage> other = make_signal( "/test" );
+    other << std::string( "com.example.backend2" );
+    TEST_ASSERT_RET_FAIL( !rule.matches_arguments( other ) );
+
+    std::shared_ptr<DBus::SignalMessage> prefix = make_signal( "/test" );
+    prefix << std::string( "com.example.backend1foo" );
+    TEST_ASSERT_RET_FAIL( !rule.matches_arguments( prefix ) );
+
+    return true;
+}
+
+bool matchrule_after_container() {
+    DBus::SignalMatchRule rule = DBus::MatchRuleBuilder::create()
+        .set_arg( 2, "third" )
+        .as_signal_match();
+    std::vector<int32_t> container = { 1, 2, 3 };
+
+    // We can't see past the array, so we have to trust the bus
+    std::shared_ptr<DBus::SignalMessage> msg = make_signal( "/test" );
+    msg << std::string( "first" ) << container << std::string( "other" );
+    TEST_ASSERT_RET_FAIL( rule.matches_arguments( msg ) );
+
+    // ...but the array itself can never match
+    std::shared_ptr<DBus::SignalMessage> array = make_signal( "/test" );
+    array << container;
+    TEST_ASSERT_RET_FAIL( !DBus::MatchRuleBuilder::create()
+        .set_arg( 0, "first" )
+        .as_signal_match()
+        .matches_arguments( array ) );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = matchrule_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+
+    ADD_TEST( string );
+    ADD_TEST( invalid );
+    ADD_TEST( path_namespace );
+    ADD_TEST( args );
+    ADD_TEST( arg_path );
+    ADD_TEST( arg0_namespace );
+    ADD_TEST( after_container );
+
+    return !ret;
+}
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <unistd.h>
+#include <iostream>
+#include <thread>
+
+#include "test_macros.h"
+
+static std::shared_ptr<DBus::Dispatcher> dispatch;
+static std::shared_ptr<DBus::Connection> conn;
+
+// Client variables
+static std::shared_ptr<DBus::ObjectProxy> proxy;
+static std::shared_ptr<DBus::MethodProxy<int( int, int )>> add_proxy;
+static std::shared_ptr<DBus::MethodProxy<void()>> emit_proxy;
+static std::shared_ptr<DBus::MethodProxy<uint64_t( std::shared_ptr<DBus::FileDescriptor> )>> checksum_proxy;
+static std::string signal_value;
+
+// Server variables
+static std::shared_ptr<DBus::Server> server;
+static std::shared_ptr<DBus::Object> object;
+static std::shared_ptr<DBus::Signal<void( std::string )>> server_signal;
+
+// Server Function
+int add( int a, int b ) {
+    return a + b;
+}
+
+// Server Function
+void emit_signal() {
+    server_signal->emit( "PeerSignal" );
+}
+
+// Server Function
+uint64_t checksum( std::shared_ptr<DBus::FileDescriptor> fd ) {
+    std::shared_ptr<DBus::MemfdBuffer> buffer = DBus::MemfdBuffer::create( fd );
+    uint64_t sum = 0;
+
+    close( fd->descriptor() );
+
+    if( !buffer->is_valid() ) {
+        return 0;
+    }
+
+    for( size_t x = 0; x < buffer->size(); x++ ) {
+        sum += buffer->data()[ x ];
+    }
+
+    return sum;
+}
+
+// Client Function
+void signal_handler( std::string value ) {
+    signal_value = value;
+}
+
+// Client Function
+bool peer_method_call() {
+    int result = ( *add_proxy )( 5, 6 );
+
+    TEST_EQUALS_RET_FAIL( result, 11 );
+    return true;
+}
+
+// Client Function
+bool peer_signal() {
+    std::shared_ptr<DBus::SignalProxy<void( std::string )>> signal_proxy =
+        conn->create_free_signal_proxy<void( std::string )>(
+            DBus::MatchRuleBuilder::create()
+            .set_path( "/peertest" )
+            .set_interface( "dbuscxx.peer" )
+            .set_member( "Signal" )
+            .as_signal_match(),
+            DBus::ThreadForCalling::DispatcherThread );
+
+    signal_proxy->connect( sigc::ptr_fun( signal_handler ) );
+
+    ( *emit_proxy )();
+
+    for( int x = 0; x < 100 && signal_value.empty(); x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    TEST_ASSERT_RET_FAIL( signal_value == "PeerSignal" );
+    return true;
+}
+
+// Client Function
+bool peer_no_bus() {
+    TEST_ASSERT_RET_FAIL( conn->is_peer() );
+    TEST_ASSERT_RET_FAIL( conn->is_registered() );
+    TEST_ASSERT_RET_FAIL( conn->unique_name().empty() );
+
+    // The peer sends us everything, so match rules always succeed
+    TEST_ASSERT_RET_FAIL( conn->add_match( "type='signal',interface='dbuscxx.peer'" ) );
+
+    try {
+        conn->request_name( "dbuscxx.peer" );
+    } catch( DBus::ErrorNotSupported& ) {
+        return true;
+    }
+
+    return false;
+}
+
+// Client Function
+bool peer_memfd() {
+    std::vector<uint8_t> payload( 4 * 1024 * 1024 );
+    uint64_t expected = 0;
+
+    for( size_t x = 0; x < payload.size(); x++ ) {
+        payload[ x ] = x % 251;
+        expected += payload[ x ];
+    }
+
+    std::shared_ptr<DBus::MemfdBuffer> buffer = DBus::MemfdBuffer::create( payload );
+    TEST_ASSERT_RET_FAIL( buffer->is_valid() );
+    TEST_EQUALS_RET_FAIL( buffer->size(), payload.size() );
+
+    uint64_t result = ( *checksum_proxy )( buffer->filedescriptor() );
+
+    TEST_EQUALS_RET_FAIL( result, expected );
+    return true;
+}
+
+bool client_setup( std::string address ) {
+    conn = DBus::Connection::create_peer( address );
+
+    if( !conn->is_valid() ) {
+        std::cerr << "Unable to connect to " << address << std::endl;
+        return false;
+    }
+
+    dispatch->add_connection( conn );
+
+    // Give the server a chance to export its object before we call it
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+    proxy = conn->create_object_proxy( "/peertest" );
+    add_proxy = proxy->create_method<int( int, int )>( "dbuscxx.peer", "add" );
+    emit_proxy = proxy->create_method<void()>( "dbuscxx.peer", "emit_signal" );
+    checksum_proxy = proxy->create_method<uint64_t( std::shared_ptr<DBus::FileDescriptor> )>( "dbuscxx.peer", "checksum" );
+
+    return true;
+}
+
+bool server_run( std::string address ) {
+    server = DBus::Server::create( address );
+
+    if( !server->is_valid() ) {
+        std::cerr << "Unable to listen on " << address << std::endl;
+        return false;
+    }
+
+    conn = server->accept( 5000 );
+
+    if( !conn ) {
+        std::cerr << "No client connected" << std::endl;
+        return false;
+    }
+
+    dispatch->add_connection( conn );
+
+    object = conn->create_object( "/peertest", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<int( int, int )>( "dbuscxx.peer", "add", sigc::ptr_fun( add ) );
+    object->create_method<void()>( "dbuscxx.peer", "emit_signal", sigc::ptr_fun( emit_signal ) );
+    object->create_method<uint64_t( std::shared_ptr<DBus::FileDescriptor> )>( "dbuscxx.peer", "checksum", sigc::ptr_fun( checksum ) );
+    server_signal = conn->create_free_signal<void( std::string )>( "/peertest", "dbuscxx.peer", "Signal" );
+
+    sleep( 1 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = peer_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 3 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[2];
+    std::string address = "unix:abstract=dbuscxx-peer-test-" + test_name;
+    bool ret = false;
+    bool is_client = std::string( argv[1] ) == "client";
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+    dispatch = DBus::StandaloneDispatcher::create();
+
+    if( is_client ) {
+        if( client_setup( address ) ) {
+            ADD_TEST( method_call );
+            ADD_TEST( signal );
+            ADD_TEST( no_bus );
+            ADD_TEST( memfd );
+        }
+    } else {
+        ret = server_run( address );
+    }
+
+    return !ret;
+}
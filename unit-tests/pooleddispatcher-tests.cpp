@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <sched.h>
+
+#include "test_macros.h"
+
+static uint64_t current_thread() {
+    return std::hash<std::thread::id>()( std::this_thread::get_id() );
+}
+
+static int32_t current_cpu() {
+    return sched_getcpu();
+}
+
+/**
+ * Export an object on each connection that tells us which thread it was called on,
+ * and call it once from the client for every connection.
+ */
+static std::vector<uint64_t> call_each( std::shared_ptr<DBus::Connection> client,
+    std::vector<std::shared_ptr<DBus::Connection>>& servers ) {
+    std::vector<uint64_t> threads;
+
+    for( std::shared_ptr<DBus::Connection> server : servers ) {
+        std::shared_ptr<DBus::ObjectProxy> proxy =
+            client->create_object_proxy( server->unique_name(), "/dbuscxx/pool" );
+        DBus::MethodProxy<uint64_t()>& thread_proxy =
+            *( proxy->create_method<uint64_t()>( "dbuscxx.pool", "thread" ) );
+
+        threads.push_back( thread_proxy() );
+    }
+
+    return threads;
+}
+
+bool pool_spread() {
+    std::shared_ptr<DBus::PooledDispatcher> pool = DBus::PooledDispatcher::create( 4 );
+    std::shared_ptr<DBus::Connection> client = pool->create_connection( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<DBus::Connection>> servers;
+    std::vector<std::shared_ptr<DBus::Object>> objects;
+
+    TEST_EQUALS_RET_FAIL( pool->num_threads(), 4 );
+
+    for( int x = 0; x < 8; x++ ) {
+        std::shared_ptr<DBus::Connection> server = pool->create_connection( DBus::BusType::SESSION );
+        std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/pool", DBus::ThreadForCalling::DispatcherThread );
+        object->create_method<uint64_t()>( "dbuscxx.pool", "thread", sigc::ptr_fun( current_thread ) );
+
+        servers.push_back( server );
+        objects.push_back( object );
+    }
+
+    std::vector<uint64_t> first = call_each( client, servers );
+    std::set<uint64_t> distinct( first.begin(), first.end() );
+
+    // Every thread got some of the connections
+    TEST_EQUALS_RET_FAIL( distinct.size(), 4 );
+
+    // And each connection stays on the thread that it was given
+    for( int x = 0; x < 3; x++ ) {
+        TEST_ASSERT_RET_FAIL( call_each( client, servers ) == first );
+    }
+
+    return true;
+}
+
+bool pool_cpu_affinity() {
+    std::shared_ptr<DBus::PooledDispatcher> pool = DBus::PooledDispatcher::create( 2, false );
+    cpu_set_t allowed;
+    int cpu = 0;
+
+    // We may not be allowed to run on every CPU, so pick the last one that we can run on
+    TEST_ASSERT_RET_FAIL( sched_getaffinity( 0, sizeof( allowed ), &allowed ) == 0 );
+
+    for( int x = 0; x < CPU_SETSIZE; x++ ) {
+        if( CPU_ISSET( x, &allowed ) ) {
+            cpu = x;
+        }
+    }
+
+    TEST_ASSERT_RET_FAIL( pool->set_cpu_affinity( { cpu } ) );
+    TEST_ASSERT_RET_FAIL( pool->start() );
+
+    std::shared_ptr<DBus::Connection> client = pool->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> server = pool->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/pool", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<int32_t()>( "dbuscxx.pool", "cpu", sigc::ptr_fun( current_cpu ) );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = client->create_object_proxy( server->unique_name(), "/dbuscxx/pool" );
+    DBus::MethodProxy<int32_t()>& cpu_proxy = *( proxy->create_method<int32_t()>( "dbuscxx.pool", "cpu" ) );
+
+    for( int x = 0; x < 5; x++ ) {
+        TEST_EQUALS_RET_FAIL( cpu_proxy(), cpu );
+    }
+
+    return true;
+}
+
+bool pool_connection_removed() {
+    std::shared_ptr<DBus::PooledDispatcher> pool = DBus::PooledDispatcher::create( 2 );
+    // Not on the pool, so that it doesn't take up one of the threads
+    std::shared_ptr<DBus::Connection> client = DBus::Connection::create( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<DBus::Connection>> servers;
+    std::vector<std::shared_ptr<DBus::Object>> objects;
+
+    // A server that never answers, so that connecting to it fails
+    std::shared_ptr<DBus::Server> hung = DBus::Server::create( "unix:abstract=dbuscxx-pool-hung" );
+    TEST_ASSERT_RET_FAIL( hung->is_valid() );
+    TEST_ASSERT_RET_FAIL( client->bus_register() );
+
+    for( int x = 0; x < 2; x++ ) {
+        std::shared_ptr<DBus::Connection> server = pool->create_connection( DBus::BusType::SESSION );
+        std::shared_ptr<DBus::Object> object = server->create_object( "/dbuscxx/pool", DBus::ThreadForCalling::DispatcherThread );
+        object->create_method<uint64_t()>( "dbuscxx.pool", "thread", sigc::ptr_fun( current_thread ) );
+
+        servers.push_back( server );
+        objects.push_back( object );
+
+        if( x == 1 ) { break; }
+
+        // The other thread gets this one, until it fails to connect
+        std::shared_ptr<DBus::Connection> failing = DBus::Connection::create_async( "unix:abstract=dbuscxx-pool-hung", 100 );
+        std::weak_ptr<DBus::Connection> weak_failing = failing;
+        TEST_ASSERT_RET_FAIL( pool->add_connection( failing ) );
+        failing.reset();
+
+        // Once it has failed, the pool lets go of it
+        for( int y = 0; y < 500 && !weak_failing.expired(); y++ ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        }
+
+        TEST_ASSERT_RET_FAIL( weak_failing.expired() );
+    }
+
+    // So the second server goes on the thread that the failed connection had
+    std::vector<uint64_t> threads = call_each( client, servers );
+    TEST_ASSERT_RET_FAIL( threads[ 0 ] != threads[ 1 ] );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = pool_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+
+    ADD_TEST( spread );
+    ADD_TEST( cpu_affinity );
+    ADD_TEST( connection_removed );
+
+    return !ret;
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <iostream>
+#include <string>
+
+#include "test_macros.h"
+
+static std::shared_ptr<DBus::SignalMessage> make_signal( const std::string& member, int32_t value ) {
+    std::shared_ptr<DBus::SignalMessage> msg = DBus::SignalMessage::create( "/test/queue", "test.queue", member );
+    msg << value;
+    return msg;
+}
+
+static int32_t value_of( std::shared_ptr<const DBus::SignalMessage> msg ) {
+    int32_t value = 0;
+    msg->begin() >> value;
+    return value;
+}
+
+bool signalqueue_unbounded() {
+    std::shared_ptr<DBus::SignalQueue> queue = DBus::SignalQueue::create();
+
+    for( int32_t x = 0; x < 100; x++ ) {
+        TEST_ASSERT_RET_FAIL( queue->push( make_signal( "Member", x ) ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( queue->size(), 100u );
+
+    for( int32_t x = 0; x < 100; x++ ) {
+        TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), x );
+    }
+
+    TEST_ASSERT_RET_FAIL( queue->empty() );
+    TEST_ASSERT_RET_FAIL( !queue->pop() );
+    TEST_EQUALS_RET_FAIL( queue->dropped(), 0u );
+
+    return true;
+}
+
+bool signalqueue_drop_oldest() {
+    std::shared_ptr<DBus::SignalQueue> queue = DBus::SignalQueue::create( 3, DBus::SignalOverflowPolicy::DropOldest );
+
+    for( int32_t x = 0; x < 5; x++ ) {
+        TEST_ASSERT_RET_FAIL( queue->push( make_signal( "Member", x ) ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( queue->size(), 3u );
+    TEST_EQUALS_RET_FAIL( queue->dropped(), 2u );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 2 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 3 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 4 );
+
+    return true;
+}
+
+bool signalqueue_drop_newest() {
+    std::shared_ptr<DBus::SignalQueue> queue = DBus::SignalQueue::create( 3, DBus::SignalOverflowPolicy::DropNewest );
+
+    for( int32_t x = 0; x < 5; x++ ) {
+        TEST_EQUALS_RET_FAIL( queue->push( make_signal( "Member", x ) ), ( x < 3 ) );
+    }
+
+    TEST_EQUALS_RET_FAIL( queue->dropped(), 2u );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 0 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 1 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 2 );
+
+    // Room again once the queue has been drained
+    TEST_ASSERT_RET_FAIL( queue->push( make_signal( "Member", 5 ) ) );
+
+    return true;
+}
+
+bool signalqueue_coalesce() {
+    std::shared_ptr<DBus::SignalQueue> queue = DBus::SignalQueue::create( 3, DBus::SignalOverflowPolicy::Coalesce );
+
+    queue->push( make_signal( "First", 1 ) );
+    queue->push( make_signal( "Second", 2 ) );
+    queue->push( make_signal( "First", 3 ) );
+
+    // The newest First takes the place of the last First in the queue
+    TEST_ASSERT_RET_FAIL( queue->push( make_signal( "First", 4 ) ) );
+    TEST_EQUALS_RET_FAIL( queue->size(), 3u );
+    TEST_EQUALS_RET_FAIL( queue->dropped(), 1u );
+
+    // Nothing to coalesce with, so the oldest signal goes
+    TEST_ASSERT_RET_FAIL( queue->push( make_signal( "Third", 5 ) ) );
+    TEST_EQUALS_RET_FAIL( queue->dropped(), 2u );
+
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 2 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 4 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 5 );
+
+    return true;
+}
+
+bool signalqueue_set_limit() {
+    std::shared_ptr<DBus::SignalQueue> queue = DBus::SignalQueue::create();
+
+    for( int32_t x = 0; x < 5; x++ ) {
+        queue->push( make_signal( x % 2 ? "Odd" : "Even", x ) );
+    }
+
+    queue->set_limit( 2, DBus::SignalOverflowPolicy::Coalesce );
+    TEST_EQUALS_RET_FAIL( queue->size(), 2u );
+    TEST_EQUALS_RET_FAIL( queue->dropped(), 3u );
+    TEST_ASSERT_RET_FAIL( queue->overflow_policy() == DBus::SignalOverflowPolicy::Coalesce );
+
+    // Signals that were queued before the policy changed still coalesce
+    queue->push( make_signal( "Odd", 5 ) );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 5 );
+    TEST_EQUALS_RET_FAIL( value_of( queue->pop() ), 4 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = signalqueue_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( unbounded );
+    ADD_TEST( drop_oldest );
+    ADD_TEST( drop_newest );
+    ADD_TEST( coalesce );
+    ADD_TEST( set_limit );
+
+    return !ret;
+}
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <dbus-cxx/signalroutingtable.h>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "test_macros.h"
+
+using DBus::priv::SignalRoutingTable;
+
+static std::shared_ptr<DBus::SignalProxyBase> make_proxy( const std::string& path,
+    const std::string& interface_name,
+    const std::string& member ) {
+    DBus::MatchRuleBuilder builder = DBus::MatchRuleBuilder::create();
+
+    if( !path.empty() ) { builder.set_path( path ); }
+    if( !interface_name.empty() ) { builder.set_interface( interface_name ); }
+    if( !member.empty() ) { builder.set_member( member ); }
+
+    return DBus::SignalProxy<void()>::create( builder.as_signal_match() );
+}
+
+static std::vector<std::shared_ptr<DBus::SignalProxyBase>> find( const SignalRoutingTable& table,
+    const std::string& path,
+    const std::string& interface_name,
+    const std::string& member ) {
+    std::vector<SignalRoutingTable::Route> routes;
+    std::vector<std::shared_ptr<DBus::SignalProxyBase>> found;
+    table.find( interface_name, member, path, routes );
+
+    for( SignalRoutingTable::Route& route : routes ) {
+        found.push_back( route.proxy );
+    }
+
+    return found;
+}
+
+bool signalroutingtable_exact() {
+    SignalRoutingTable table;
+    std::shared_ptr<DBus::SignalProxyBase> a = make_proxy( "/a", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> b = make_proxy( "/b", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> c = make_proxy( "/a", "dbuscxx.test", "Two" );
+    std::shared_ptr<DBus::SignalProxyBase> d = make_proxy( "/a", "dbuscxx.other", "One" );
+
+    table.add( a, std::this_thread::get_id() );
+    table.add( b, std::this_thread::get_id() );
+    table.add( c, std::this_thread::get_id() );
+    table.add( d, std::this_thread::get_id() );
+    TEST_EQUALS_RET_FAIL( table.size(), 4 );
+
+    std::vector<std::shared_ptr<DBus::SignalProxyBase>> found = find( table, "/a", "dbuscxx.test", "One" );
+    TEST_EQUALS_RET_FAIL( found.size(), 1 );
+    TEST_ASSERT_RET_FAIL( found[ 0 ] == a );
+
+    TEST_ASSERT_RET_FAIL( find( table, "/c", "dbuscxx.test", "One" ).empty() );
+    TEST_ASSERT_RET_FAIL( find( table, "/a", "dbuscxx.nothing", "One" ).empty() );
+
+    table.clear();
+    TEST_EQUALS_RET_FAIL( table.size(), 0 );
+    TEST_ASSERT_RET_FAIL( find( table, "/a", "dbuscxx.test", "One" ).empty() );
+
+    return true;
+}
+
+bool signalroutingtable_wildcards() {
+    SignalRoutingTable table;
+    std::shared_ptr<DBus::SignalProxyBase> any_path = make_proxy( "", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> any_member = make_proxy( "/a", "dbuscxx.test", "" );
+    std::shared_ptr<DBus::SignalProxyBase> any_interface = make_proxy( "/a", "", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> everything = make_proxy( "", "", "" );
+    std::shared_ptr<DBus::SignalProxyBase> exact = make_proxy( "/a", "dbuscxx.test", "One" );
+
+    table.add( any_path, std::this_thread::get_id() );
+    table.add( any_member, std::this_thread::get_id() );
+    table.add( any_interface, std::this_thread::get_id() );
+    table.add( everything, std::this_thread::get_id() );
+    table.add( exact, std::this_thread::get_id() );
+
+    // Everything is found, in the order it was added
+    std::vector<std::shared_ptr<DBus::SignalProxyBase>> found = find( table, "/a", "dbuscxx.test", "One" );
+    TEST_EQUALS_RET_FAIL( found.size(), 5 );
+    TEST_ASSERT_RET_FAIL( found[ 0 ] == any_path );
+    TEST_ASSERT_RET_FAIL( found[ 1 ] == any_member );
+    TEST_ASSERT_RET_FAIL( found[ 2 ] == any_interface );
+    TEST_ASSERT_RET_FAIL( found[ 3 ] == everything );
+    TEST_ASSERT_RET_FAIL( found[ 4 ] == exact );
+
+    found = find( table, "/b", "dbuscxx.test", "Two" );
+    TEST_EQUALS_RET_FAIL( found.size(), 1 );
+    TEST_ASSERT_RET_FAIL( found[ 0 ] == everything );
+
+    return true;
+}
+
+bool signalroutingtable_threads() {
+    SignalRoutingTable table;
+    std::shared_ptr<DBus::SignalProxyBase> a = make_proxy( "/a", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> b = make_proxy( "/a", "dbuscxx.test", "" );
+    std::thread other_thread( [](){} );
+    std::thread::id other = other_thread.get_id();
+    other_thread.join();
+    std::vector<SignalRoutingTable::Route> routes;
+
+    table.add( a, std::this_thread::get_id() );
+    table.add( b, other );
+
+    table.find( "dbuscxx.test", "One", "/a", routes );
+    TEST_EQUALS_RET_FAIL( routes.size(), 2 );
+    TEST_ASSERT_RET_FAIL( routes[ 0 ].proxy == a && routes[ 0 ].thread == std::this_thread::get_id() );
+    TEST_ASSERT_RET_FAIL( routes[ 1 ].proxy == b && routes[ 1 ].thread == other );
+
+    return true;
+}
+
+bool signalroutingtable_expired() {
+    SignalRoutingTable table;
+    std::shared_ptr<DBus::SignalProxyBase> a = make_proxy( "/a", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> b = make_proxy( "/a", "dbuscxx.test", "One" );
+
+    table.add( a, std::this_thread::get_id() );
+    table.add( b, std::this_thread::get_id() );
+    a.reset();
+
+    // The table doesn't keep proxies alive
+    std::vector<std::shared_ptr<DBus::SignalProxyBase>> found = find( table, "/a", "dbuscxx.test", "One" );
+    TEST_EQUALS_RET_FAIL( found.size(), 1 );
+    TEST_ASSERT_RET_FAIL( found[ 0 ] == b );
+
+    return true;
+}
+
+bool signalroutingtable_remove() {
+    SignalRoutingTable table;
+    std::shared_ptr<DBus::SignalProxyBase> a = make_proxy( "/a", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> b = make_proxy( "/a", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> c = make_proxy( "", "", "" );
+
+    table.add( a, std::this_thread::get_id() );
+    table.add( b, std::this_thread::get_id() );
+    table.add( c, std::this_thread::get_id() );
+
+    TEST_ASSERT_RET_FAIL( table.remove( a ) );
+    TEST_ASSERT_RET_FAIL( !table.remove( a ) );
+    TEST_ASSERT_RET_FAIL( table.remove( c ) );
+    TEST_EQUALS_RET_FAIL( table.size(), 1 );
+
+    std::vector<std::shared_ptr<DBus::SignalProxyBase>> found = find( table, "/a", "dbuscxx.test", "One" );
+    TEST_EQUALS_RET_FAIL( found.size(), 1 );
+    TEST_ASSERT_RET_FAIL( found[ 0 ] == b );
+
+    // Adding it again only changes its thread
+    table.add( b, std::this_thread::get_id() );
+    TEST_EQUALS_RET_FAIL( table.size(), 1 );
+
+    return true;
+}
+
+bool signalroutingtable_update() {
+    SignalRoutingTable table;
+    std::shared_ptr<DBus::SignalProxyBase> a = make_proxy( "/a", "dbuscxx.test", "One" );
+    std::shared_ptr<DBus::SignalProxyBase> b = make_proxy( "/b", "dbuscxx.test", "One" );
+
+    table.add( a, std::this_thread::get_id() );
+    table.add( b, std::this_thread::get_id() );
+
+    a->set_path( "/b" );
+    table.update( a.get() );
+
+    TEST_ASSERT_RET_FAIL( find( table, "/a", "dbuscxx.test", "One" ).empty() );
+
+    // It keeps its place in line
+    std::vector<std::shared_ptr<DBus::SignalProxyBase>> found = find( table, "/b", "dbuscxx.test", "One" );
+    TEST_EQUALS_RET_FAIL( found.size(), 2 );
+    TEST_ASSERT_RET_FAIL( found[ 0 ] == a );
+    TEST_ASSERT_RET_FAIL( found[ 1 ] == b );
+    TEST_EQUALS_RET_FAIL( table.size(), 2 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = signalroutingtable_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( exact );
+    ADD_TEST( wildcards );
+    ADD_TEST( threads );
+    ADD_TEST( expired );
+    ADD_TEST( remove );
+    ADD_TEST( update );
+
+    return !ret;
+}
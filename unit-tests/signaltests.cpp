@@ -20,10 +20,42 @@
  ***************************************************************************/
 #include <dbus-cxx.h>
 #include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
 
 #include "test_macros.h"
 
+/* Counts the allocations made on this thread while counting is turned on */
+static thread_local bool count_allocations = false;
+static thread_local size_t num_allocations = 0;
+
+void* operator new( std::size_t size ) {
+    if( count_allocations ) {
+        num_allocations++;
+    }
+
+    void* ptr = std::malloc( size ? size : 1 );
+
+    if( !ptr ) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete( void* ptr ) noexcept {
+    std::free( ptr );
+}
+
+void operator delete( void* ptr, std::size_t ) noexcept {
+    std::free( ptr );
+}
+
 static std::shared_ptr<DBus::Dispatcher> dispatch;
 static std::string signal_value;
 static int num_rx = 0;
@@ -205,6 +237,406 @@ bool signal_remove_handler() {
     return true;
 }
 
+bool signal_arg_match() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Signal<void(std::string)>> signal = conn->create_free_signal<void(std::string)>( "/test/signal/child", "test.signal.type", "Path" );
+    std::shared_ptr<DBus::SignalProxy<void(std::string)>> proxy = conn->create_free_signal_proxy<void(std::string)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path_namespace( "/test/signal" )
+                .set_interface( "test.signal.type" )
+                .set_member( "Path" )
+                .set_arg( 0, "wanted" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( [] ( std::string value ) {
+        signal_value = value;
+        num_rx++;
+    } );
+
+    signal->emit( "unwanted" );
+    signal->emit( "wanted" );
+    sleep( 1 );
+
+    TEST_EQUALS_RET_FAIL( num_rx, 1 );
+    TEST_EQUALS_RET_FAIL( signal_value, "wanted" );
+    return true;
+}
+
+bool signal_coalesce() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Signal<void(std::string)>> signal = conn->create_free_signal<void(std::string)>( "/test/signal", "test.signal.type", "Path" );
+    std::shared_ptr<DBus::SignalProxy<void(std::string)>> proxy = conn->create_free_signal_proxy<void(std::string)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .set_interface( "test.signal.type" )
+                .set_member( "Path" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    std::atomic<int> received( 0 );
+    std::atomic<bool> got_last( false );
+    proxy->connect( [&received, &got_last] ( std::string value ) {
+        received++;
+        got_last = ( value == "99" );
+    } );
+
+    signal->set_emission_policy( DBus::EmissionMode::Coalesce, std::chrono::milliseconds( 100 ) );
+
+    for( int x = 0; x < 100; x++ ) {
+        signal->emit( std::to_string( x ) );
+    }
+
+    for( int x = 0; x < 500 && !got_last; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    // Some of the emissions were folded together, and the last value made it out
+    TEST_ASSERT_RET_FAIL( got_last );
+    TEST_ASSERT_RET_FAIL( received < 100 );
+    return true;
+}
+
+bool signal_rate_limit() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+
+    std::shared_ptr<DBus::Signal<void(std::string)>> signal = conn->create_free_signal<void(std::string)>( "/test/signal", "test.signal.type", "Path" );
+    std::shared_ptr<DBus::SignalProxy<void(std::string)>> proxy = conn->create_free_signal_proxy<void(std::string)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .set_interface( "test.signal.type" )
+                .set_member( "Path" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    std::atomic<int> received( 0 );
+    std::atomic<bool> got_last( false );
+    proxy->connect( [&received, &got_last] ( std::string value ) {
+        received++;
+        got_last = ( value == "last" );
+    } );
+
+    signal->set_emission_policy( DBus::EmissionMode::RateLimit, std::chrono::milliseconds( 100 ) );
+
+    for( int x = 0; x < 200; x++ ) {
+        signal->emit( std::to_string( x ) );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    signal->emit( "last" );
+
+    for( int x = 0; x < 500 && !got_last; x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    // Not every emission went out, but the trailing one was not held back forever
+    TEST_ASSERT_RET_FAIL( got_last );
+    TEST_ASSERT_RET_FAIL( received < 201 );
+    return true;
+}
+
+bool signal_property_coalesce() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test/signal", DBus::ThreadForCalling::DispatcherThread );
+    std::shared_ptr<DBus::Property<int32_t>> first = object->create_property<int32_t>( "test.signal.type", "first" );
+    std::shared_ptr<DBus::Property<int32_t>> second = object->create_property<int32_t>( "test.signal.type", "second" );
+    std::map<std::string, DBus::Variant> changed;
+
+    std::shared_ptr<DBus::SignalProxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>> proxy =
+        conn->create_free_signal_proxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
+                .set_member( "PropertiesChanged" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( [&changed] ( std::string, std::map<std::string,DBus::Variant> values, std::vector<std::string> ) {
+        changed = values;
+        num_rx++;
+    } );
+
+    object->interface_by_name( "test.signal.type" )->set_property_emission_policy(
+        DBus::EmissionMode::Coalesce, std::chrono::milliseconds( 100 ) );
+
+    for( int32_t x = 0; x < 100; x++ ) {
+        first->set_value( x );
+        second->set_value( x * 2 );
+    }
+
+    sleep( 1 );
+
+    // Everything that changed goes out together, with the latest values
+    TEST_EQUALS_RET_FAIL( num_rx, 1 );
+    TEST_EQUALS_RET_FAIL( changed.size(), 2 );
+    TEST_EQUALS_RET_FAIL( changed[ "first" ].to_int32(), 99 );
+    TEST_EQUALS_RET_FAIL( changed[ "second" ].to_int32(), 198 );
+    return true;
+}
+
+bool signal_property_batch() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test/signal", DBus::ThreadForCalling::DispatcherThread );
+    std::shared_ptr<DBus::Property<int32_t>> first = object->create_property<int32_t>( "test.signal.type", "first" );
+    std::shared_ptr<DBus::Property<int32_t>> second = object->create_property<int32_t>( "test.signal.type", "second" );
+    std::shared_ptr<DBus::Property<int32_t>> invalid = object->create_property<int32_t>( "test.signal.type", "invalid",
+        DBus::PropertyAccess::ReadWrite, DBus::PropertyUpdateType::Invalidates );
+    std::shared_ptr<DBus::Property<int32_t>> constant = object->create_property<int32_t>( "test.signal.type", "constant",
+        DBus::PropertyAccess::ReadOnly, DBus::PropertyUpdateType::Const );
+    std::shared_ptr<DBus::Interface> iface = object->interface_by_name( "test.signal.type" );
+    std::map<std::string, DBus::Variant> changed;
+    std::vector<std::string> invalidated;
+
+    std::shared_ptr<DBus::SignalProxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>> proxy =
+        conn->create_free_signal_proxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
+                .set_member( "PropertiesChanged" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( [&changed, &invalidated] ( std::string, std::map<std::string,DBus::Variant> values, std::vector<std::string> names ) {
+        changed = values;
+        invalidated = names;
+        num_rx++;
+    } );
+
+    {
+        DBus::PropertyBatch batch = iface->begin_property_batch();
+        first->set_value( 1 );
+        second->set_value( 2 );
+
+        {
+            // Ending a nested batch doesn't send anything
+            DBus::PropertyBatch inner = iface->begin_property_batch();
+            first->set_value( 10 );
+            invalid->set_value( 3 );
+            constant->set_value( 4 );
+        }
+    }
+
+    sleep( 1 );
+
+    TEST_EQUALS_RET_FAIL( num_rx, 1 );
+    TEST_EQUALS_RET_FAIL( changed.size(), 2 );
+    TEST_EQUALS_RET_FAIL( changed[ "first" ].to_int32(), 10 );
+    TEST_EQUALS_RET_FAIL( changed[ "second" ].to_int32(), 2 );
+    TEST_ASSERT_RET_FAIL( invalidated == std::vector<std::string>( { "invalid" } ) );
+    return true;
+}
+
+bool signal_shared_arguments() {
+    typedef std::map<std::string, DBus::Variant> Values;
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Signal<void(Values)>> signal = conn->create_free_signal<void(Values)>( "/test/signal", "test.signal.type", "Values" );
+    std::vector<std::shared_ptr<DBus::SignalProxy<void(Values)>>> proxies;
+
+    for( int x = 0; x < 3; x++ ) {
+        std::shared_ptr<DBus::SignalProxy<void(Values)>> proxy = conn->create_free_signal_proxy<void(Values)>(
+                    DBus::MatchRuleBuilder::create()
+                    .set_path( "/test/signal" )
+                    .set_interface( "test.signal.type" )
+                    .set_member( "Values" )
+                    .as_signal_match(),
+                    DBus::ThreadForCalling::DispatcherThread );
+
+        proxy->connect( [] ( Values values ) {
+            signal_value = values[ "key" ].to_string();
+            num_rx++;
+        } );
+        proxies.push_back( proxy );
+    }
+
+    Values values;
+    values[ "key" ] = DBus::Variant( std::string( "value" ) );
+    signal->emit( values );
+    sleep( 1 );
+
+    TEST_EQUALS_RET_FAIL( num_rx, 3 );
+    TEST_EQUALS_RET_FAIL( signal_value, "value" );
+
+    // The arguments are only decoded the first time they are asked for
+    std::shared_ptr<DBus::SignalMessage> msg = DBus::SignalMessage::create( "/test/signal", "test.signal.type", "Values" );
+    int decoded = 0;
+    msg << std::string( "value" );
+
+    std::function<void( std::string& )> decode = [&msg, &decoded]( std::string& value ) {
+        msg->begin() >> value;
+        decoded++;
+    };
+    std::shared_ptr<const std::string> first = msg->decoded_arguments<std::string>( decode );
+    std::shared_ptr<const std::string> second = msg->decoded_arguments<std::string>( decode );
+
+    TEST_EQUALS_RET_FAIL( decoded, 1 );
+    TEST_ASSERT_RET_FAIL( first == second );
+    TEST_EQUALS_RET_FAIL( *first, "value" );
+    return true;
+}
+
+bool signal_shared_file_descriptors() {
+    typedef std::vector<std::shared_ptr<DBus::FileDescriptor>> Descriptors;
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Signal<void(Descriptors)>> signal = conn->create_free_signal<void(Descriptors)>( "/test/signal", "test.signal.type", "Descriptors" );
+    std::vector<std::shared_ptr<DBus::SignalProxy<void(Descriptors)>>> proxies;
+    std::mutex lock;
+    std::vector<int> received;
+    int pipes[ 2 ];
+
+    for( int x = 0; x < 2; x++ ) {
+        std::shared_ptr<DBus::SignalProxy<void(Descriptors)>> proxy = conn->create_free_signal_proxy<void(Descriptors)>(
+                    DBus::MatchRuleBuilder::create()
+                    .set_path( "/test/signal" )
+                    .set_interface( "test.signal.type" )
+                    .set_member( "Descriptors" )
+                    .as_signal_match(),
+                    DBus::ThreadForCalling::DispatcherThread );
+
+        proxy->connect( [&lock, &received] ( Descriptors fds ) {
+            std::unique_lock<std::mutex> guard( lock );
+
+            for( std::shared_ptr<DBus::FileDescriptor> fd : fds ) {
+                received.push_back( fd->descriptor() );
+            }
+        } );
+        proxies.push_back( proxy );
+    }
+
+    TEST_ASSERT_RET_FAIL( pipe( pipes ) == 0 );
+    signal->emit( Descriptors{ DBus::FileDescriptor::create( pipes[ 0 ] ) } );
+    sleep( 1 );
+
+    std::unique_lock<std::mutex> guard( lock );
+
+    // A descriptor inside of a container is still not shared between handlers
+    TEST_EQUALS_RET_FAIL( received.size(), 2 );
+    TEST_ASSERT_RET_FAIL( received[ 0 ] != received[ 1 ] );
+
+    for( int fd : received ) {
+        close( fd );
+    }
+
+    close( pipes[ 0 ] );
+    close( pipes[ 1 ] );
+    return true;
+}
+
+bool signal_multicast() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Signal<void(std::string)>> signal = conn->create_free_signal<void(std::string)>( "/test/signal", "test.signal.type", "Multicast" );
+    std::vector<std::shared_ptr<DBus::Connection>> receivers;
+    std::vector<std::shared_ptr<DBus::SignalProxy<void(std::string)>>> proxies;
+    std::vector<std::string> destinations;
+    int local_rx = 0;
+
+    for( int x = 0; x < 3; x++ ) {
+        std::shared_ptr<DBus::Connection> receiver = dispatch->create_connection( DBus::BusType::SESSION );
+        std::shared_ptr<DBus::SignalProxy<void(std::string)>> proxy = receiver->create_free_signal_proxy<void(std::string)>(
+                    DBus::MatchRuleBuilder::create()
+                    .set_path( "/test/signal" )
+                    .set_interface( "test.signal.type" )
+                    .set_member( "Multicast" )
+                    .as_signal_match(),
+                    DBus::ThreadForCalling::DispatcherThread );
+
+        proxy->connect( [] ( std::string value ) {
+            signal_value = value;
+            num_rx++;
+        } );
+
+        receivers.push_back( receiver );
+        proxies.push_back( proxy );
+
+        // The last receiver isn't sent the signal
+        if( x < 2 ) {
+            destinations.push_back( receiver->unique_name() );
+        }
+    }
+
+    signal->connect( [&local_rx] ( std::string ) {
+        local_rx++;
+    } );
+
+    sleep( 1 );
+    TEST_ASSERT_RET_FAIL( signal->emit_to( destinations, "multicast" ) );
+    sleep( 1 );
+
+    TEST_EQUALS_RET_FAIL( num_rx, 2 );
+    TEST_EQUALS_RET_FAIL( signal_value, "multicast" );
+    TEST_EQUALS_RET_FAIL( local_rx, 0 );
+    TEST_ASSERT_RET_FAIL( !signal->emit_to( { "not a bus name" }, "multicast" ) );
+
+    // Each copy is its own message with the same arguments
+    std::shared_ptr<DBus::SignalMessage> msg = DBus::SignalMessage::create( "/test/signal", "test.signal.type", "Multicast" );
+    msg << std::string( "value" ) << int32_t( 5 );
+    std::shared_ptr<DBus::SignalMessage> copy = msg->copy_to( "org.example.Client" );
+    std::string value;
+    int32_t number = 0;
+
+    TEST_ASSERT_RET_FAIL( copy );
+    TEST_EQUALS_RET_FAIL( copy->destination(), "org.example.Client" );
+    TEST_EQUALS_RET_FAIL( msg->destination(), "" );
+    TEST_EQUALS_RET_FAIL( copy->member(), "Multicast" );
+    TEST_EQUALS_RET_FAIL( copy->signature(), "si" );
+    copy->begin() >> value >> number;
+    TEST_EQUALS_RET_FAIL( value, "value" );
+    TEST_EQUALS_RET_FAIL( number, 5 );
+    TEST_ASSERT_RET_FAIL( !msg->copy_to( "not a bus name" ) );
+    return true;
+}
+
+/* Lets us hand a message straight to the proxy */
+class ScalarSignalProxy : public DBus::SignalProxy<void(int32_t, double)> {
+public:
+    ScalarSignalProxy() :
+        DBus::SignalProxy<void(int32_t, double)>(
+            DBus::MatchRuleBuilder::create()
+            .set_member( "Scalars" )
+            .as_signal_match() ) {}
+
+    using DBus::SignalProxy<void(int32_t, double)>::on_dbus_incoming;
+};
+
+bool signal_scalar_allocations() {
+    std::shared_ptr<DBus::SignalMessage> msg = DBus::SignalMessage::create( "/test/signal", "test.signal.type", "Scalars" );
+    std::shared_ptr<DBus::SignalMessage> msg2 = DBus::SignalMessage::create( "/test/signal", "test.signal.type", "Scalars" );
+    ScalarSignalProxy proxy;
+    int32_t intValue = 0;
+    double doubleValue = 0;
+    size_t decodeAllocations;
+    size_t emitAllocations;
+
+    // Don't count what the logger does
+    DBus::set_log_level( SL_WARN );
+
+    msg << int32_t( 42 ) << 2.5;
+    msg2 << int32_t( 42 ) << 2.5;
+    proxy.connect( [&intValue, &doubleValue]( int32_t i, double d ) {
+        intValue = i;
+        doubleValue = d;
+    } );
+
+    proxy.on_dbus_incoming( msg );
+    TEST_EQUALS_RET_FAIL( intValue, 42 );
+    TEST_EQUALS_RET_FAIL( doubleValue, 2.5 );
+
+    // A message that has not been decoded yet, so nothing is cached on it
+    count_allocations = true;
+    num_allocations = 0;
+    proxy.on_dbus_incoming( msg2 );
+    decodeAllocations = num_allocations;
+
+    num_allocations = 0;
+    proxy.emit( 42, 2.5 );
+    emitAllocations = num_allocations;
+    count_allocations = false;
+
+    // Decoding the arguments takes no allocations beyond the emission itself
+    TEST_EQUALS_RET_FAIL( decodeAllocations, emitAllocations );
+    return true;
+}
+
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
             ret = signal_##name();\
         } \
@@ -231,6 +663,15 @@ int main( int argc, char** argv ) {
     ADD_TEST( member_match_only );
     ADD_TEST( multiple_handlers );
     ADD_TEST( remove_handler );
+    ADD_TEST( arg_match );
+    ADD_TEST( coalesce );
+    ADD_TEST( rate_limit );
+    ADD_TEST( property_coalesce );
+    ADD_TEST( property_batch );
+    ADD_TEST( shared_arguments );
+    ADD_TEST( shared_file_descriptors );
+    ADD_TEST( multicast );
+    ADD_TEST( scalar_allocations );
 
     return !ret;
 }
@@ -0,0 +1,281 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "test_macros.h"
+
+static std::shared_ptr<DBus::Dispatcher> dispatch;
+static std::shared_ptr<DBus::Server> server;
+static std::shared_ptr<DBus::Connection> server_conn;
+static std::shared_ptr<DBus::Object> object;
+
+static std::promise<void> release_hang;
+
+int add( int a, int b ) {
+    return a + b;
+}
+
+/**
+ * Don't answer until the test tells us to.
+ */
+void hang() {
+    release_hang.get_future().wait_for( std::chrono::seconds( 5 ) );
+}
+
+/**
+ * Start listening on the given address, and accept one client in the background.
+ */
+static std::future<void> start_server( std::string address, bool allow_anonymous = false ) {
+    server = DBus::Server::create( address, allow_anonymous );
+
+    return std::async( std::launch::async, []() {
+        if( !server->is_valid() ) {
+            return;
+        }
+
+        server_conn = server->accept( 5000 );
+
+        if( !server_conn ) {
+            return;
+        }
+
+        dispatch->add_connection( server_conn );
+
+        object = server_conn->create_object( "/tcptest", DBus::ThreadForCalling::DispatcherThread );
+        object->create_method<int( int, int )>( "dbuscxx.tcp", "add", sigc::ptr_fun( add ) );
+        object->create_method<void()>( "dbuscxx.tcp", "hang", sigc::ptr_fun( hang ) );
+    } );
+}
+
+static bool call_add( std::shared_ptr<DBus::Connection> conn ) {
+    dispatch->add_connection( conn );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "/tcptest" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> add_proxy =
+        proxy->create_method<int( int, int )>( "dbuscxx.tcp", "add" );
+
+    int result = ( *add_proxy )( 5, 6 );
+
+    TEST_EQUALS_RET_FAIL( result, 11 );
+    return true;
+}
+
+bool tcp_method_call() {
+    std::future<void> server_done = start_server( "tcp:host=127.0.0.1,port=0", true );
+    TEST_ASSERT_RET_FAIL( server->is_valid() );
+
+    // The real port was filled in for us
+    TEST_ASSERT_RET_FAIL( server->address().find( "port=0," ) == std::string::npos );
+
+    // Child processes don't get our sockets
+    TEST_ASSERT_RET_FAIL( fcntl( server->fd(), F_GETFD ) & FD_CLOEXEC );
+
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_peer( server->address() );
+    server_done.wait();
+
+    TEST_ASSERT_RET_FAIL( conn && conn->is_valid() );
+    TEST_ASSERT_RET_FAIL( server_conn );
+
+    int nodelay = 0;
+    socklen_t len = sizeof( nodelay );
+    TEST_ASSERT_RET_FAIL( getsockopt( conn->unix_fd(), IPPROTO_TCP, TCP_NODELAY, &nodelay, &len ) == 0 );
+    TEST_ASSERT_RET_FAIL( nodelay != 0 );
+    TEST_ASSERT_RET_FAIL( fcntl( server_conn->unix_fd(), F_GETFD ) & FD_CLOEXEC );
+
+    return call_add( conn );
+}
+
+bool tcp_anonymous_not_allowed() {
+    // Anybody could connect to this, so we must be asked for that
+    server = DBus::Server::create( "tcp:host=127.0.0.1,port=0" );
+    TEST_ASSERT_RET_FAIL( !server->is_valid() );
+
+    return true;
+}
+
+bool tcp_buffer_sizes() {
+    std::future<void> server_done = start_server( "tcp:host=127.0.0.1,port=0", true );
+    TEST_ASSERT_RET_FAIL( server->is_valid() );
+
+    std::shared_ptr<DBus::Connection> conn =
+        DBus::Connection::create_peer( server->address() + ",sndbuf=65536,rcvbuf=65536" );
+    server_done.wait();
+
+    TEST_ASSERT_RET_FAIL( conn && conn->is_valid() );
+
+    // Linux doubles the value that we ask for, to leave room for bookkeeping
+    int size = 0;
+    socklen_t len = sizeof( size );
+    TEST_ASSERT_RET_FAIL( getsockopt( conn->unix_fd(), SOL_SOCKET, SO_SNDBUF, &size, &len ) == 0 );
+    TEST_ASSERT_RET_FAIL( size >= 65536 );
+    TEST_ASSERT_RET_FAIL( getsockopt( conn->unix_fd(), SOL_SOCKET, SO_RCVBUF, &size, &len ) == 0 );
+    TEST_ASSERT_RET_FAIL( size >= 65536 );
+
+    return call_add( conn );
+}
+
+bool tcp_nonce_method_call() {
+    std::future<void> server_done = start_server( "nonce-tcp:host=127.0.0.1" );
+    TEST_ASSERT_RET_FAIL( server->is_valid() );
+    TEST_ASSERT_RET_FAIL( server->address().find( "noncefile=" ) != std::string::npos );
+
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_peer( server->address() );
+    server_done.wait();
+
+    TEST_ASSERT_RET_FAIL( conn && conn->is_valid() );
+    TEST_ASSERT_RET_FAIL( server_conn );
+
+    return call_add( conn );
+}
+
+bool tcp_nonce_bad_nonce() {
+    std::future<void> server_done = start_server( "nonce-tcp:host=127.0.0.1" );
+    TEST_ASSERT_RET_FAIL( server->is_valid() );
+
+    std::string address = server->address();
+    size_t start = address.find( "noncefile=" ) + strlen( "noncefile=" );
+    std::string noncefile = address.substr( start, address.find( ',', start ) - start );
+
+    // Point the client at a nonce that is the right length, but wrong
+    std::string badNonceFile = noncefile + "-bad";
+    std::ofstream( badNonceFile ) << "0123456789abcdef";
+    address.replace( start, noncefile.size(), badNonceFile );
+
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_peer( address );
+    server_done.wait();
+    unlink( badNonceFile.c_str() );
+
+    TEST_ASSERT_RET_FAIL( !server_conn );
+    TEST_ASSERT_RET_FAIL( !conn || !conn->is_valid() );
+
+    return true;
+}
+
+/**
+ * Close the server's end of the connection, and wait for the client to notice.
+ */
+static bool kill_server_conn( std::shared_ptr<DBus::Connection> conn ) {
+    shutdown( server_conn->unix_fd(), SHUT_RDWR );
+
+    for( int x = 0; x < 50 && conn->is_valid(); x++ ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+    }
+
+    return !conn->is_valid();
+}
+
+bool tcp_call_async_disconnected() {
+    std::future<void> server_done = start_server( "tcp:host=127.0.0.1,port=0", true );
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_peer( server->address() );
+    server_done.wait();
+
+    TEST_ASSERT_RET_FAIL( conn && conn->is_valid() );
+    TEST_ASSERT_RET_FAIL( server_conn );
+    dispatch->add_connection( conn );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "/tcptest" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> add_proxy =
+        proxy->create_method<int( int, int )>( "dbuscxx.tcp", "add" );
+    std::shared_ptr<DBus::MethodProxy<void( int, int )>> void_proxy =
+        proxy->create_method<void( int, int )>( "dbuscxx.tcp", "add" );
+
+    TEST_ASSERT_RET_FAIL( kill_server_conn( conn ) );
+
+    // The error comes through the future, not out of call_async
+    std::future<int> result = add_proxy->call_async( 5, 6 );
+    std::future<void> void_result = void_proxy->call_async( 5, 6 );
+
+    try {
+        result.get();
+        return false;
+    } catch( const DBus::ErrorDisconnected& ) {}
+
+    try {
+        void_result.get();
+        return false;
+    } catch( const DBus::ErrorDisconnected& ) {}
+
+    return true;
+}
+
+bool tcp_disconnect_outstanding_call() {
+    std::future<void> server_done = start_server( "tcp:host=127.0.0.1,port=0", true );
+    std::shared_ptr<DBus::Connection> conn = DBus::Connection::create_peer( server->address() );
+    server_done.wait();
+
+    TEST_ASSERT_RET_FAIL( conn && conn->is_valid() );
+    TEST_ASSERT_RET_FAIL( server_conn );
+
+    // The server's dispatcher is going to be stuck in hang(), so the client needs its own
+    std::shared_ptr<DBus::Dispatcher> client_dispatch = DBus::StandaloneDispatcher::create();
+    client_dispatch->add_connection( conn );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "/tcptest" );
+    std::shared_ptr<DBus::MethodProxy<void()>> hang_proxy =
+        proxy->create_method<void()>( "dbuscxx.tcp", "hang" );
+
+    std::future<void> result = hang_proxy->call_async();
+    std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    TEST_ASSERT_RET_FAIL( result.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::timeout );
+
+    TEST_ASSERT_RET_FAIL( kill_server_conn( conn ) );
+
+    // The call fails as soon as the connection goes away, not when it times out
+    bool ok = result.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready;
+    release_hang.set_value();
+    TEST_ASSERT_RET_FAIL( ok );
+
+    try {
+        result.get();
+        return false;
+    } catch( const DBus::ErrorDisconnected& ) {}
+
+    // Nothing is left to wake up for
+    TEST_EQUALS_RET_FAIL( conn->next_timeout_milliseconds(), -1 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = tcp_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+    dispatch = DBus::StandaloneDispatcher::create();
+
+    ADD_TEST( method_call );
+    ADD_TEST( anonymous_not_allowed );
+    ADD_TEST( buffer_sizes );
+    ADD_TEST( nonce_method_call );
+    ADD_TEST( nonce_bad_nonce );
+    ADD_TEST( call_async_disconnected );
+    ADD_TEST( disconnect_outstanding_call );
+
+    return !ret;
+}
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2020 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx/timerwheel.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "test_macros.h"
+
+using DBus::priv::TimerWheel;
+
+bool timerwheel_expire() {
+    TimerWheel wheel( std::chrono::milliseconds( 10 ), 16 );
+    TimerWheel::TimePoint now = std::chrono::steady_clock::now();
+
+    wheel.add( 1, now + std::chrono::milliseconds( 25 ) );
+    wheel.add( 2, now + std::chrono::milliseconds( 55 ) );
+    wheel.add( 3, now + std::chrono::milliseconds( 25 ) );
+    TEST_EQUALS_RET_FAIL( wheel.size(), 3 );
+
+    // Nothing expires early
+    TEST_ASSERT_RET_FAIL( wheel.expire( now + std::chrono::milliseconds( 20 ) ).empty() );
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() <= now + std::chrono::milliseconds( 35 ) );
+
+    std::vector<uint32_t> expired = wheel.expire( now + std::chrono::milliseconds( 40 ) );
+    std::sort( expired.begin(), expired.end() );
+    TEST_ASSERT_RET_FAIL( expired == std::vector<uint32_t>( { 1, 3 } ) );
+    TEST_EQUALS_RET_FAIL( wheel.size(), 1 );
+
+    expired = wheel.expire( now + std::chrono::milliseconds( 70 ) );
+    TEST_ASSERT_RET_FAIL( expired == std::vector<uint32_t>( { 2 } ) );
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() == TimerWheel::TimePoint::max() );
+
+    return true;
+}
+
+bool timerwheel_remove() {
+    TimerWheel wheel( std::chrono::milliseconds( 10 ), 16 );
+    TimerWheel::TimePoint now = std::chrono::steady_clock::now();
+    TimerWheel::TimePoint deadline = now + std::chrono::milliseconds( 30 );
+
+    wheel.add( 7, deadline );
+    TEST_ASSERT_RET_FAIL( wheel.remove( 7, deadline ) );
+    TEST_ASSERT_RET_FAIL( !wheel.remove( 7, deadline ) );
+    TEST_EQUALS_RET_FAIL( wheel.size(), 0 );
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() == TimerWheel::TimePoint::max() );
+    TEST_ASSERT_RET_FAIL( wheel.expire( now + std::chrono::milliseconds( 100 ) ).empty() );
+
+    return true;
+}
+
+bool timerwheel_long_timeout() {
+    // 16 slots of 10ms go around in 160ms, so this has to survive going around a few times
+    TimerWheel wheel( std::chrono::milliseconds( 10 ), 16 );
+    TimerWheel::TimePoint now = std::chrono::steady_clock::now();
+
+    wheel.add( 1, now + std::chrono::milliseconds( 500 ) );
+    wheel.add( 2, now + std::chrono::milliseconds( 15 ) );
+
+    TEST_ASSERT_RET_FAIL( wheel.expire( now + std::chrono::milliseconds( 30 ) ) == std::vector<uint32_t>( { 2 } ) );
+
+    for( int ms = 100; ms < 500; ms += 100 ) {
+        TEST_ASSERT_RET_FAIL( wheel.expire( now + std::chrono::milliseconds( ms ) ).empty() );
+        TEST_ASSERT_RET_FAIL( wheel.next_expiry() <= now + std::chrono::milliseconds( 510 ) );
+    }
+
+    TEST_ASSERT_RET_FAIL( wheel.expire( now + std::chrono::milliseconds( 520 ) ) == std::vector<uint32_t>( { 1 } ) );
+    TEST_EQUALS_RET_FAIL( wheel.size(), 0 );
+
+    return true;
+}
+
+bool timerwheel_past_deadline() {
+    TimerWheel wheel( std::chrono::milliseconds( 10 ), 16 );
+    TimerWheel::TimePoint now = std::chrono::steady_clock::now();
+
+    wheel.expire( now + std::chrono::milliseconds( 100 ) );
+
+    // Something that is already late expires on the very next check
+    wheel.add( 4, now );
+    TEST_ASSERT_RET_FAIL( wheel.expire( now + std::chrono::milliseconds( 115 ) ) == std::vector<uint32_t>( { 4 } ) );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = timerwheel_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( expire );
+    ADD_TEST( remove );
+    ADD_TEST( long_timeout );
+    ADD_TEST( past_deadline );
+
+    return !ret;
+}